@@ -0,0 +1,34 @@
+# Automatically generated by configure - do not modify!
+PREFIX=/usr/local
+prefix=$(DESTDIR)$(PREFIX)
+bindir=$(DESTDIR)${PREFIX}/bin
+libdir=$(DESTDIR)${PREFIX}/lib
+includedir=$(DESTDIR)${PREFIX}/include
+docdir=$(DESTDIR)${PREFIX}/share/doc
+mandir=$(DESTDIR)${PREFIX}/share/man
+MAKE=make
+CC=gcc
+AR=ar
+RANLIB=ranlib
+LN=ln
+BUILD_STATIC=yes
+BUILD_SHARED=yes
+BUILD_DYLIB=no
+BUILD_MINGW32=no
+VERSION=2.0.2
+STRIP=strip
+INSTALLSTRIP=-s
+EXTRALIBS=-lm -lpthread -lxcb
+CFG_CPPFLAGS=-DPIC -D_LARGEFILE_SOURCE -D_FILE_OFFSET_BITS=64 -D_REENTRANT -DHAVE_COPY_FILE_RANGE -DHAVE_MEMFD_CREATE -DHAVE_SIMD_X86 -DHAVE_DEBUG -DHAVE_MPLAYER -DHAVE_WIN_XCB -DUSE_LOGCOLOR
+OPTFLAGS=-fPIC -W -Wall -g -O2
+CFG_LDFLAGS=
+INSTALL=install
+DEBUG=yes
+WRAPPER_XINE=no
+WRAPPER_MPLAYER=yes
+WRAPPER_VLC=no
+WRAPPER_GSTREAMER=no
+BINDING_PYTHON=no
+WIN_XCB=yes
+XLIB_HACK=no
+DOC=no
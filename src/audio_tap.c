@@ -0,0 +1,348 @@
+/*
+ * GeeXboX libplayer: a multimedia A/V abstraction layer API.
+ * Copyright (C) 2010 Mathieu Schroeter <mathieu@schroetersa.ch>
+ *
+ * This file is part of libplayer.
+ *
+ * libplayer is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * libplayer is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with libplayer; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/*
+ * The audio tap gives the decoded PCM blocks to the frontend and computes
+ * the audio meters. The peak and the sum of the squares of each channel
+ * are accumulated over a period, then the levels are published.
+ *
+ * The accumulation uses SSE2 or AVX2 when the CPU supports it (selected at
+ * runtime). The vector versions need a number of channels dividing the
+ * number of lanes (1, 2, 4 or 8), the other layouts use the C version.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+#include <math.h>
+
+#ifdef HAVE_SIMD_X86
+#include <immintrin.h>
+#endif /* HAVE_SIMD_X86 */
+
+#include "player.h"
+#include "player_internals.h"
+#include "logs.h"
+#include "audio_tap.h"
+
+#define MODULE_NAME "audio_tap"
+
+#define METER_INTERVAL_DEF  50    /* ms */
+#define METER_CHUNK         4096  /* max samples accumulated in float */
+
+typedef void (*meter_func_t) (const int16_t *pcm, size_t samples,
+                              int channels, int32_t *peak, double *sum);
+
+struct audio_tap_s {
+  player_t *player;
+  void (*audio_cb) (const player_audio_t *audio, void *data);
+  void (*meter_cb) (const player_audio_meter_t *meter, void *data);
+  void *data;
+
+  int interval;             /* ms */
+  meter_func_t meter;       /* C, SSE2 or AVX2 */
+
+  /* accumulated since the last meters */
+  int channels;
+  int rate;
+  int frames;
+  int32_t peak[PLAYER_AUDIO_METER_CHANNELS];
+  double sum[PLAYER_AUDIO_METER_CHANNELS];
+};
+
+
+static void
+meter_c (const int16_t *pcm, size_t samples,
+         int channels, int32_t *peak, double *sum)
+{
+  size_t i;
+  int ch = 0;
+
+  for (i = 0; i < samples; i++)
+  {
+    int32_t v = pcm[i];
+    int32_t a = v < 0 ? -v : v;
+
+    if (a > peak[ch])
+      peak[ch] = a;
+    sum[ch] += (double) (v * v);
+
+    if (++ch == channels)
+      ch = 0;
+  }
+}
+
+#ifdef HAVE_SIMD_X86
+/* the lane l of the vectors is always the channel l % channels */
+static void
+meter_lanes (const int16_t *max, const int16_t *min, const float *sq,
+             int lanes, int channels, int32_t *peak, double *sum)
+{
+  int l;
+
+  for (l = 0; l < lanes; l++)
+  {
+    int ch = l % channels;
+    int32_t a = max[l] > -min[l] ? max[l] : -min[l];
+
+    if (a > peak[ch])
+      peak[ch] = a;
+    sum[ch] += sq[l];
+  }
+}
+
+__attribute__ ((target ("sse2")))
+static void
+meter_sse2 (const int16_t *pcm, size_t samples,
+            int channels, int32_t *peak, double *sum)
+{
+  __m128i vmax = _mm_setzero_si128 ();
+  __m128i vmin = _mm_setzero_si128 ();
+  __m128 acc0 = _mm_setzero_ps ();
+  __m128 acc1 = _mm_setzero_ps ();
+  int16_t max[8], min[8];
+  float sq[8];
+  size_t i, n = samples & ~(size_t) 7;
+
+  for (i = 0; i < n; i += 8)
+  {
+    __m128i x = _mm_loadu_si128 ((const __m128i *) (pcm + i));
+    __m128 lo, hi;
+
+    vmax = _mm_max_epi16 (vmax, x);
+    vmin = _mm_min_epi16 (vmin, x);
+
+    /* sign extension to 32 bits */
+    lo = _mm_cvtepi32_ps (_mm_srai_epi32 (_mm_unpacklo_epi16 (x, x), 16));
+    hi = _mm_cvtepi32_ps (_mm_srai_epi32 (_mm_unpackhi_epi16 (x, x), 16));
+    acc0 = _mm_add_ps (acc0, _mm_mul_ps (lo, lo));
+    acc1 = _mm_add_ps (acc1, _mm_mul_ps (hi, hi));
+  }
+
+  _mm_storeu_si128 ((__m128i *) max, vmax);
+  _mm_storeu_si128 ((__m128i *) min, vmin);
+  _mm_storeu_ps (sq, acc0);
+  _mm_storeu_ps (sq + 4, acc1);
+
+  meter_lanes (max, min, sq, 8, channels, peak, sum);
+  meter_c (pcm + n, samples - n, channels, peak, sum);
+}
+
+__attribute__ ((target ("avx2")))
+static void
+meter_avx2 (const int16_t *pcm, size_t samples,
+            int channels, int32_t *peak, double *sum)
+{
+  __m256i vmax = _mm256_setzero_si256 ();
+  __m256i vmin = _mm256_setzero_si256 ();
+  __m256 acc0 = _mm256_setzero_ps ();
+  __m256 acc1 = _mm256_setzero_ps ();
+  int16_t max[16], min[16];
+  float sq[16];
+  size_t i, n = samples & ~(size_t) 15;
+
+  for (i = 0; i < n; i += 16)
+  {
+    __m256i x = _mm256_loadu_si256 ((const __m256i *) (pcm + i));
+    __m256 lo, hi;
+
+    vmax = _mm256_max_epi16 (vmax, x);
+    vmin = _mm256_min_epi16 (vmin, x);
+
+    lo = _mm256_cvtepi32_ps (
+           _mm256_cvtepi16_epi32 (_mm256_castsi256_si128 (x)));
+    hi = _mm256_cvtepi32_ps (
+           _mm256_cvtepi16_epi32 (_mm256_extracti128_si256 (x, 1)));
+    acc0 = _mm256_add_ps (acc0, _mm256_mul_ps (lo, lo));
+    acc1 = _mm256_add_ps (acc1, _mm256_mul_ps (hi, hi));
+  }
+
+  _mm256_storeu_si256 ((__m256i *) max, vmax);
+  _mm256_storeu_si256 ((__m256i *) min, vmin);
+  _mm256_storeu_ps (sq, acc0);
+  _mm256_storeu_ps (sq + 8, acc1);
+
+  meter_lanes (max, min, sq, 16, channels, peak, sum);
+  meter_c (pcm + n, samples - n, channels, peak, sum);
+}
+#endif /* HAVE_SIMD_X86 */
+
+static meter_func_t
+meter_select (player_t *player)
+{
+#ifdef HAVE_SIMD_X86
+  __builtin_cpu_init ();
+
+  if (__builtin_cpu_supports ("avx2"))
+  {
+    pl_log (player, PLAYER_MSG_INFO, MODULE_NAME, "AVX2 audio meters");
+    return meter_avx2;
+  }
+
+  if (__builtin_cpu_supports ("sse2"))
+  {
+    pl_log (player, PLAYER_MSG_INFO, MODULE_NAME, "SSE2 audio meters");
+    return meter_sse2;
+  }
+#endif /* HAVE_SIMD_X86 */
+
+  pl_log (player, PLAYER_MSG_INFO, MODULE_NAME, "C audio meters");
+  return meter_c;
+}
+
+static void
+tap_meter_reset (audio_tap_t *tap, int channels, int rate)
+{
+  tap->channels = channels;
+  tap->rate     = rate;
+  tap->frames   = 0;
+  memset (tap->peak, 0, sizeof (tap->peak));
+  memset (tap->sum, 0, sizeof (tap->sum));
+}
+
+static void
+tap_meter_publish (audio_tap_t *tap, int64_t pts)
+{
+  player_audio_meter_t meter;
+  int i;
+
+  memset (&meter, 0, sizeof (meter));
+  meter.channels = tap->channels < PLAYER_AUDIO_METER_CHANNELS
+                   ? tap->channels : PLAYER_AUDIO_METER_CHANNELS;
+  meter.pts = pts;
+
+  for (i = 0; i < meter.channels; i++)
+  {
+    meter.peak[i] = tap->peak[i] / 32768.0f;
+    meter.rms[i]  = sqrt (tap->sum[i] / tap->frames) / 32768.0;
+  }
+
+  tap->meter_cb (&meter, tap->data);
+  tap_meter_reset (tap, tap->channels, tap->rate);
+}
+
+static void
+tap_meter (audio_tap_t *tap, const int16_t *pcm, int frames,
+           int channels, int rate, int64_t pts)
+{
+  meter_func_t meter = tap->meter;
+  int period, chunk, done = 0;
+
+  if (channels != tap->channels || rate != tap->rate)
+    tap_meter_reset (tap, channels, rate);
+
+  /* the vectors need channels dividing their number of lanes */
+  if (channels != 1 && channels != 2 && channels != 4 && channels != 8)
+    meter = meter_c;
+
+  period = (int) ((int64_t) rate * tap->interval / 1000);
+  if (period <= 0)
+    period = 1;
+
+  /* the float accumulators of the vectors are flushed regularly */
+  chunk = METER_CHUNK / channels;
+  if (chunk <= 0)
+    chunk = 1;
+
+  while (done < frames)
+  {
+    int n = frames - done;
+
+    if (n > period - tap->frames)
+      n = period - tap->frames;
+    if (n > chunk)
+      n = chunk;
+
+    /* the channels after the last meter are accumulated but not used */
+    if (channels <= PLAYER_AUDIO_METER_CHANNELS)
+      meter (pcm + (size_t) done * channels, (size_t) n * channels,
+             channels, tap->peak, tap->sum);
+    else
+    {
+      int i;
+
+      for (i = 0; i < n; i++)
+        meter_c (pcm + (size_t) (done + i) * channels,
+                 PLAYER_AUDIO_METER_CHANNELS, channels, tap->peak, tap->sum);
+    }
+
+    done += n;
+    tap->frames += n;
+
+    if (tap->frames >= period)
+      tap_meter_publish (tap, pts < 0 ? -1
+                              : pts + (int64_t) done * 1000 / rate);
+  }
+}
+
+void
+pl_audio_tap_push (audio_tap_t *tap, const int16_t *pcm, int frames,
+                   int channels, int rate, int64_t pts)
+{
+  if (!tap || !pcm || frames <= 0 || channels <= 0 || rate <= 0)
+    return;
+
+  if (tap->audio_cb)
+  {
+    player_audio_t audio;
+
+    audio.pcm      = pcm;
+    audio.frames   = frames;
+    audio.channels = channels;
+    audio.rate     = rate;
+    audio.pts      = pts;
+    tap->audio_cb (&audio, tap->data);
+  }
+
+  if (tap->meter_cb)
+    tap_meter (tap, pcm, frames, channels, rate, pts);
+}
+
+audio_tap_t *
+pl_audio_tap_new (player_t *player)
+{
+  audio_tap_t *tap;
+
+  if (!player)
+    return NULL;
+
+  tap = PCALLOC (audio_tap_t, 1);
+  if (!tap)
+    return NULL;
+
+  tap->player   = player;
+  tap->audio_cb = player->audio_cb;
+  tap->meter_cb = player->audio_meter_cb;
+  tap->data     = player->user_data;
+  tap->interval = player->audio_meter_interval > 0
+                  ? player->audio_meter_interval : METER_INTERVAL_DEF;
+
+  if (tap->meter_cb)
+    tap->meter = meter_select (player);
+
+  return tap;
+}
+
+void
+pl_audio_tap_free (audio_tap_t *tap)
+{
+  PFREE (tap);
+}
@@ -0,0 +1,34 @@
+/*
+ * GeeXboX libplayer: a multimedia A/V abstraction layer API.
+ * Copyright (C) 2010 Mathieu Schroeter <mathieu@schroetersa.ch>
+ *
+ * This file is part of libplayer.
+ *
+ * libplayer is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * libplayer is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with libplayer; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#ifndef AUDIO_TAP_H
+#define AUDIO_TAP_H
+
+typedef struct audio_tap_s audio_tap_t;
+
+audio_tap_t *pl_audio_tap_new (player_t *player);
+void pl_audio_tap_free (audio_tap_t *tap);
+
+/* interleaved signed 16 bits samples, always from the same thread */
+void pl_audio_tap_push (audio_tap_t *tap, const int16_t *pcm, int frames,
+                        int channels, int rate, int64_t pts);
+
+#endif /* AUDIO_TAP_H */
@@ -0,0 +1,457 @@
+/*
+ * GeeXboX libplayer: a multimedia A/V abstraction layer API.
+ * Copyright (C) 2010 Mathieu Schroeter <mathieu@schroetersa.ch>
+ *
+ * This file is part of libplayer.
+ *
+ * libplayer is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * libplayer is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with libplayer; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/*
+ * The frame ring is a fixed set of buffers mapped in shared memory. The
+ * wrapper (decoder side) writes a frame in a free buffer and publishes it,
+ * a dedicated thread gives the frames to the frontend callback in order.
+ * Only the descriptors are passed around, the pixels are never copied.
+ *
+ * Each buffer is a memfd, then the frontend can give it to an other process
+ * which maps the same pages.
+ *
+ * The decoder is never blocked by the callback: when no buffer is free,
+ * the frame is dropped and its sequence number is lost.
+ */
+
+#define _GNU_SOURCE /* memfd_create */
+
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/mman.h>
+
+#include "player.h"
+#include "player_internals.h"
+#include "logs.h"
+#include "frame_ring.h"
+
+#define MODULE_NAME "frame_ring"
+
+#define FRAME_RING_DEF  4
+#define FRAME_RING_MAX  64
+
+typedef enum slot_state {
+  SLOT_FREE,
+  SLOT_WRITE,               /* owned by the wrapper */
+  SLOT_READY,               /* published, waiting for the callback */
+  SLOT_READ,                /* in the callback */
+} slot_state_t;
+
+typedef struct frame_slot_s {
+  player_frame_t frame;
+  slot_state_t state;
+
+  uint8_t *mem;             /* shared memory (ring buffer) */
+  size_t size;
+  int fd;                   /* memfd of mem, -1 if anonymous */
+
+  void (*release) (void *priv); /* buffer of the wrapper */
+  void *priv;
+} frame_slot_t;
+
+struct frame_ring_s {
+  player_t *player;
+  void (*cb) (const player_frame_t *frame, void *data);
+  void *data;
+
+  frame_slot_t *slots;
+  int nb;
+
+  uint32_t seq;
+  uint32_t frames;
+  uint32_t drops;
+
+  pthread_t th;
+  int run;
+  pthread_mutex_t mutex;
+  pthread_cond_t cond;
+};
+
+
+size_t
+pl_frame_layout (player_frame_format_t format, int width, int height,
+                 int stride[3], size_t offset[3])
+{
+  size_t size;
+
+  memset (stride, 0, 3 * sizeof (*stride));
+  memset (offset, 0, 3 * sizeof (*offset));
+
+  switch (format)
+  {
+  case PLAYER_FRAME_I420:
+    stride[0] = width;
+    stride[1] = stride[2] = (width + 1) / 2;
+    offset[1] = (size_t) stride[0] * height;
+    offset[2] = offset[1] + (size_t) stride[1] * ((height + 1) / 2);
+    size = offset[2] + (size_t) stride[2] * ((height + 1) / 2);
+    break;
+
+  case PLAYER_FRAME_YUY2:
+    stride[0] = ((width + 1) & ~1) * 2;
+    size = (size_t) stride[0] * height;
+    break;
+
+  default:
+    size = 0;
+    break;
+  }
+
+  return size;
+}
+
+static void
+frame_slot_unmap (frame_slot_t *slot)
+{
+  if (slot->mem)
+    munmap (slot->mem, slot->size);
+  if (slot->fd >= 0)
+    close (slot->fd);
+
+  slot->mem  = NULL;
+  slot->size = 0;
+  slot->fd   = -1;
+}
+
+static int
+frame_slot_map (frame_slot_t *slot, size_t size)
+{
+  void *mem;
+  int fd = -1;
+
+  if (slot->mem && slot->size >= size)
+    return 0;
+
+  frame_slot_unmap (slot);
+
+#ifdef HAVE_MEMFD_CREATE
+  fd = memfd_create ("libplayer-frame", MFD_CLOEXEC);
+  if (fd >= 0 && ftruncate (fd, size))
+  {
+    close (fd);
+    fd = -1;
+  }
+#endif /* HAVE_MEMFD_CREATE */
+
+  /* not shareable with an other process without fd */
+  mem = mmap (NULL, size, PROT_READ | PROT_WRITE,
+              fd >= 0 ? MAP_SHARED : MAP_SHARED | MAP_ANONYMOUS, fd, 0);
+  if (mem == MAP_FAILED)
+  {
+    if (fd >= 0)
+      close (fd);
+    return -1;
+  }
+
+  slot->mem  = mem;
+  slot->size = size;
+  slot->fd   = fd;
+  return 0;
+}
+
+static frame_slot_t *
+frame_ring_slot (player_frame_t *frame)
+{
+  /* the descriptor is the first field of the slot */
+  return (frame_slot_t *) frame;
+}
+
+/* the ring must be locked */
+static frame_slot_t *
+frame_ring_take (frame_ring_t *ring)
+{
+  int i;
+
+  ring->frames++;
+
+  for (i = 0; i < ring->nb; i++)
+    if (ring->slots[i].state == SLOT_FREE)
+    {
+      ring->slots[i].state = SLOT_WRITE;
+      ring->slots[i].frame.seq = ring->seq++;
+      return &ring->slots[i];
+    }
+
+  ring->seq++;
+  ring->drops++;
+  return NULL;
+}
+
+player_frame_t *
+pl_frame_ring_acquire (frame_ring_t *ring, player_frame_format_t format,
+                       int width, int height)
+{
+  frame_slot_t *slot;
+  player_frame_t *frame;
+  int stride[3];
+  size_t offset[3];
+  size_t size;
+  int i;
+
+  if (!ring || width <= 0 || height <= 0)
+    return NULL;
+
+  size = pl_frame_layout (format, width, height, stride, offset);
+  if (!size)
+    return NULL;
+
+  pthread_mutex_lock (&ring->mutex);
+  slot = frame_ring_take (ring);
+  pthread_mutex_unlock (&ring->mutex);
+
+  if (!slot)
+    return NULL;
+
+  /* the slot belongs to the wrapper, it can be remapped without lock */
+  if (frame_slot_map (slot, size))
+  {
+    pl_log (ring->player, PLAYER_MSG_ERROR,
+            MODULE_NAME, "unable to map %zu bytes", size);
+    pl_frame_ring_cancel (ring, &slot->frame);
+    return NULL;
+  }
+
+  frame = &slot->frame;
+  frame->format = format;
+  frame->width  = width;
+  frame->height = height;
+  frame->pts    = -1;
+  frame->fd     = slot->fd;
+  frame->size   = slot->size;
+
+  for (i = 0; i < 3; i++)
+  {
+    frame->stride[i] = stride[i];
+    frame->offset[i] = offset[i];
+    frame->plane[i]  = stride[i] ? slot->mem + offset[i] : NULL;
+  }
+
+  return frame;
+}
+
+void
+pl_frame_ring_publish (frame_ring_t *ring, player_frame_t *frame)
+{
+  frame_slot_t *slot;
+
+  if (!ring || !frame)
+    return;
+
+  slot = frame_ring_slot (frame);
+
+  pthread_mutex_lock (&ring->mutex);
+  slot->state = SLOT_READY;
+  pthread_cond_signal (&ring->cond);
+  pthread_mutex_unlock (&ring->mutex);
+}
+
+void
+pl_frame_ring_cancel (frame_ring_t *ring, player_frame_t *frame)
+{
+  frame_slot_t *slot;
+
+  if (!ring || !frame)
+    return;
+
+  slot = frame_ring_slot (frame);
+
+  pthread_mutex_lock (&ring->mutex);
+  slot->state = SLOT_FREE;
+  ring->drops++;
+  pthread_mutex_unlock (&ring->mutex);
+}
+
+void
+pl_frame_ring_push (frame_ring_t *ring, const player_frame_t *frame,
+                    void (*release) (void *priv), void *priv)
+{
+  frame_slot_t *slot;
+  uint32_t seq;
+
+  if (!ring || !frame)
+  {
+    if (release)
+      release (priv);
+    return;
+  }
+
+  pthread_mutex_lock (&ring->mutex);
+  slot = frame_ring_take (ring);
+  if (slot)
+  {
+    seq = slot->frame.seq;
+    slot->frame     = *frame;
+    slot->frame.seq = seq;
+    /* the buffer of the wrapper is not shareable */
+    slot->frame.fd   = -1;
+    slot->frame.size = 0;
+    memset (slot->frame.offset, 0, sizeof (slot->frame.offset));
+    slot->release   = release;
+    slot->priv      = priv;
+    slot->state     = SLOT_READY;
+    pthread_cond_signal (&ring->cond);
+  }
+  pthread_mutex_unlock (&ring->mutex);
+
+  if (!slot && release)
+    release (priv);
+}
+
+/* the ring must be locked */
+static frame_slot_t *
+frame_ring_next (frame_ring_t *ring)
+{
+  frame_slot_t *slot = NULL;
+  int i;
+
+  /* the oldest frame first (the sequence numbers can wrap) */
+  for (i = 0; i < ring->nb; i++)
+    if (ring->slots[i].state == SLOT_READY
+        && (!slot
+            || (int32_t) (ring->slots[i].frame.seq - slot->frame.seq) < 0))
+      slot = &ring->slots[i];
+
+  return slot;
+}
+
+static void *
+frame_ring_thread (void *arg)
+{
+  frame_ring_t *ring = arg;
+  frame_slot_t *slot;
+
+  pthread_mutex_lock (&ring->mutex);
+  for (;;)
+  {
+    while (ring->run && !(slot = frame_ring_next (ring)))
+      pthread_cond_wait (&ring->cond, &ring->mutex);
+
+    if (!ring->run)
+      break;
+
+    slot->state = SLOT_READ;
+    pthread_mutex_unlock (&ring->mutex);
+
+    ring->cb (&slot->frame, ring->data);
+
+    if (slot->release)
+      slot->release (slot->priv);
+
+    pthread_mutex_lock (&ring->mutex);
+    slot->release = NULL;
+    slot->priv    = NULL;
+    slot->state   = SLOT_FREE;
+  }
+  pthread_mutex_unlock (&ring->mutex);
+
+  return NULL;
+}
+
+frame_ring_t *
+pl_frame_ring_new (player_t *player, int slots)
+{
+  frame_ring_t *ring;
+  int i;
+
+  if (!player || !player->frame_cb)
+    return NULL;
+
+  if (slots <= 0)
+    slots = FRAME_RING_DEF;
+  else if (slots > FRAME_RING_MAX)
+    slots = FRAME_RING_MAX;
+
+  ring = PCALLOC (frame_ring_t, 1);
+  if (!ring)
+    return NULL;
+
+  ring->slots = PCALLOC (frame_slot_t, slots);
+  if (!ring->slots)
+  {
+    PFREE (ring);
+    return NULL;
+  }
+
+  for (i = 0; i < slots; i++)
+    ring->slots[i].fd = -1;
+
+  ring->player = player;
+  ring->cb     = player->frame_cb;
+  ring->data   = player->user_data;
+  ring->nb     = slots;
+  ring->run    = 1;
+
+  pthread_mutex_init (&ring->mutex, NULL);
+  pthread_cond_init (&ring->cond, NULL);
+
+  if (pthread_create (&ring->th, NULL, frame_ring_thread, ring))
+  {
+    pl_log (player, PLAYER_MSG_ERROR,
+            MODULE_NAME, "unable to create the frame thread");
+    ring->run = 0;
+    pl_frame_ring_free (ring);
+    return NULL;
+  }
+
+  pl_log (player, PLAYER_MSG_INFO,
+          MODULE_NAME, "frame ring of %i buffers", slots);
+
+  return ring;
+}
+
+void
+pl_frame_ring_free (frame_ring_t *ring)
+{
+  int i;
+
+  if (!ring)
+    return;
+
+  if (ring->run)
+  {
+    pthread_mutex_lock (&ring->mutex);
+    ring->run = 0;
+    pthread_cond_signal (&ring->cond);
+    pthread_mutex_unlock (&ring->mutex);
+    pthread_join (ring->th, NULL);
+  }
+
+  /* frames never given to the callback */
+  for (i = 0; i < ring->nb; i++)
+  {
+    frame_slot_t *slot = &ring->slots[i];
+
+    if (slot->release)
+      slot->release (slot->priv);
+    frame_slot_unmap (slot);
+  }
+
+  pl_log (ring->player, PLAYER_MSG_INFO, MODULE_NAME,
+          "%" PRIu32 " frames, %" PRIu32 " dropped", ring->frames, ring->drops);
+
+  pthread_mutex_destroy (&ring->mutex);
+  pthread_cond_destroy (&ring->cond);
+  PFREE (ring->slots);
+  PFREE (ring);
+}
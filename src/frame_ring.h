@@ -0,0 +1,51 @@
+/*
+ * GeeXboX libplayer: a multimedia A/V abstraction layer API.
+ * Copyright (C) 2010 Mathieu Schroeter <mathieu@schroetersa.ch>
+ *
+ * This file is part of libplayer.
+ *
+ * libplayer is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * libplayer is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with libplayer; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#ifndef FRAME_RING_H
+#define FRAME_RING_H
+
+typedef struct frame_ring_s frame_ring_t;
+
+frame_ring_t *pl_frame_ring_new (player_t *player, int slots);
+void pl_frame_ring_free (frame_ring_t *ring);
+
+/*
+ * A frame is written directly in a buffer of the ring, then published.
+ * NULL is returned when the ring is full, the frame must be dropped.
+ */
+player_frame_t *pl_frame_ring_acquire (frame_ring_t *ring,
+                                       player_frame_format_t format,
+                                       int width, int height);
+void pl_frame_ring_publish (frame_ring_t *ring, player_frame_t *frame);
+void pl_frame_ring_cancel (frame_ring_t *ring, player_frame_t *frame);
+
+/*
+ * A frame in a buffer of the wrapper, release (priv) is called when the
+ * callback has returned (or immediately if the frame is dropped).
+ */
+void pl_frame_ring_push (frame_ring_t *ring, const player_frame_t *frame,
+                         void (*release) (void *priv), void *priv);
+
+/* default layout of the planes, returns the size of the frame */
+size_t pl_frame_layout (player_frame_format_t format, int width, int height,
+                        int stride[3], size_t offset[3]);
+
+#endif /* FRAME_RING_H */
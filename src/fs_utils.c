@@ -19,21 +19,26 @@
  * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
  */
 
+#define _GNU_SOURCE /* copy_file_range */
+
 #include <stdlib.h>
+#include <stdio.h>
+#include <errno.h>
 #include <unistd.h>
 #include <fcntl.h>
 #include <sys/stat.h>
 
 #include "fs_utils.h"
 
-#define BUFFER_SIZE 512
+#define BUFFER_SIZE 65536
 
 
 int
 pl_copy_file (const char *src, const char *dst)
 {
-  char buf[BUFFER_SIZE];
-  int infile, outfile, size;
+  char *buf;
+  int infile, outfile;
+  ssize_t size;
   struct stat st;
 
   infile = open (src, O_RDONLY, 0);
@@ -53,11 +58,34 @@ pl_copy_file (const char *src, const char *dst)
     return -1;
   }
 
+#ifdef HAVE_COPY_FILE_RANGE
+  /* in-kernel copy, the buffers below are only used if it fails */
+  while ((size = copy_file_range (infile, NULL, outfile, NULL,
+                                  BUFFER_SIZE * 16, 0)) > 0)
+    ;
+  if (!size)
+  {
+    close (outfile);
+    close (infile);
+    return 0;
+  }
+#endif /* HAVE_COPY_FILE_RANGE */
+
+  buf = malloc (BUFFER_SIZE);
+  if (!buf)
+  {
+    close (outfile);
+    close (infile);
+    unlink (dst);
+    return -1;
+  }
+
   while ((size = read (infile, buf, BUFFER_SIZE)) > 0)
   {
-    int res = write (outfile, buf, size);
+    ssize_t res = write (outfile, buf, size);
     if (res < size)
     {
+      free (buf);
       close (outfile);
       close (infile);
       unlink (dst);
@@ -65,11 +93,100 @@ pl_copy_file (const char *src, const char *dst)
     }
   }
 
+  free (buf);
   close (outfile);
   close (infile);
   return 0;
 }
 
+int
+pl_move_file (const char *src, const char *dst)
+{
+  if (!rename (src, dst))
+    return 0;
+
+  if (errno != EXDEV)
+    return -1;
+
+  /* not on the same filesystem */
+  if (pl_copy_file (src, dst))
+    return -1;
+
+  unlink (src);
+  return 0;
+}
+
+void *
+pl_read_file (const char *file, size_t *size)
+{
+  char *buf;
+  int fd;
+  size_t pos = 0;
+  struct stat st;
+
+  fd = open (file, O_RDONLY, 0);
+  if (fd < 0)
+    return NULL;
+
+  if (fstat (fd, &st) < 0 || st.st_size <= 0)
+  {
+    close (fd);
+    return NULL;
+  }
+
+  buf = malloc (st.st_size);
+  if (!buf)
+  {
+    close (fd);
+    return NULL;
+  }
+
+  while (pos < (size_t) st.st_size)
+  {
+    ssize_t res = read (fd, buf + pos, st.st_size - pos);
+    if (res <= 0)
+      break;
+    pos += res;
+  }
+
+  close (fd);
+
+  if (pos < (size_t) st.st_size)
+  {
+    free (buf);
+    return NULL;
+  }
+
+  *size = pos;
+  return buf;
+}
+
+int
+pl_write_file (const char *file, const void *data, size_t size)
+{
+  int fd;
+  size_t pos = 0;
+
+  fd = open (file, O_CREAT | O_TRUNC | O_WRONLY, 0644);
+  if (fd < 0)
+    return -1;
+
+  while (pos < size)
+  {
+    ssize_t res = write (fd, (const char *) data + pos, size - pos);
+    if (res <= 0)
+    {
+      close (fd);
+      unlink (file);
+      return -1;
+    }
+    pos += res;
+  }
+
+  close (fd);
+  return 0;
+}
+
 int
 pl_file_exists (const char *file)
 {
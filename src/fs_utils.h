@@ -25,6 +25,9 @@
 #include <sys/types.h>
 
 int pl_copy_file (const char *src, const char *dst);
+int pl_move_file (const char *src, const char *dst);
+void *pl_read_file (const char *file, size_t *size);
+int pl_write_file (const char *file, const void *data, size_t size);
 int pl_file_exists (const char *file);
 off_t pl_file_size (const char *file);
 
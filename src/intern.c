@@ -0,0 +1,164 @@
+/*
+ * GeeXboX libplayer: a multimedia A/V abstraction layer API.
+ * Copyright (C) 2010 Mathieu Schroeter <mathieu@schroetersa.ch>
+ *
+ * This file is part of libplayer.
+ *
+ * libplayer is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * libplayer is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with libplayer; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/*
+ * Pool of interned strings, shared by all player controllers of the
+ * process. A string is saved only once and counted for each user; it must
+ * be released with pl_intern_release() and never be freed or altered.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <stddef.h>
+#include <pthread.h>
+
+#include "intern.h"
+
+#define INTERN_BUCKETS_MIN 256
+
+typedef struct intern_s {
+  struct intern_s *next;
+  unsigned int hash;
+  unsigned int refcnt;
+  char str[];
+} intern_t;
+
+static intern_t **g_buckets;
+static unsigned int g_buckets_nb;
+static unsigned int g_entries;
+static pthread_mutex_t g_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+
+static unsigned int
+intern_hash (const char *str)
+{
+  unsigned int hash = 5381;
+
+  while (*str)
+    hash = hash * 33 + (unsigned char) *str++;
+
+  return hash;
+}
+
+/* the buckets are doubled when the load factor is greater than 1 */
+static void
+intern_rehash (void)
+{
+  intern_t **buckets;
+  unsigned int i, nb;
+
+  nb = g_buckets_nb ? g_buckets_nb * 2 : INTERN_BUCKETS_MIN;
+
+  buckets = calloc (nb, sizeof (*buckets));
+  if (!buckets)
+    return;
+
+  for (i = 0; i < g_buckets_nb; i++)
+    while (g_buckets[i])
+    {
+      intern_t *entry = g_buckets[i];
+
+      g_buckets[i] = entry->next;
+      entry->next = buckets[entry->hash & (nb - 1)];
+      buckets[entry->hash & (nb - 1)] = entry;
+    }
+
+  free (g_buckets);
+  g_buckets    = buckets;
+  g_buckets_nb = nb;
+}
+
+char *
+pl_intern (const char *str)
+{
+  intern_t *entry = NULL;
+  unsigned int hash;
+  size_t len;
+
+  if (!str)
+    return NULL;
+
+  hash = intern_hash (str);
+
+  pthread_mutex_lock (&g_mutex);
+
+  if (g_entries >= g_buckets_nb)
+    intern_rehash ();
+
+  if (g_buckets)
+    for (entry = g_buckets[hash & (g_buckets_nb - 1)]; entry;
+         entry = entry->next)
+      if (entry->hash == hash && !strcmp (entry->str, str))
+        break;
+
+  if (entry)
+    entry->refcnt++;
+  else if (g_buckets)
+  {
+    len = strlen (str) + 1;
+    entry = malloc (offsetof (intern_t, str) + len);
+    if (entry)
+    {
+      memcpy (entry->str, str, len);
+      entry->hash   = hash;
+      entry->refcnt = 1;
+      entry->next   = g_buckets[hash & (g_buckets_nb - 1)];
+      g_buckets[hash & (g_buckets_nb - 1)] = entry;
+      g_entries++;
+    }
+  }
+
+  pthread_mutex_unlock (&g_mutex);
+
+  return entry ? entry->str : NULL;
+}
+
+void
+pl_intern_release (char *str)
+{
+  intern_t *entry, **it;
+
+  if (!str)
+    return;
+
+  entry = (intern_t *) (str - offsetof (intern_t, str));
+
+  pthread_mutex_lock (&g_mutex);
+
+  if (--entry->refcnt)
+  {
+    pthread_mutex_unlock (&g_mutex);
+    return;
+  }
+
+  for (it = &g_buckets[entry->hash & (g_buckets_nb - 1)]; *it;
+       it = &(*it)->next)
+    if (*it == entry)
+    {
+      *it = entry->next;
+      break;
+    }
+
+  g_entries--;
+  pthread_mutex_unlock (&g_mutex);
+
+  free (entry);
+}
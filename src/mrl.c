@@ -115,6 +115,82 @@ mrl_get_size (player_t *player, mrl_t *mrl)
   return out;
 }
 
+int
+mrl_get_properties_all (player_t *player,
+                        mrl_t *mrl, mrl_properties_all_t *prop)
+{
+  supervisor_data_mrl_all_t in;
+  int out = 0;
+
+  pl_log (player, PLAYER_MSG_VERBOSE, MODULE_NAME, __FUNCTION__);
+
+  if (!player || !prop)
+    return 0;
+
+  in.mrl = mrl;
+  in.all = prop;
+
+  pl_supervisor_send (player, SV_MODE_WAIT_FOR_END,
+                      SV_FUNC_MRL_GET_PROPERTIES_ALL, &in, &out);
+
+  return out;
+}
+
+void
+mrl_properties_all_release (mrl_properties_all_t *prop)
+{
+  if (!prop)
+    return;
+
+  PFREE (prop->priv);
+  prop->audio_codec = NULL;
+  prop->video_codec = NULL;
+}
+
+int
+mrl_get_metadata_all (player_t *player, mrl_t *mrl, mrl_metadata_all_t *meta)
+{
+  supervisor_data_mrl_all_t in;
+  int out = 0;
+
+  pl_log (player, PLAYER_MSG_VERBOSE, MODULE_NAME, __FUNCTION__);
+
+  if (!player || !meta)
+    return 0;
+
+  in.mrl = mrl;
+  in.all = meta;
+
+  pl_supervisor_send (player, SV_MODE_WAIT_FOR_END,
+                      SV_FUNC_MRL_GET_METADATA_ALL, &in, &out);
+
+  return out;
+}
+
+void
+mrl_metadata_all_release (mrl_metadata_all_t *meta)
+{
+  if (!meta)
+    return;
+
+  PFREE (meta->priv);
+  meta->title   = NULL;
+  meta->artist  = NULL;
+  meta->genre   = NULL;
+  meta->album   = NULL;
+  meta->year    = NULL;
+  meta->track   = NULL;
+  meta->comment = NULL;
+
+  if (meta->version < 2)
+    return;
+
+  meta->subtitles     = NULL;
+  meta->audio_streams = NULL;
+  meta->cd_tracks     = NULL;
+  meta->dvd_titles    = NULL;
+}
+
 char *
 mrl_get_metadata (player_t *player, mrl_t *mrl, mrl_metadata_type_t m)
 {
@@ -405,3 +481,79 @@ mrl_video_snapshot (player_t *player, mrl_t *mrl,
   pl_supervisor_send (player, SV_MODE_WAIT_FOR_END,
                       SV_FUNC_MRL_VIDEO_SNAPSHOT, &in, NULL);
 }
+
+int
+mrl_video_snapshot_to_buffer (player_t *player, mrl_t *mrl, int pos,
+                              mrl_snapshot_t t, mrl_snapshot_buffer_t *buf)
+{
+  supervisor_data_snapshot_buffer_t in;
+  int out = 0;
+
+  pl_log (player, PLAYER_MSG_VERBOSE, MODULE_NAME, __FUNCTION__);
+
+  if (!player || !buf)
+    return 0;
+
+  in.mrl  = mrl;
+  in.pos  = pos;
+  in.type = t;
+  in.buf  = buf;
+
+  pl_supervisor_send (player, SV_MODE_WAIT_FOR_END,
+                      SV_FUNC_MRL_VIDEO_SNAPSHOT_BUFFER, &in, &out);
+
+  return out;
+}
+
+void
+mrl_snapshot_buffer_release (mrl_snapshot_buffer_t *buf)
+{
+  if (!buf)
+    return;
+
+  PFREE (buf->data);
+  buf->size = 0;
+}
+
+void
+mrl_video_snapshot_batch (player_t *player, mrl_t *mrl,
+                          const int *pos, int n,
+                          mrl_snapshot_t t, const char *dst)
+{
+  supervisor_data_snapshot_batch_t in;
+
+  pl_log (player, PLAYER_MSG_VERBOSE, MODULE_NAME, __FUNCTION__);
+
+  if (!player || !pos || n <= 0)
+    return;
+
+  in.mrl  = mrl;
+  in.pos  = pos;
+  in.n    = n;
+  in.type = t;
+  in.dst  = dst;
+
+  pl_supervisor_send (player, SV_MODE_WAIT_FOR_END,
+                      SV_FUNC_MRL_VIDEO_SNAPSHOT_BATCH, &in, NULL);
+}
+
+void
+mrl_probe_batch (player_t *player, mrl_t **list, int n, int flags,
+                 mrl_probe_cb_t cb, void *data)
+{
+  supervisor_data_probe_t in;
+
+  pl_log (player, PLAYER_MSG_VERBOSE, MODULE_NAME, __FUNCTION__);
+
+  if (!player || !list || n <= 0)
+    return;
+
+  in.list  = list;
+  in.n     = n;
+  in.flags = flags;
+  in.cb    = cb;
+  in.data  = data;
+
+  pl_supervisor_send (player, SV_MODE_WAIT_FOR_END,
+                      SV_FUNC_MRL_PROBE_BATCH, &in, NULL);
+}
@@ -21,27 +21,38 @@
  */
 
 #include <stdlib.h>
+#include <stdio.h>
 #include <string.h>
+#include <ctype.h>
 #include <inttypes.h>
+#include <unistd.h>
+#include <pthread.h>
 
 #include "player.h"
 #include "player_internals.h"
 #include "logs.h"
 #include "playlist.h"
+#include "probe_cache.h"
+#include "intern.h"
+#include "fs_utils.h"
 
 #define MODULE_NAME "mrl"
 
-#define RETURN_NB_ELEMENTS(m) \
-  {                           \
-    uint32_t nb = 0;          \
-    typeof (m) _m = (m);      \
-    while (_m)                \
-    {                         \
-      _m = _m->next;          \
-      nb++;                   \
-    }                         \
-    return nb;                \
-  }
+/* limits of the Red Book (audio CD) and of the DVD-Video specifications */
+#define CD_TRACKS_MAX   99
+#define DVD_TITLES_MAX  99
+
+typedef struct mrl_probe_batch_s {
+  player_t *player;
+  mrl_t **list;
+  int n;
+  int flags;
+  mrl_probe_cb_t cb;
+  void *data;
+
+  int next;                 /* next position to probe in the list */
+  pthread_mutex_t mutex;
+} mrl_probe_batch_t;
 
 /*****************************************************************************/
 /*                          MRL Internal functions                           */
@@ -125,42 +136,72 @@ mrl_properties_free (mrl_properties_t *prop)
   PFREE (prop);
 }
 
-mrl_metadata_cd_track_t *
-mrl_metadata_cd_track_new (void)
+/* 0 is returned when the capacity can not be represented */
+static uint32_t
+mrl_array_capacity (uint32_t nb)
 {
-  mrl_metadata_cd_track_t *track;
+  uint32_t size = 1;
+
+  if (!nb || nb > UINT32_MAX / 2 + 1)
+    return 0;
 
-  track = PCALLOC (mrl_metadata_cd_track_t, 1);
+  while (size < nb)
+    size <<= 1;
 
-  return track;
+  return size;
 }
 
+/*
+ * Resize an array of 'nb' elements to 'new_nb' elements, the new elements
+ * are zeroed. The capacity is not saved, it is the next power of two of the
+ * number of elements.
+ */
+static void *
+mrl_array_resize (void *array, uint32_t nb, uint32_t new_nb, size_t size)
+{
+  uint8_t *tmp = array;
+  uint32_t capacity = mrl_array_capacity (new_nb);
+
+  if (new_nb <= nb)
+    return array;
+
+  if (!capacity || capacity > SIZE_MAX / size)
+    return NULL;
+
+  if (capacity > mrl_array_capacity (nb))
+  {
+    tmp = realloc (array, capacity * size);
+    if (!tmp)
+      return NULL;
+  }
+
+  memset (tmp + nb * size, 0, (new_nb - nb) * size);
+  return tmp;
+}
+
+/*
+ * The tracks are numbered from 1. The IDs come from the engines, then an ID
+ * beyond the number of tracks of the disc (when known) is rejected.
+ */
 mrl_metadata_cd_track_t *
 mrl_metadata_cd_get_track (mrl_metadata_cd_t *cd, uint32_t id)
 {
-  unsigned int i;
-  mrl_metadata_cd_track_t *track = NULL;
+  mrl_metadata_cd_track_t *track;
 
-  if (!cd)
+  if (!cd || !id || id > CD_TRACKS_MAX || (cd->tracks && id > cd->tracks))
     return NULL;
 
-  for (i = 0; i < id; i++)
+  if (id > cd->track_nb)
   {
-    if (!i)
-    {
-      if (!cd->track)
-        cd->track = mrl_metadata_cd_track_new ();
-      track = cd->track;
-    }
-    else
-    {
-      if (!track->next)
-        track->next = mrl_metadata_cd_track_new ();
-      track = track->next;
-    }
+    track = mrl_array_resize (cd->track, cd->track_nb, id, sizeof (*track));
+    if (!track)
+      return NULL;
+
+    cd->track    = track;
+    cd->track_nb = id;
   }
 
-  return track;
+  return &cd->track[id - 1];
 }
 
 static mrl_metadata_cd_t *
@@ -173,42 +214,26 @@ mrl_metadata_cd_new (void)
   return cd;
 }
 
-mrl_metadata_dvd_title_t *
-mrl_metadata_dvd_title_new (void)
-{
-  mrl_metadata_dvd_title_t *title;
-
-  title = PCALLOC (mrl_metadata_dvd_title_t, 1);
-
-  return title;
-}
-
+/* same as mrl_metadata_cd_get_track() */
 mrl_metadata_dvd_title_t *
 mrl_metadata_dvd_get_title (mrl_metadata_dvd_t *dvd, uint32_t id)
 {
-  unsigned int i;
-  mrl_metadata_dvd_title_t *title = NULL;
+  mrl_metadata_dvd_title_t *title;
 
-  if (!dvd)
+  if (!dvd || !id || id > DVD_TITLES_MAX || (dvd->titles && id > dvd->titles))
     return NULL;
 
-  for (i = 0; i < id; i++)
+  if (id > dvd->title_nb)
   {
-    if (!i)
-    {
-      if (!dvd->title)
-        dvd->title = mrl_metadata_dvd_title_new ();
-      title = dvd->title;
-    }
-    else
-    {
-      if (!title->next)
-        title->next = mrl_metadata_dvd_title_new ();
-      title = title->next;
-    }
+    title = mrl_array_resize (dvd->title, dvd->title_nb, id, sizeof (*title));
+    if (!title)
+      return NULL;
+
+    dvd->title    = title;
+    dvd->title_nb = id;
   }
 
-  return title;
+  return &dvd->title[id - 1];
 }
 
 static mrl_metadata_dvd_t *
@@ -221,80 +246,63 @@ mrl_metadata_dvd_new (void)
   return dvd;
 }
 
-static mrl_metadata_sub_t *
-mrl_metadata_sub_new (void)
+/*
+ * The subtitle is appended if the ID is not found. The IDs are usually the
+ * positions in the array, then the lookup is O(1) in most cases.
+ */
+mrl_metadata_sub_t *
+mrl_metadata_sub_get (mrl_metadata_t *meta, uint32_t id)
 {
   mrl_metadata_sub_t *sub;
+  uint32_t i;
 
-  sub = PCALLOC (mrl_metadata_sub_t, 1);
+  if (!meta)
+    return NULL;
 
-  return sub;
-}
+  if (id < meta->subs_nb && meta->subs[id].id == id)
+    return &meta->subs[id];
 
-mrl_metadata_sub_t *
-mrl_metadata_sub_get (mrl_metadata_sub_t **sub, uint32_t id)
-{
-  mrl_metadata_sub_t *subtitle, *subtitle_p;
+  for (i = 0; i < meta->subs_nb; i++)
+    if (meta->subs[i].id == id)
+      return &meta->subs[i];
 
+  sub = mrl_array_resize (meta->subs,
+                          meta->subs_nb, meta->subs_nb + 1, sizeof (*sub));
   if (!sub)
     return NULL;
 
-  if (!*sub)
-  {
-    *sub = mrl_metadata_sub_new ();
-    return *sub;
-  }
-
-  subtitle = *sub;
-  while (subtitle)
-  {
-    if (subtitle->id == id)
-      return subtitle;
-    subtitle_p = subtitle;
-    subtitle = subtitle->next;
-  }
-
-  /* not found */
-  subtitle_p->next = mrl_metadata_sub_new ();
-  return subtitle_p->next;
+  meta->subs = sub;
+  sub += meta->subs_nb++;
+  sub->id = id;
+  return sub;
 }
 
-static mrl_metadata_audio_t *
-mrl_metadata_audio_new (void)
+/* same as mrl_metadata_sub_get() */
+mrl_metadata_audio_t *
+mrl_metadata_audio_get (mrl_metadata_t *meta, uint32_t id)
 {
   mrl_metadata_audio_t *audio;
+  uint32_t i;
 
-  audio = PCALLOC (mrl_metadata_audio_t, 1);
+  if (!meta)
+    return NULL;
 
-  return audio;
-}
+  if (id < meta->audio_nb && meta->audio_streams[id].id == id)
+    return &meta->audio_streams[id];
 
-mrl_metadata_audio_t *
-mrl_metadata_audio_get (mrl_metadata_audio_t **audio, uint32_t id)
-{
-  mrl_metadata_audio_t *a, *a_p;
+  for (i = 0; i < meta->audio_nb; i++)
+    if (meta->audio_streams[i].id == id)
+      return &meta->audio_streams[i];
 
+  audio = mrl_array_resize (meta->audio_streams,
+                            meta->audio_nb, meta->audio_nb + 1, sizeof (*audio));
   if (!audio)
     return NULL;
 
-  if (!*audio)
-  {
-    *audio = mrl_metadata_audio_new ();
-    return *audio;
-  }
-
-  a = *audio;
-  while (a)
-  {
-    if (a->id == id)
-      return a;
-    a_p = a;
-    a = a->next;
-  }
-
-  /* not found */
-  a_p->next = mrl_metadata_audio_new ();
-  return a_p->next;
+  meta->audio_streams = audio;
+  audio += meta->audio_nb++;
+  audio->id = id;
+  return audio;
 }
 
 mrl_metadata_t *
@@ -328,88 +336,86 @@ mrl_metadata_new (mrl_resource_t res)
 static void
 mrl_metadata_cd_free (mrl_metadata_cd_t *cd)
 {
-  mrl_metadata_cd_track_t *track, *track_p;
+  uint32_t i;
 
   if (!cd)
     return;
 
-  track = cd->track;
-  while (track)
-  {
-    PFREE (track->name);
-    track_p = track;
-    track = track->next;
-    PFREE (track_p);
-  }
+  for (i = 0; i < cd->track_nb; i++)
+    PFREE (cd->track[i].name);
+  PFREE (cd->track);
 }
 
 static void
 mrl_metadata_dvd_free (mrl_metadata_dvd_t *dvd)
 {
-  mrl_metadata_dvd_title_t *title, *title_p;
-
   if (!dvd)
     return;
 
   PFREE (dvd->volumeid);
-
-  title = dvd->title;
-  while (title)
-  {
-    title_p = title;
-    title = title->next;
-    PFREE (title_p);
-  }
+  PFREE (dvd->title);
 }
 
+/* the arrays of a packed metadata are in the same allocation */
 static void
-mrl_metadata_sub_free (mrl_metadata_sub_t *sub)
+mrl_metadata_packed_free (mrl_metadata_t *meta)
 {
-  mrl_metadata_sub_t *sub_n;
+  uint32_t i;
+
+  pl_intern_release (meta->artist);
+  pl_intern_release (meta->genre);
+  pl_intern_release (meta->album);
+  pl_intern_release (meta->year);
+  pl_intern_release (meta->track);
 
-  while (sub)
+  for (i = 0; i < meta->subs_nb; i++)
   {
-    PFREE (sub->name);
-    PFREE (sub->lang);
-    sub_n = sub->next;
-    PFREE (sub);
-    sub = sub_n;
+    pl_intern_release (meta->subs[i].name);
+    pl_intern_release (meta->subs[i].lang);
   }
-}
 
-static void
-mrl_metadata_audio_free (mrl_metadata_audio_t *audio)
-{
-  mrl_metadata_audio_t *audio_n;
-
-  while (audio)
+  for (i = 0; i < meta->audio_nb; i++)
   {
-    PFREE (audio->name);
-    PFREE (audio->lang);
-    audio_n = audio->next;
-    PFREE (audio);
-    audio = audio_n;
+    pl_intern_release (meta->audio_streams[i].name);
+    pl_intern_release (meta->audio_streams[i].lang);
   }
 }
 
 void
 mrl_metadata_free (mrl_metadata_t *meta, mrl_resource_t res)
 {
+  uint32_t i;
+
   if (!meta)
     return;
 
   PFREE (meta->title);
-  PFREE (meta->artist);
-  PFREE (meta->genre);
-  PFREE (meta->album);
-  PFREE (meta->year);
-  PFREE (meta->track);
   PFREE (meta->comment);
 
-  if (meta->subs)
-    mrl_metadata_sub_free (meta->subs);
-  if (meta->audio_streams)
-    mrl_metadata_audio_free (meta->audio_streams);
+  if (meta->packed)
+    mrl_metadata_packed_free (meta);
+  else
+  {
+    PFREE (meta->artist);
+    PFREE (meta->genre);
+    PFREE (meta->album);
+    PFREE (meta->year);
+    PFREE (meta->track);
+
+    for (i = 0; i < meta->subs_nb; i++)
+    {
+      PFREE (meta->subs[i].name);
+      PFREE (meta->subs[i].lang);
+    }
+    PFREE (meta->subs);
+
+    for (i = 0; i < meta->audio_nb; i++)
+    {
+      PFREE (meta->audio_streams[i].name);
+      PFREE (meta->audio_streams[i].lang);
+    }
+    PFREE (meta->audio_streams);
+  }
 
   if (meta->priv)
   {
@@ -434,6 +440,79 @@ mrl_metadata_free (mrl_metadata_t *meta, mrl_resource_t res)
   PFREE (meta);
 }
 
+static char *
+mrl_metadata_intern (char *str)
+{
+  char *res = pl_intern (str);
+
+  PFREE (str);
+  return res;
+}
+
+/*
+ * The metadata, the subtitles and the audio streams are moved in one
+ * allocation and the strings which are often duplicated in a library are
+ * interned (see intern.c). A packed metadata must never be altered; the
+ * title and the comment are almost always unique, they are kept as is.
+ */
+mrl_metadata_t *
+mrl_metadata_pack (mrl_metadata_t *meta)
+{
+  mrl_metadata_t *pack;
+  size_t subs, audios;
+  uint32_t i;
+
+  if (!meta || meta->packed)
+    return meta;
+
+  subs   = meta->subs_nb * sizeof (mrl_metadata_sub_t);
+  audios = meta->audio_nb * sizeof (mrl_metadata_audio_t);
+
+  pack = malloc (sizeof (mrl_metadata_t) + subs + audios);
+  if (!pack)
+    return meta;
+
+  *pack = *meta;
+  pack->packed = 1;
+  pack->subs = (mrl_metadata_sub_t *) (pack + 1);
+  pack->audio_streams = (mrl_metadata_audio_t *) ((uint8_t *) pack->subs + subs);
+
+  if (subs)
+    memcpy (pack->subs, meta->subs, subs);
+  else
+    pack->subs = NULL;
+
+  if (audios)
+    memcpy (pack->audio_streams, meta->audio_streams, audios);
+  else
+    pack->audio_streams = NULL;
+
+  pack->artist = mrl_metadata_intern (meta->artist);
+  pack->genre  = mrl_metadata_intern (meta->genre);
+  pack->album  = mrl_metadata_intern (meta->album);
+  pack->year   = mrl_metadata_intern (meta->year);
+  pack->track  = mrl_metadata_intern (meta->track);
+
+  for (i = 0; i < pack->subs_nb; i++)
+  {
+    pack->subs[i].name = mrl_metadata_intern (pack->subs[i].name);
+    pack->subs[i].lang = mrl_metadata_intern (pack->subs[i].lang);
+  }
+
+  for (i = 0; i < pack->audio_nb; i++)
+  {
+    pack->audio_streams[i].name =
+      mrl_metadata_intern (pack->audio_streams[i].name);
+    pack->audio_streams[i].lang =
+      mrl_metadata_intern (pack->audio_streams[i].lang);
+  }
+
+  PFREE (meta->subs);
+  PFREE (meta->audio_streams);
+  PFREE (meta);
+  return pack;
+}
+
 static void
 mrl_resource_local_free (mrl_resource_local_args_t *args)
 {
@@ -488,19 +567,6 @@ mrl_resource_network_free (mrl_resource_network_args_t *args)
   PFREE (args->user_agent);
 }
 
-void
-mrl_list_free (mrl_t *mrl)
-{
-  if (!mrl)
-    return;
-
-  /* go to the very begining of the playlist in case of recursive free() */
-  while (mrl->prev)
-    mrl = mrl->prev;
-
-  mrl_sv_free (mrl, 1);
-}
-
 static inline void
 mrl_use_internal (player_t *player, mrl_t **mrl)
 {
@@ -510,6 +576,28 @@ mrl_use_internal (player_t *player, mrl_t **mrl)
   *mrl = pl_playlist_get_mrl (player->playlist);
 }
 
+static int
+mrl_resource_is_network (mrl_resource_t res)
+{
+  switch (res)
+  {
+  case MRL_RESOURCE_FTP:
+  case MRL_RESOURCE_HTTP:
+  case MRL_RESOURCE_MMS:
+  case MRL_RESOURCE_NETVDR:
+  case MRL_RESOURCE_RTP:
+  case MRL_RESOURCE_RTSP:
+  case MRL_RESOURCE_SMB:
+  case MRL_RESOURCE_TCP:
+  case MRL_RESOURCE_UDP:
+  case MRL_RESOURCE_UNSV:
+    return 1;
+
+  default:
+    return 0;
+  }
+}
+
 static void
 mrl_properties_plog (player_t *player, mrl_t *mrl)
 {
@@ -587,31 +675,11 @@ mrl_properties_plog (player_t *player, mrl_t *mrl)
   }
 }
 
-void
-mrl_retrieve_properties (player_t *player, mrl_t *mrl)
-{
-  pl_log (player, PLAYER_MSG_VERBOSE, MODULE_NAME, __FUNCTION__);
-
-  if (!player || !mrl)
-    return;
-
-  if (mrl->prop) /* already retrieved */
-    return;
-
-  mrl->prop = mrl_properties_new ();
-
-  /* player specific mrl_retrieve_props() */
-  PLAYER_FUNCS (mrl_retrieve_props, mrl)
-
-  mrl_properties_plog (player, mrl);
-}
-
 static void
 mrl_metadata_plog (player_t *player, mrl_t *mrl)
 {
   mrl_metadata_t *meta;
-  mrl_metadata_sub_t *sub;
-  mrl_metadata_audio_t *audio;
+  uint32_t i;
 
   if (!player || !mrl)
     return;
@@ -651,9 +719,10 @@ mrl_metadata_plog (player_t *player, mrl_t *mrl)
     pl_log (player, PLAYER_MSG_INFO,
             MODULE_NAME, "Meta Comment: %s", meta->comment);
 
-  sub = meta->subs;
-  while (sub)
+  for (i = 0; i < meta->subs_nb; i++)
   {
+    mrl_metadata_sub_t *sub = &meta->subs[i];
+
     if (sub->name)
       pl_log (player, PLAYER_MSG_INFO,
               MODULE_NAME, "Subtitle %u Name: %s", sub->id, sub->name);
@@ -661,13 +730,12 @@ mrl_metadata_plog (player_t *player, mrl_t *mrl)
     if (sub->lang)
       pl_log (player, PLAYER_MSG_INFO,
               MODULE_NAME, "Subtitle %u Language: %s", sub->id, sub->lang);
-
-    sub = sub->next;
   }
 
-  audio = meta->audio_streams;
-  while (audio)
+  for (i = 0; i < meta->audio_nb; i++)
   {
+    mrl_metadata_audio_t *audio = &meta->audio_streams[i];
+
     if (audio->name)
       pl_log (player, PLAYER_MSG_INFO,
               MODULE_NAME, "Audio Stream %u Name: %s", audio->id, audio->name);
@@ -676,8 +744,6 @@ mrl_metadata_plog (player_t *player, mrl_t *mrl)
       pl_log (player, PLAYER_MSG_INFO,
               MODULE_NAME, "Audio Stream %u Language: %s",
               audio->id, audio->lang);
-
-    audio = audio->next;
   }
 
   if (!meta->priv)
@@ -688,9 +754,7 @@ mrl_metadata_plog (player_t *player, mrl_t *mrl)
   case MRL_RESOURCE_CDDA:
   case MRL_RESOURCE_CDDB:
   {
-    int cnt = 1;
     mrl_metadata_cd_t *cd = meta->priv;
-    mrl_metadata_cd_track_t *track = cd->track;
 
     pl_log (player, PLAYER_MSG_INFO,
             MODULE_NAME, "Meta CD DiscID: %08lx", cd->discid);
@@ -698,17 +762,16 @@ mrl_metadata_plog (player_t *player, mrl_t *mrl)
     pl_log (player, PLAYER_MSG_INFO,
             MODULE_NAME, "Meta CD Tracks: %i", cd->tracks);
 
-    while (track)
+    for (i = 0; i < cd->track_nb; i++)
     {
+      mrl_metadata_cd_track_t *track = &cd->track[i];
+
       if (track->name)
         pl_log (player, PLAYER_MSG_INFO,
-                MODULE_NAME, "Meta CD Track %i Name: %s", cnt, track->name);
+                MODULE_NAME, "Meta CD Track %i Name: %s", i + 1, track->name);
 
       pl_log (player, PLAYER_MSG_INFO, MODULE_NAME,
-              "Meta CD Track %i Length: %i ms", cnt, track->length);
-
-      cnt++;
-      track = track->next;
+              "Meta CD Track %i Length: %i ms", i + 1, track->length);
     }
     break;
   }
@@ -716,9 +779,7 @@ mrl_metadata_plog (player_t *player, mrl_t *mrl)
   case MRL_RESOURCE_DVD:
   case MRL_RESOURCE_DVDNAV:
   {
-    int cnt = 1;
     mrl_metadata_dvd_t *dvd = meta->priv;
-    mrl_metadata_dvd_title_t *title = dvd->title;
 
     if (dvd->volumeid)
       pl_log (player, PLAYER_MSG_INFO,
@@ -727,22 +788,21 @@ mrl_metadata_plog (player_t *player, mrl_t *mrl)
     pl_log (player, PLAYER_MSG_INFO,
             MODULE_NAME, "Meta DVD Titles: %i", dvd->titles);
 
-    while (title)
+    for (i = 0; i < dvd->title_nb; i++)
     {
+      mrl_metadata_dvd_title_t *title = &dvd->title[i];
+
       pl_log (player, PLAYER_MSG_INFO,
               MODULE_NAME, "Meta DVD Title %i Chapters: %i",
-              cnt, title->chapters);
+              i + 1, title->chapters);
 
       pl_log (player, PLAYER_MSG_INFO,
               MODULE_NAME, "Meta DVD Title %i Angles: %i",
-              cnt, title->angles);
+              i + 1, title->angles);
 
       pl_log (player, PLAYER_MSG_INFO,
               MODULE_NAME, "Meta DVD Title %i Length: %i ms",
-              cnt, title->length);
-
-      cnt++;
-      title = title->next;
+              i + 1, title->length);
     }
     break;
   }
@@ -752,6 +812,103 @@ mrl_metadata_plog (player_t *player, mrl_t *mrl)
   }
 }
 
+/*
+ * Probe planner.
+ *
+ * The wrappers retrieve all facets (properties and metadata) allocated in the
+ * MRL with only one probe. Then the planner allocates every facet not yet
+ * retrieved and runs only one probe, even if only one facet is requested.
+ *
+ * The probes for the same MRL are coalesced, a second caller waits for the
+ * end of the probe in flight instead of starting a new one.
+ *
+ * When 'live' is set and the MRL is the one loaded in the engine, the facets
+ * are first requested to the wrapper with mrl_retrieve_live(). Then the
+ * stream is not opened a second time. 'live' must be set only from the
+ * supervisor thread.
+ */
+static void
+mrl_probe (player_t *player, mrl_t *mrl, int flags, int live)
+{
+  int todo;
+
+  pthread_mutex_lock (&player->mutex_probe);
+  while (mrl->probing)
+    pthread_cond_wait (&player->cond_probe, &player->mutex_probe);
+
+  todo = ~mrl->facets & (IDENTIFY_PROPERTIES | IDENTIFY_METADATA);
+  if (!(todo & flags)) /* already retrieved */
+  {
+    pthread_mutex_unlock (&player->mutex_probe);
+    return;
+  }
+
+  mrl->probing = 1;
+  pthread_mutex_unlock (&player->mutex_probe);
+
+  if (!pl_probe_cache_get (player, player->probe_cache, mrl, todo))
+  {
+    mrl_metadata_t *packed = NULL;
+
+    /* a packed metadata is never altered, the wrapper uses a new one */
+    if (mrl->meta && mrl->meta->packed)
+    {
+      packed = mrl->meta;
+      mrl->meta = NULL;
+    }
+
+    if (!mrl->prop)
+      mrl->prop = mrl_properties_new ();
+    if (!mrl->meta)
+      mrl->meta = mrl_metadata_new (mrl->resource);
+
+    /* player specific mrl_retrieve_live() if the MRL is playing */
+    if (live && player->funcs->mrl_retrieve_live
+        && mrl == pl_playlist_get_mrl (player->playlist)
+        && player->funcs->mrl_retrieve_live (player, mrl))
+      pl_log (player, PLAYER_MSG_VERBOSE,
+              MODULE_NAME, "facets retrieved from the engine");
+    /* player specific mrl_retrieve_props() for all facets */
+    else if (player->funcs->mrl_retrieve_props)
+      player->funcs->mrl_retrieve_props (player, mrl);
+    else
+      PLAYER_FUNCS (mrl_retrieve_meta, mrl)
+
+    pl_probe_cache_put (player, player->probe_cache, mrl);
+
+    if (packed)
+    {
+      mrl_metadata_free (mrl->meta, mrl->resource);
+      mrl->meta = packed;
+    }
+  }
+
+  if (player->metadata_pack && (todo & IDENTIFY_METADATA))
+    mrl->meta = mrl_metadata_pack (mrl->meta);
+
+  if (todo & IDENTIFY_PROPERTIES)
+    mrl_properties_plog (player, mrl);
+  if (todo & IDENTIFY_METADATA)
+    mrl_metadata_plog (player, mrl);
+
+  pthread_mutex_lock (&player->mutex_probe);
+  mrl->facets |= todo;
+  mrl->probing = 0;
+  pthread_cond_broadcast (&player->cond_probe);
+  pthread_mutex_unlock (&player->mutex_probe);
+}
+
+void
+mrl_retrieve_properties (player_t *player, mrl_t *mrl)
+{
+  pl_log (player, PLAYER_MSG_VERBOSE, MODULE_NAME, __FUNCTION__);
+
+  if (!player || !mrl)
+    return;
+
+  mrl_probe (player, mrl, IDENTIFY_PROPERTIES, 1);
+}
+
 void
 mrl_retrieve_metadata (player_t *player, mrl_t *mrl)
 {
@@ -760,15 +917,34 @@ mrl_retrieve_metadata (player_t *player, mrl_t *mrl)
   if (!player || !mrl)
     return;
 
-  if (mrl->meta) /* already retrieved */
+  mrl_probe (player, mrl, IDENTIFY_METADATA, 1);
+}
+
+/*
+ * Must be called by the wrapper in pb_start(), once the stream is loaded by
+ * the engine and before the window is mapped. The properties deferred by
+ * mrl_sv_new() are retrieved from the engine and the video geometry is
+ * updated accordingly.
+ */
+void
+mrl_retrieve_deferred (player_t *player, mrl_t *mrl)
+{
+  mrl_properties_video_t *video;
+
+  if (!player || !mrl || mrl->facets & IDENTIFY_PROPERTIES)
     return;
 
-  mrl->meta = mrl_metadata_new (mrl->resource);
+  mrl_probe (player, mrl, IDENTIFY_PROPERTIES, 1);
+  if (mrl->type == MRL_TYPE_UNKNOWN)
+    mrl->type = mrl_guess_type (mrl);
 
-  /* player specific mrl_retrieve_meta() */
-  PLAYER_FUNCS (mrl_retrieve_meta, mrl)
+  if (!mrl->prop || !mrl->prop->video)
+    return;
 
-  mrl_metadata_plog (player, mrl);
+  video = mrl->prop->video;
+  player->w = video->width;
+  player->h = video->height;
+  player->aspect = video->aspect / PLAYER_VIDEO_ASPECT_RATIO_MULT;
 }
 
 static char *
@@ -815,7 +991,7 @@ mrl_get_codec (player_t *player, mrl_t *mrl, mrl_type_t type)
 /*****************************************************************************/
 
 void
-mrl_sv_free (mrl_t *mrl, int recursive)
+mrl_sv_free (mrl_t *mrl)
 {
   if (!mrl)
     return;
@@ -884,9 +1060,6 @@ mrl_sv_free (mrl_t *mrl, int recursive)
     PFREE (mrl->priv);
   }
 
-  if (recursive && mrl->next)
-    mrl_sv_free (mrl->next, 1);
-
   PFREE (mrl);
 }
 
@@ -992,6 +1165,278 @@ mrl_sv_get_size (player_t *player, mrl_t *mrl)
   return mrl->prop ? mrl->prop->size : 0;
 }
 
+/*
+ * Copy all strings in only one block. The pointers in \p dst are set in this
+ * block, NULL for a NULL string.
+ */
+static void *
+mrl_strings_pack (const char **dst[], const char *const src[], unsigned int nb)
+{
+  unsigned int i;
+  size_t len = 0;
+  char *block, *it;
+
+  for (i = 0; i < nb; i++)
+  {
+    *dst[i] = NULL;
+    if (src[i])
+      len += strlen (src[i]) + 1;
+  }
+
+  if (!len)
+    return NULL;
+
+  block = malloc (len);
+  if (!block)
+    return NULL;
+
+  for (i = 0, it = block; i < nb; i++)
+  {
+    if (!src[i])
+      continue;
+
+    len = strlen (src[i]) + 1;
+    memcpy (it, src[i], len);
+    *dst[i] = it;
+    it += len;
+  }
+
+  return block;
+}
+
+int
+mrl_sv_get_properties_all (player_t *player,
+                           mrl_t *mrl, mrl_properties_all_t *all)
+{
+  mrl_properties_t *prop;
+  mrl_properties_audio_t *audio;
+  mrl_properties_video_t *video;
+
+  pl_log (player, PLAYER_MSG_VERBOSE, MODULE_NAME, __FUNCTION__);
+
+  if (!player || !all || all->version < 1)
+    return 0;
+
+  /* try to use internal mrl? */
+  mrl_use_internal (player, &mrl);
+  if (!mrl)
+    return 0;
+
+  if (!mrl->prop)
+    mrl_retrieve_properties (player, mrl);
+
+  prop = mrl->prop;
+  if (!prop)
+    return 0;
+
+  audio = prop->audio;
+  video = prop->video;
+
+  all->type     = mrl->type;
+  all->size     = prop->size;
+  all->seekable = prop->seekable;
+  all->length   = prop->length;
+
+  all->audio_bitrate    = audio ? audio->bitrate    : 0;
+  all->audio_bits       = audio ? audio->bits       : 0;
+  all->audio_channels   = audio ? audio->channels   : 0;
+  all->audio_samplerate = audio ? audio->samplerate : 0;
+
+  all->video_bitrate       = video ? video->bitrate       : 0;
+  all->video_width         = video ? video->width         : 0;
+  all->video_height        = video ? video->height        : 0;
+  all->video_aspect        = video ? video->aspect        : 0;
+  all->video_channels      = video ? video->channels      : 0;
+  all->video_streams       = video ? video->streams       : 0;
+  all->video_frameduration = video ? video->frameduration : 0;
+
+  {
+    const char **dst[] = {
+      &all->audio_codec,
+      &all->video_codec,
+    };
+    const char *const src[] = {
+      audio ? audio->codec : NULL,
+      video ? video->codec : NULL,
+    };
+
+    all->priv = mrl_strings_pack (dst, src, ARRAY_NB_ELEMENTS (src));
+  }
+
+  return MRL_PROPERTIES_ALL_VERSION;
+}
+
+static size_t
+mrl_string_size (const char *str)
+{
+  return str ? strlen (str) + 1 : 0;
+}
+
+static const char *
+mrl_string_put (char **it, const char *str)
+{
+  const char *res = *it;
+  size_t len;
+
+  if (!str)
+    return NULL;
+
+  len = strlen (str) + 1;
+  memcpy (*it, str, len);
+  *it += len;
+  return res;
+}
+
+int
+mrl_sv_get_metadata_all (player_t *player, mrl_t *mrl, mrl_metadata_all_t *all)
+{
+  mrl_metadata_t *meta;
+  mrl_metadata_cd_t *cd = NULL;
+  mrl_metadata_dvd_t *dvd = NULL;
+  mrl_metadata_stream_all_t *stream;
+  mrl_metadata_track_all_t *track;
+  mrl_metadata_title_all_t *title;
+  uint32_t subs = 0, audios = 0, tracks = 0, titles = 0, i;
+  size_t head, len;
+  char *block = NULL, *it;
+  int version;
+
+  pl_log (player, PLAYER_MSG_VERBOSE, MODULE_NAME, __FUNCTION__);
+
+  if (!player || !all || all->version < 1)
+    return 0;
+
+  /* try to use internal mrl? */
+  mrl_use_internal (player, &mrl);
+  if (!mrl)
+    return 0;
+
+  if (!mrl->meta)
+    mrl_retrieve_metadata (player, mrl);
+
+  meta = mrl->meta;
+  if (!meta)
+    return 0;
+
+  version = all->version < MRL_METADATA_ALL_VERSION
+            ? all->version : MRL_METADATA_ALL_VERSION;
+
+  if (version >= 2)
+  {
+    subs   = meta->subs_nb;
+    audios = meta->audio_nb;
+
+    if (meta->priv)
+      switch (mrl->resource)
+      {
+      case MRL_RESOURCE_CDDA:
+      case MRL_RESOURCE_CDDB:
+        cd = meta->priv;
+        tracks = cd->track_nb;
+        break;
+
+      case MRL_RESOURCE_DVD:
+      case MRL_RESOURCE_DVDNAV:
+        dvd = meta->priv;
+        titles = dvd->title_nb;
+        break;
+
+      default:
+        break;
+      }
+  }
+
+  /*
+   * Everything lives in one block released by mrl_metadata_all_release():
+   * the arrays first (the most aligned structures before), then the strings.
+   */
+  head = (subs + audios) * sizeof (mrl_metadata_stream_all_t)
+         + tracks * sizeof (mrl_metadata_track_all_t)
+         + titles * sizeof (mrl_metadata_title_all_t);
+
+  len = head
+        + mrl_string_size (meta->title)
+        + mrl_string_size (meta->artist)
+        + mrl_string_size (meta->genre)
+        + mrl_string_size (meta->album)
+        + mrl_string_size (meta->year)
+        + mrl_string_size (meta->track)
+        + mrl_string_size (meta->comment);
+
+  for (i = 0; i < subs; i++)
+    len += mrl_string_size (meta->subs[i].name)
+           + mrl_string_size (meta->subs[i].lang);
+  for (i = 0; i < audios; i++)
+    len += mrl_string_size (meta->audio_streams[i].name)
+           + mrl_string_size (meta->audio_streams[i].lang);
+  for (i = 0; i < tracks; i++)
+    len += mrl_string_size (cd->track[i].name);
+
+  if (len)
+  {
+    block = malloc (len);
+    if (!block)
+      return 0;
+  }
+
+  it = block ? block + head : NULL;
+  all->title   = mrl_string_put (&it, meta->title);
+  all->artist  = mrl_string_put (&it, meta->artist);
+  all->genre   = mrl_string_put (&it, meta->genre);
+  all->album   = mrl_string_put (&it, meta->album);
+  all->year    = mrl_string_put (&it, meta->year);
+  all->track   = mrl_string_put (&it, meta->track);
+  all->comment = mrl_string_put (&it, meta->comment);
+
+  all->subtitle_nb = meta->subs_nb;
+  all->audio_nb    = meta->audio_nb;
+  all->priv        = block;
+
+  if (version < 2)
+    return version;
+
+  stream = (mrl_metadata_stream_all_t *) block;
+
+  all->subtitles = subs ? stream : NULL;
+  for (i = 0; i < subs; i++, stream++)
+  {
+    stream->id   = meta->subs[i].id;
+    stream->name = mrl_string_put (&it, meta->subs[i].name);
+    stream->lang = mrl_string_put (&it, meta->subs[i].lang);
+  }
+
+  all->audio_streams = audios ? stream : NULL;
+  for (i = 0; i < audios; i++, stream++)
+  {
+    stream->id   = meta->audio_streams[i].id;
+    stream->name = mrl_string_put (&it, meta->audio_streams[i].name);
+    stream->lang = mrl_string_put (&it, meta->audio_streams[i].lang);
+  }
+
+  track = (mrl_metadata_track_all_t *) stream;
+
+  all->cd_track_nb = tracks;
+  all->cd_tracks   = tracks ? track : NULL;
+  for (i = 0; i < tracks; i++, track++)
+  {
+    track->name   = mrl_string_put (&it, cd->track[i].name);
+    track->length = cd->track[i].length;
+  }
+
+  title = (mrl_metadata_title_all_t *) track;
+
+  all->dvd_title_nb = titles;
+  all->dvd_titles   = titles ? title : NULL;
+  for (i = 0; i < titles; i++, title++)
+  {
+    title->chapters = dvd->title[i].chapters;
+    title->angles   = dvd->title[i].angles;
+    title->length   = dvd->title[i].length;
+  }
+
+  return version;
+}
+
 char *
 mrl_sv_get_metadata (player_t *player, mrl_t *mrl, mrl_metadata_type_t m)
 {
@@ -1045,7 +1490,6 @@ char *
 mrl_sv_get_metadata_cd_track (player_t *player,
                               mrl_t *mrl, int trackid, uint32_t *length)
 {
-  int i;
   mrl_metadata_t *meta;
   mrl_metadata_cd_t *cd;
   mrl_metadata_cd_track_t *track;
@@ -1074,14 +1518,12 @@ mrl_sv_get_metadata_cd_track (player_t *player,
   if (!cd)
     return NULL;
 
-  track = cd->track;
-  for (i = 1; i < trackid && track; i++)
-    track = track->next;
-
   /* track unavailable */
-  if (i != trackid || !track)
+  if (trackid < 1 || (uint32_t) trackid > cd->track_nb)
     return NULL;
 
+  track = &cd->track[trackid - 1];
+
   if (length)
     *length = track->length;
 
@@ -1135,7 +1577,6 @@ uint32_t
 mrl_sv_get_metadata_dvd_title (player_t *player, mrl_t *mrl,
                                int titleid, mrl_metadata_dvd_type_t m)
 {
-  int i;
   mrl_metadata_t *meta;
   mrl_metadata_dvd_t *dvd;
   mrl_metadata_dvd_title_t *title;
@@ -1164,14 +1605,12 @@ mrl_sv_get_metadata_dvd_title (player_t *player, mrl_t *mrl,
   if (!dvd)
     return 0;
 
-  title = dvd->title;
-  for (i = 1; i < titleid && title; i++)
-    title = title->next;
-
-  /* track unavailable */
-  if (i != titleid || !title)
+  /* title unavailable */
+  if (titleid < 1 || (uint32_t) titleid > dvd->title_nb)
     return 0;
 
+  title = &dvd->title[titleid - 1];
+
   switch (m)
   {
   case MRL_METADATA_DVD_TITLE_CHAPTERS:
@@ -1228,7 +1667,6 @@ int
 mrl_sv_get_metadata_subtitle (player_t *player, mrl_t *mrl, int pos,
                               uint32_t *id, char **name, char **lang)
 {
-  int i;
   mrl_metadata_t *meta;
   mrl_metadata_sub_t *sub;
 
@@ -1249,14 +1687,12 @@ mrl_sv_get_metadata_subtitle (player_t *player, mrl_t *mrl, int pos,
   if (!meta)
     return 0;
 
-  sub = meta->subs;
-  for (i = 1; i < pos && sub; i++)
-    sub = sub->next;
-
   /* subtitle unavailable */
-  if (i != pos || !sub)
+  if (pos < 1 || (uint32_t) pos > meta->subs_nb)
     return 0;
 
+  sub = &meta->subs[pos - 1];
+
   if (id)
     *id = sub->id;
   if (name)
@@ -1288,14 +1724,13 @@ mrl_sv_get_metadata_subtitle_nb (player_t *player, mrl_t *mrl)
   if (!meta)
     return 0;
 
-  RETURN_NB_ELEMENTS (meta->subs)
+  return meta->subs_nb;
 }
 
 int
 mrl_sv_get_metadata_audio (player_t *player, mrl_t *mrl, int pos,
                            uint32_t *id, char **name, char **lang)
 {
-  int i;
   mrl_metadata_t *meta;
   mrl_metadata_audio_t *audio;
 
@@ -1316,14 +1751,12 @@ mrl_sv_get_metadata_audio (player_t *player, mrl_t *mrl, int pos,
   if (!meta)
     return 0;
 
-  audio = meta->audio_streams;
-  for (i = 1; i < pos && audio; i++)
-    audio = audio->next;
-
-  /* subtitle unavailable */
-  if (i != pos || !audio)
+  /* audio stream unavailable */
+  if (pos < 1 || (uint32_t) pos > meta->audio_nb)
     return 0;
 
+  audio = &meta->audio_streams[pos - 1];
+
   if (id)
     *id = audio->id;
   if (name)
@@ -1355,7 +1788,7 @@ mrl_sv_get_metadata_audio_nb (player_t *player, mrl_t *mrl)
   if (!meta)
     return 0;
 
-  RETURN_NB_ELEMENTS (meta->audio_streams)
+  return meta->audio_nb;
 }
 
 mrl_type_t
@@ -1371,6 +1804,14 @@ mrl_sv_get_type (player_t *player, mrl_t *mrl)
   if (!mrl)
     return MRL_TYPE_UNKNOWN;
 
+  /* deferred by mrl_sv_new() */
+  if (!(mrl->facets & IDENTIFY_PROPERTIES))
+  {
+    mrl_retrieve_properties (player, mrl);
+    if (mrl->type == MRL_TYPE_UNKNOWN)
+      mrl->type = mrl_guess_type (mrl);
+  }
+
   return mrl->type;
 }
 
@@ -1421,14 +1862,12 @@ mrl_sv_add_subtitle (player_t *player, mrl_t *mrl, char *subtitle)
   mrl->subs[n - 1] = strdup (subtitle);
 }
 
-mrl_t *
-mrl_sv_new (player_t *player, mrl_resource_t res, void *args)
+static mrl_t *
+mrl_create (player_t *player, mrl_resource_t res, void *args, int probe)
 {
   mrl_t *mrl = NULL;
   int support = 0;
 
-  pl_log (player, PLAYER_MSG_VERBOSE, MODULE_NAME, __FUNCTION__);
-
   if (!player || !args)
     return NULL;
 
@@ -1453,6 +1892,15 @@ mrl_sv_new (player_t *player, mrl_resource_t res, void *args)
   mrl->resource = res;
   mrl->priv = args;
 
+  /*
+   * The probe of a network stream is deferred when the wrapper can retrieve
+   * the properties from its engine. Then the stream is opened only once if
+   * nothing is requested before the playback, see mrl_retrieve_deferred().
+   */
+  if (!probe
+      || (mrl_resource_is_network (res) && player->funcs->mrl_retrieve_live))
+    return mrl;
+
   mrl_retrieve_properties (player, mrl);
 
   mrl->type = mrl_guess_type (mrl);   /* can guess only if properties exist */
@@ -1460,6 +1908,24 @@ mrl_sv_new (player_t *player, mrl_resource_t res, void *args)
   return mrl;
 }
 
+mrl_t *
+mrl_sv_new (player_t *player, mrl_resource_t res, void *args)
+{
+  pl_log (player, PLAYER_MSG_VERBOSE, MODULE_NAME, __FUNCTION__);
+
+  return mrl_create (player, res, args, 1);
+}
+
+/*
+ * The MRL is probed only on demand (getters or playback), it is useful when
+ * a lot of MRLs are created at once, see pl_playlist_import().
+ */
+mrl_t *
+mrl_sv_new_lazy (player_t *player, mrl_resource_t res, void *args)
+{
+  return mrl_create (player, res, args, 0);
+}
+
 void
 mrl_sv_video_snapshot (player_t *player, mrl_t *mrl,
                        int pos, mrl_snapshot_t t, const char *dst)
@@ -1493,3 +1959,322 @@ mrl_sv_video_snapshot (player_t *player, mrl_t *mrl,
   /* player specific mrl_video_snapshot() */
   PLAYER_FUNCS (mrl_video_snapshot, mrl, pos, t, dst)
 }
+
+/*
+ * The header of the binary PPM (P6) is removed, only the RGB 24 bits
+ * pixels are kept in the buffer.
+ */
+int
+mrl_snapshot_ppm_unpack (mrl_snapshot_buffer_t *buf)
+{
+  const uint8_t *it, *end;
+  int val[3];
+  size_t size;
+  int i;
+
+  if (!buf || !buf->data || buf->size < 2)
+    return 0;
+
+  it  = buf->data;
+  end = buf->data + buf->size;
+
+  if (it[0] != 'P' || it[1] != '6')
+    return 0;
+  it += 2;
+
+  /* width, height and maximum value */
+  for (i = 0; i < 3; i++)
+  {
+    while (it < end && (isspace (*it) || *it == '#'))
+    {
+      if (*it == '#') /* comment until the end of the line */
+        while (it < end && *it != '\n')
+          it++;
+      else
+        it++;
+    }
+
+    if (it == end || !isdigit (*it))
+      return 0;
+
+    for (val[i] = 0; it < end && isdigit (*it); it++)
+    {
+      if (val[i] > 65535)
+        return 0;
+      val[i] = val[i] * 10 + *it - '0';
+    }
+  }
+
+  /* only one whitespace before the pixels */
+  if (it == end || !isspace (*it))
+    return 0;
+  it++;
+
+  if (val[0] <= 0 || val[1] <= 0 || val[2] != 255)
+    return 0;
+
+  size = (size_t) val[0] * val[1] * 3;
+  if ((size_t) (end - it) < size)
+    return 0;
+
+  memmove (buf->data, it, size);
+  buf->type   = MRL_SNAPSHOT_RGB24;
+  buf->size   = size;
+  buf->width  = val[0];
+  buf->height = val[1];
+  buf->stride = val[0] * 3;
+  return 1;
+}
+
+int
+mrl_sv_video_snapshot_to_buffer (player_t *player, mrl_t *mrl, int pos,
+                                 mrl_snapshot_t t, mrl_snapshot_buffer_t *buf)
+{
+  char tmp[] = "/tmp/libplayer.XXXXXX";
+  char file[64];
+  mrl_snapshot_t type;
+
+  pl_log (player, PLAYER_MSG_VERBOSE, MODULE_NAME, __FUNCTION__);
+
+  if (!player || !buf)
+    return 0;
+
+  memset (buf, 0, sizeof (*buf));
+
+  /* try to use internal mrl? */
+  mrl_use_internal (player, &mrl);
+  if (!mrl)
+    return 0;
+
+  if (mrl_sv_get_type (player, mrl) != MRL_TYPE_VIDEO)
+    return 0;
+
+  /* player specific mrl_video_snapshot_buffer() */
+  if (player->funcs->mrl_video_snapshot_buffer)
+    return player->funcs->mrl_video_snapshot_buffer (player, mrl, pos, t, buf);
+
+  if (!player->funcs->mrl_video_snapshot)
+  {
+    PLAYER_FUNCS_WARN (mrl_video_snapshot_buffer);
+    return 0;
+  }
+
+  /* else read the file written by the player specific mrl_video_snapshot() */
+  if (!mkdtemp (tmp))
+    return 0;
+
+  snprintf (file, sizeof (file), "%s/snapshot", tmp);
+  type = t == MRL_SNAPSHOT_RGB24 ? MRL_SNAPSHOT_PPM : t;
+
+  player->funcs->mrl_video_snapshot (player, mrl, pos, type, file);
+  buf->data = pl_read_file (file, &buf->size);
+  buf->type = type;
+
+  unlink (file);
+  rmdir (tmp);
+
+  if (!buf->data)
+    return 0;
+
+  if (t == MRL_SNAPSHOT_RGB24 && !mrl_snapshot_ppm_unpack (buf))
+  {
+    PFREE (buf->data);
+    buf->size = 0;
+    return 0;
+  }
+
+  return 1;
+}
+
+/*
+ * The pattern must have exactly one integer conversion for the index of
+ * the position, like "thumb-%02i.jpg".
+ */
+static int
+mrl_snapshot_pattern_check (const char *pattern)
+{
+  const char *it;
+  int conv = 0;
+
+  it = strrchr (pattern, '/');
+  if (it && *(it + 1) == '\0')
+    return -1;
+
+  for (it = strchr (pattern, '%'); it; it = strchr (it, '%'))
+  {
+    it++;
+    if (*it == '%')
+    {
+      it++;
+      continue;
+    }
+
+    it += strspn (it, "-+ 0");
+    it += strspn (it, "0123456789");
+    if (*it != 'd' && *it != 'i')
+      return -1;
+
+    conv++;
+  }
+
+  return conv == 1 ? 0 : -1;
+}
+
+void
+mrl_sv_video_snapshot_batch (player_t *player, mrl_t *mrl,
+                             const int *pos, int n,
+                             mrl_snapshot_t t, const char *dst)
+{
+  char pattern[32];
+  int i;
+
+  pl_log (player, PLAYER_MSG_VERBOSE, MODULE_NAME, __FUNCTION__);
+
+  if (!player || !pos || n <= 0)
+    return;
+
+  /* default filenames in the current directory */
+  if (!dst)
+  {
+    static const char *const ext[] = {
+      [MRL_SNAPSHOT_JPG] = "jpg",
+      [MRL_SNAPSHOT_PNG] = "png",
+      [MRL_SNAPSHOT_PPM] = "ppm",
+      [MRL_SNAPSHOT_TGA] = "tga",
+    };
+
+    if ((unsigned int) t >= ARRAY_NB_ELEMENTS (ext))
+      return;
+
+    snprintf (pattern, sizeof (pattern), "snapshot-%%i.%s", ext[t]);
+    dst = pattern;
+  }
+  else if (mrl_snapshot_pattern_check (dst))
+  {
+    pl_log (player, PLAYER_MSG_ERROR, MODULE_NAME,
+            "the destination (%s) must be a file pattern with one %%i", dst);
+    return;
+  }
+
+  /* try to use internal mrl? */
+  mrl_use_internal (player, &mrl);
+  if (!mrl)
+    return;
+
+  if (mrl_sv_get_type (player, mrl) != MRL_TYPE_VIDEO)
+    return;
+
+  /* player specific mrl_video_snapshot_batch() */
+  if (player->funcs->mrl_video_snapshot_batch)
+  {
+    player->funcs->mrl_video_snapshot_batch (player, mrl, pos, n, t, dst);
+    return;
+  }
+
+  /* one snapshot after the other */
+  for (i = 0; i < n; i++)
+  {
+    char file[512];
+
+    snprintf (file, sizeof (file), dst, i);
+    PLAYER_FUNCS (mrl_video_snapshot, mrl, pos[i], t, file)
+  }
+}
+
+static void *
+mrl_probe_thread (void *arg)
+{
+  mrl_probe_batch_t *batch = arg;
+  player_t *player = batch->player;
+
+  while (1)
+  {
+    mrl_t *mrl;
+    int pos;
+
+    pthread_mutex_lock (&batch->mutex);
+    pos = batch->next++;
+    pthread_mutex_unlock (&batch->mutex);
+
+    if (pos >= batch->n)
+      break;
+
+    mrl = batch->list[pos];
+    if (!mrl)
+      continue;
+
+    /* not from the supervisor thread, then never from the engine */
+    if (batch->flags & MRL_PROBE_PROPERTIES)
+    {
+      mrl_probe (player, mrl, IDENTIFY_PROPERTIES, 0);
+      if (mrl->type == MRL_TYPE_UNKNOWN)
+        mrl->type = mrl_guess_type (mrl);
+    }
+
+    if (batch->flags & MRL_PROBE_METADATA)
+      mrl_probe (player, mrl, IDENTIFY_METADATA, 0);
+
+    if (batch->cb)
+      batch->cb (mrl, pos, batch->data);
+  }
+
+  return NULL;
+}
+
+void
+mrl_sv_probe_batch (player_t *player, mrl_t **list, int n, int flags,
+                    mrl_probe_cb_t cb, void *data)
+{
+  mrl_probe_batch_t batch;
+  pthread_t *th = NULL;
+  int workers, i, nb = 0;
+
+  pl_log (player, PLAYER_MSG_VERBOSE, MODULE_NAME, __FUNCTION__);
+
+  if (!player || !list || n <= 0)
+    return;
+
+  workers = player->probe_workers;
+  if (workers <= 0)
+    workers = (int) sysconf (_SC_NPROCESSORS_ONLN);
+  if (workers > n)
+    workers = n;
+  if (workers < 1)
+    workers = 1;
+
+  batch.player = player;
+  batch.list   = list;
+  batch.n      = n;
+  batch.flags  = flags;
+  batch.cb     = cb;
+  batch.data   = data;
+  batch.next   = 0;
+  pthread_mutex_init (&batch.mutex, NULL);
+
+  pl_log (player, PLAYER_MSG_INFO, MODULE_NAME,
+          "probe %i MRL with %i worker(s)", n, workers);
+
+  /* the current thread is the first worker */
+  if (workers > 1)
+    th = PCALLOC (pthread_t, workers - 1);
+
+  if (th)
+    for (i = 0; i < workers - 1; i++)
+    {
+      if (pthread_create (&th[nb], NULL, mrl_probe_thread, &batch))
+      {
+        pl_log (player, PLAYER_MSG_WARNING,
+                MODULE_NAME, "unable to create more probe workers");
+        break;
+      }
+      nb++;
+    }
+
+  mrl_probe_thread (&batch);
+
+  for (i = 0; i < nb; i++)
+    pthread_join (th[i], NULL);
+
+  PFREE (th);
+  pthread_mutex_destroy (&batch.mutex);
+}
@@ -56,6 +56,7 @@ player_event_cb (void *data, int e)
   int res = 0;
   player_t *player = data;
   player_pb_t pb_mode = PLAYER_PB_SINGLE;
+  int gapless = 0;
 
   pl_log (player, PLAYER_MSG_VERBOSE, MODULE_NAME, "internal event: %i", e);
 
@@ -77,15 +78,16 @@ player_event_cb (void *data, int e)
   {
     player->state = PLAYER_STATE_IDLE;
     pb_mode = player->pb_mode;
+    gapless = player->gapless;
   }
 
   /* release for supervisor */
   pl_event_handler_sync_release (player->event);
 
-  /* go to the next MRL */
-  if (pb_mode == PLAYER_PB_AUTO)
+  /* go to the next MRL (or drop the preloaded MRL with gapless) */
+  if (pb_mode == PLAYER_PB_AUTO || gapless)
     pl_supervisor_send (player, SV_MODE_NO_WAIT,
-                        SV_FUNC_PLAYER_MRL_NEXT_PLAY, NULL, NULL);
+                        SV_FUNC_PLAYER_MRL_FINISHED, NULL, NULL);
 
   return res;
 }
@@ -134,9 +136,27 @@ player_init (player_type_t type,
     player->event_cb    = param->event_cb;
     player->user_data   = param->data;
     player->quality     = param->quality;
+    player->probe_workers = param->probe_workers;
+    player->probe_cache_path =
+      param->probe_cache ? strdup (param->probe_cache) : NULL;
+    player->probe_cache_size = param->probe_cache_size;
+    player->metadata_pack    = param->metadata_pack;
+    player->gapless          = param->gapless;
+    player->audio_only       = param->audio_only;
+    player->frame_cb         = param->frame_cb;
+    player->frame_ring       = param->frame_ring;
+    player->audio_cb         = param->audio_cb;
+    player->audio_meter_cb   = param->audio_meter_cb;
+    player->audio_meter_interval = param->audio_meter_interval;
   }
 
+  /* no video output then no window (see pl_window_register()) */
+  if (player->audio_only)
+    player->vo = PLAYER_VO_NULL;
+
   pthread_mutex_init (&player->mutex_verb, NULL);
+  pthread_mutex_init (&player->mutex_probe, NULL);
+  pthread_cond_init (&player->cond_probe, NULL);
 
   switch (player->type)
   {
@@ -252,7 +272,10 @@ player_uninit (player_t *player)
   pl_supervisor_uninit (player);
 
   pl_playlist_free (player->playlist);
+  PFREE (player->probe_cache_path);
   pthread_mutex_destroy (&player->mutex_verb);
+  pthread_mutex_destroy (&player->mutex_probe);
+  pthread_cond_destroy (&player->cond_probe);
   PFREE (player->funcs);
   PFREE (player);
 }
@@ -320,6 +343,81 @@ player_mrl_append (player_t *player, mrl_t *mrl, player_mrl_add_t when)
                       SV_FUNC_PLAYER_MRL_APPEND, &in, NULL);
 }
 
+void
+player_mrl_append_bulk (player_t *player,
+                        mrl_t **list, int n, player_mrl_add_t when)
+{
+  supervisor_data_mrl_bulk_t in;
+
+  pl_log (player, PLAYER_MSG_VERBOSE, MODULE_NAME, __FUNCTION__);
+
+  if (!player || !list || n <= 0)
+    return;
+
+  in.list  = list;
+  in.n     = n;
+  in.value = when;
+
+  pl_supervisor_send (player, SV_MODE_WAIT_FOR_END,
+                      SV_FUNC_PLAYER_MRL_APPEND_BULK, &in, NULL);
+}
+
+int
+player_playlist_import (player_t *player, const char *path,
+                        player_mrl_add_t when,
+                        player_playlist_import_cb_t cb, void *data)
+{
+  supervisor_data_playlist_import_t in;
+  int res = -1;
+
+  pl_log (player, PLAYER_MSG_VERBOSE, MODULE_NAME, __FUNCTION__);
+
+  if (!player || !path)
+    return -1;
+
+  in.path  = path;
+  in.value = when;
+  in.cb    = cb;
+  in.data  = data;
+
+  pl_supervisor_send (player, SV_MODE_WAIT_FOR_END,
+                      SV_FUNC_PLAYER_PLAYLIST_IMPORT, &in, &res);
+
+  return res;
+}
+
+int
+player_playlist_save (player_t *player, const char *path)
+{
+  int res = -1;
+
+  pl_log (player, PLAYER_MSG_VERBOSE, MODULE_NAME, __FUNCTION__);
+
+  if (!player || !path)
+    return -1;
+
+  pl_supervisor_send (player, SV_MODE_WAIT_FOR_END,
+                      SV_FUNC_PLAYER_PLAYLIST_SAVE, (void *) path, &res);
+
+  return res;
+}
+
+int
+player_playlist_load (player_t *player, const char *path)
+{
+  int res = -1;
+
+  pl_log (player, PLAYER_MSG_VERBOSE, MODULE_NAME, __FUNCTION__);
+
+  if (!player || !path)
+    return -1;
+
+  pl_supervisor_send (player, SV_MODE_WAIT_FOR_END,
+                      SV_FUNC_PLAYER_PLAYLIST_LOAD, (void *) path, &res);
+
+  return res;
+}
+
 void
 player_mrl_remove (player_t *player)
 {
@@ -368,6 +466,18 @@ player_mrl_next (player_t *player)
                       SV_FUNC_PLAYER_MRL_NEXT, NULL, NULL);
 }
 
+void
+player_mrl_goto (player_t *player, int index)
+{
+  pl_log (player, PLAYER_MSG_VERBOSE, MODULE_NAME, __FUNCTION__);
+
+  if (!player)
+    return;
+
+  pl_supervisor_send (player, SV_MODE_WAIT_FOR_END,
+                      SV_FUNC_PLAYER_MRL_GOTO, &index, NULL);
+}
+
 void
 player_mrl_continue (player_t *player)
 {
@@ -541,6 +651,19 @@ player_osd_state (player_t *player, int value)
                       SV_FUNC_PLAYER_OSD_STATE, &value, NULL);
 }
 
+void
+player_probe_cache_get_stats (player_t *player,
+                              player_probe_cache_stats_t *stats)
+{
+  pl_log (player, PLAYER_MSG_VERBOSE, MODULE_NAME, __FUNCTION__);
+
+  if (!player || !stats)
+    return;
+
+  pl_supervisor_send (player, SV_MODE_WAIT_FOR_END,
+                      SV_FUNC_PLAYER_PROBE_CACHE_STATS, NULL, stats);
+}
+
 /***************************************************************************/
 /*                                                                         */
 /* Playback related controls                                               */
@@ -575,6 +698,18 @@ player_playback_start (player_t *player)
                       SV_FUNC_PLAYER_PB_START, NULL, NULL);
 }
 
+void
+player_playback_prepare (player_t *player, mrl_t *mrl)
+{
+  pl_log (player, PLAYER_MSG_VERBOSE, MODULE_NAME, __FUNCTION__);
+
+  if (!player || !mrl)
+    return;
+
+  pl_supervisor_send (player, SV_MODE_WAIT_FOR_END,
+                      SV_FUNC_PLAYER_PB_PREPARE, mrl, NULL);
+}
+
 void
 player_playback_stop (player_t *player)
 {
@@ -132,6 +132,8 @@ typedef enum player_vo {
   PLAYER_VO_VDPAU,
   PLAYER_VO_VAAPI,
   PLAYER_VO_V4L2,
+  /** Decoded frames to player_init_param_t::frame_cb, no window. */
+  PLAYER_VO_FRAMES,
 } player_vo_t;
 
 /** \brief Player audio outputs. */
@@ -170,6 +172,46 @@ typedef enum {
   PLAYER_QUALITY_LOWEST,    /* degraded picture, suitable for low-end CPU */
 } player_quality_level_t;
 
+/** \brief Pixel formats of the decoded frames (::PLAYER_VO_FRAMES). */
+typedef enum player_frame_format {
+  PLAYER_FRAME_I420,        /**< Planar YUV 4:2:0 (Y, U then V).      */
+  PLAYER_FRAME_YUY2,        /**< Packed YUV 4:2:2 (one plane).        */
+} player_frame_format_t;
+
+/** \brief Decoded frame, see player_init_param_t::frame_cb. */
+typedef struct player_frame_s {
+  player_frame_format_t format; /**< Pixel format.                    */
+  int width;                /**< Width (pixels).                         */
+  int height;               /**< Height (pixels).                        */
+  uint8_t *plane[3];        /**< Planes, unused planes are NULL.         */
+  int stride[3];            /**< Bytes per line for each plane.          */
+  int64_t pts;              /**< Presentation time (ms), -1 if unknown.  */
+  uint32_t seq;             /**< Sequence number, a gap is a drop.       */
+  int fd;                   /**< Buffer for mmap, -1 if not shareable.   */
+  size_t size;              /**< Size of the buffer behind \p fd.        */
+  size_t offset[3];         /**< Offset of the planes in \p fd.          */
+} player_frame_t;
+
+/** \brief Block of decoded audio, see player_init_param_t::audio_cb. */
+typedef struct player_audio_s {
+  const int16_t *pcm;       /**< Interleaved samples (signed 16 bits).   */
+  int frames;               /**< Number of samples for each channel.     */
+  int channels;             /**< Number of channels.                     */
+  int rate;                 /**< Sample rate (Hz).                       */
+  int64_t pts;              /**< Presentation time (ms), -1 if unknown.  */
+} player_audio_t;
+
+/** \brief Maximum number of channels with the audio meters. */
+#define PLAYER_AUDIO_METER_CHANNELS 8
+
+/** \brief Audio levels, see player_init_param_t::audio_meter_cb. */
+typedef struct player_audio_meter_s {
+  int channels;             /**< Number of channels measured.            */
+  float peak[PLAYER_AUDIO_METER_CHANNELS]; /**< Peak (0.0 to 1.0).       */
+  float rms[PLAYER_AUDIO_METER_CHANNELS];  /**< RMS level (0.0 to 1.0).  */
+  int64_t pts;              /**< Time of the last sample (ms), or -1.    */
+} player_audio_meter_t;
+
 /** \brief Parameters for player_init() .*/
 typedef struct player_init_param_s {
   /** Audio output driver. */
@@ -181,7 +223,7 @@ typedef struct player_init_param_s {
 
   /** Public event callback. */
   int (*event_cb) (player_event_t e, void *data);
-  /** User data for event callback. */
+  /** User data for event, frame and audio callbacks. */
   void *data;
 
   /**
@@ -196,6 +238,123 @@ typedef struct player_init_param_s {
   /** Picture decoding quality. */
   player_quality_level_t quality;
 
+  /**
+   * Maximum number of parallel probes with mrl_probe_batch().
+   *
+   * When \p probe_workers is 0, the number of online processors is used.
+   */
+  int probe_workers;
+
+  /**
+   * Location of the probe cache file, NULL to disable the cache.
+   *
+   * The properties and the metadata of the local files are saved in this
+   * file, and reused as long as the size and the modification time of the
+   * files are not changed. The same file can be shared by several player
+   * controllers, even in different processes (the file is locked with
+   * flock, then it must not be on a file system without locks support).
+   * The string is copied.
+   */
+  const char *probe_cache;
+
+  /** Maximum size of the probe cache file (byte), 0 for default (16 MiB). */
+  off_t probe_cache_size;
+
+  /**
+   * Share the metadata strings between the MRLs.
+   *
+   * When \p metadata_pack is not 0, the artist, genre, album, year, track
+   * and the names and languages of the streams are saved only once in a
+   * pool shared by all player controllers. The metadata of each MRL is
+   * packed in one allocation. It is useful with big libraries where most of
+   * these strings are duplicates.
+   */
+  int metadata_pack;
+
+  /**
+   * Gapless playback with the playback mode ::PLAYER_PB_AUTO.
+   *
+   * When \p gapless is not 0, the next MRL of the playlist is preloaded by
+   * the wrapper while the current one is playing, then the wrapper switches
+   * to it without the delay of a new start at the end of the stream. The
+   * events ::PLAYER_EVENT_PLAYBACK_FINISHED and ::PLAYER_EVENT_PLAYBACK_START
+   * are sent as usual.
+   *
+   * Wrappers supported (even partially):
+   *  GStreamer, MPlayer, xine
+   */
+  int gapless;
+
+  /**
+   * Audio-only player controller.
+   *
+   * When \p audio_only is not 0, the video of the streams is never decoded
+   * and no window is created, then the player starts faster and uses less
+   * memory. The video output \p vo is ignored.
+   *
+   * Wrappers supported (even partially):
+   *  GStreamer, MPlayer, VLC, xine
+   */
+  int audio_only;
+
+  /**
+   * Frame callback with the video output ::PLAYER_VO_FRAMES.
+   *
+   * The decoded frames are written in a ring of buffers and \p frame_cb is
+   * called for each frame, in order, from a dedicated thread. The pixels
+   * are not copied for the callback, then \p frame is only valid until
+   * \p frame_cb returns. When the callback is slower than the decoder and
+   * the ring is full, the new frames are dropped (see player_frame_t::seq)
+   * but the decoding is never stalled.
+   *
+   * The buffers of the ring are memory file descriptors (memfd) which can
+   * be passed to an other process (SCM_RIGHTS) and mapped there with
+   * player_frame_t::fd, player_frame_t::size and player_frame_t::offset.
+   * A buffer is reused for the next frames; its content is only stable
+   * while \p frame_cb runs. The fd is -1 when the frame is in a buffer of
+   * the engine (GStreamer) or without memfd support.
+   *
+   * Wrappers supported (even partially):
+   *  GStreamer, MPlayer, VLC, xine
+   */
+  void (*frame_cb) (const player_frame_t *frame, void *data);
+
+  /** Number of frames in the ring of \p frame_cb, 0 for default (4). */
+  int frame_ring;
+
+  /**
+   * Audio tap callback.
+   *
+   * When \p audio_cb is not NULL, the decoded audio is given to this
+   * callback by blocks of interleaved samples (signed 16 bits, native
+   * endianness). The callback is called from the audio path of the wrapper,
+   * it must return quickly and \p audio is only valid until it returns.
+   *
+   * With GStreamer and MPlayer, the audio is still sent to the audio output
+   * \p ao. MPlayer exports only some blocks of samples (enough for meters,
+   * not for a recording) and their time follows the clock from the last
+   * start or seek. With VLC, the tap replaces the audio output (libvlc can
+   * not keep both), then nothing is heard.
+   *
+   * Wrappers supported (even partially):
+   *  GStreamer, MPlayer, VLC
+   */
+  void (*audio_cb) (const player_audio_t *audio, void *data);
+
+  /**
+   * Audio meters callback.
+   *
+   * When \p audio_meter_cb is not NULL, the peak and RMS levels of each
+   * channel of the audio tap are computed (with SSE2 or AVX2 if the CPU
+   * supports it) and given to this callback every \p audio_meter_interval
+   * milliseconds. It is called from the same thread as \p audio_cb, which
+   * can be NULL.
+   */
+  void (*audio_meter_cb) (const player_audio_meter_t *meter, void *data);
+
+  /** Period of \p audio_meter_cb (ms), 0 for default (50 ms). */
+  int audio_meter_interval;
+
 } player_init_param_t;
 
 /**
@@ -374,12 +533,24 @@ typedef struct mrl_resource_network_args_s {
 
 /** \brief Snapshot image file type. */
 typedef enum mrl_snapshot {
-  MRL_SNAPSHOT_JPG,         /*  NO           YES          NO           NO   */
-  MRL_SNAPSHOT_PNG,         /*  NO           YES          NO           NO   */
-  MRL_SNAPSHOT_PPM,         /*  NO           YES          NO           NO   */
+  MRL_SNAPSHOT_JPG,         /*  YES          YES          NO           NO   */
+  MRL_SNAPSHOT_PNG,         /*  YES          YES          YES          NO   */
+  MRL_SNAPSHOT_PPM,         /*  YES          YES          YES          YES  */
   MRL_SNAPSHOT_TGA,         /*  NO           NO           NO           NO   */
+  /** Raw RGB 24 bits pixels, only with mrl_video_snapshot_to_buffer(). */
+  MRL_SNAPSHOT_RGB24,       /*  YES          YES          YES          YES  */
 } mrl_snapshot_t;
 
+/** \brief Video snapshot in memory, see mrl_video_snapshot_to_buffer(). */
+typedef struct mrl_snapshot_buffer_s {
+  mrl_snapshot_t type;      /**< Type of the image in \p data.           */
+  uint8_t *data;            /**< Image file or raw pixels.               */
+  size_t size;              /**< Size of \p data (bytes).                */
+  int width;                /**< Width (pixels), only for raw pixels.    */
+  int height;               /**< Height (pixels), only for raw pixels.   */
+  int stride;               /**< Bytes per line, only for raw pixels.    */
+} mrl_snapshot_buffer_t;
+
 /** \brief MRL metadata. */
 typedef enum mrl_metadata_type {
   MRL_METADATA_TITLE,
@@ -421,6 +592,121 @@ typedef enum mrl_properties_type {
   MRL_PROPERTY_VIDEO_FRAMEDURATION,
 } mrl_properties_type_t;
 
+/** \brief Version of ::mrl_properties_all_t known by libplayer. */
+#define MRL_PROPERTIES_ALL_VERSION 1
+
+/** \brief All properties of a MRL, see mrl_get_properties_all(). */
+typedef struct mrl_properties_all_s {
+  /** Version of the structure, must be set by the caller. */
+  int version;
+
+  /** Type of MRL object. */
+  mrl_type_t type;
+  /** Size of the stream (bytes). */
+  off_t size;
+  /** Seekable stream. */
+  uint32_t seekable;
+  /** Length of the stream (millisecond). */
+  uint32_t length;
+
+  /** Audio codec name, NULL otherwise. */
+  const char *audio_codec;
+  uint32_t audio_bitrate;
+  uint32_t audio_bits;
+  uint32_t audio_channels;
+  uint32_t audio_samplerate;
+
+  /** Video codec name, NULL otherwise. */
+  const char *video_codec;
+  uint32_t video_bitrate;
+  uint32_t video_width;
+  uint32_t video_height;
+  uint32_t video_aspect;
+  uint32_t video_channels;
+  uint32_t video_streams;
+  uint32_t video_frameduration;
+
+  /** Internal storage, see mrl_properties_all_release(). */
+  void *priv;
+} mrl_properties_all_t;
+
+/** \brief Version of ::mrl_metadata_all_t known by libplayer. */
+#define MRL_METADATA_ALL_VERSION 2
+
+/** \brief Subtitle or audio stream, see ::mrl_metadata_all_t. */
+typedef struct mrl_metadata_stream_all_s {
+  /** Stream ID as used by the wrapper. */
+  uint32_t id;
+  /** Name and language, NULL otherwise. */
+  const char *name;
+  const char *lang;
+} mrl_metadata_stream_all_t;
+
+/** \brief Audio CD track, see ::mrl_metadata_all_t. */
+typedef struct mrl_metadata_track_all_s {
+  /** Track name, NULL otherwise. */
+  const char *name;
+  /** Length in milliseconds. */
+  uint32_t length;
+} mrl_metadata_track_all_t;
+
+/** \brief DVD title, see ::mrl_metadata_all_t. */
+typedef struct mrl_metadata_title_all_s {
+  uint32_t chapters;
+  uint32_t angles;
+  /** Length in milliseconds. */
+  uint32_t length;
+} mrl_metadata_title_all_t;
+
+/** \brief All metadata of a MRL, see mrl_get_metadata_all(). */
+typedef struct mrl_metadata_all_s {
+  /** Version of the structure, must be set by the caller. */
+  int version;
+
+  /** Metadata strings, NULL otherwise. */
+  const char *title;
+  const char *artist;
+  const char *genre;
+  const char *album;
+  const char *year;
+  const char *track;
+  const char *comment;
+
+  /** Number of subtitles. */
+  uint32_t subtitle_nb;
+  /** Number of audio streams. */
+  uint32_t audio_nb;
+
+  /** Internal storage, see mrl_metadata_all_release(). */
+  void *priv;
+
+  /* Version 2 */
+
+  /** Subtitles (\p subtitle_nb entries), NULL otherwise. */
+  const mrl_metadata_stream_all_t *subtitles;
+  /** Audio streams (\p audio_nb entries), NULL otherwise. */
+  const mrl_metadata_stream_all_t *audio_streams;
+
+  /** Number of audio CD tracks. */
+  uint32_t cd_track_nb;
+  /** Audio CD tracks, ordered by position, NULL otherwise. */
+  const mrl_metadata_track_all_t *cd_tracks;
+
+  /** Number of DVD titles. */
+  uint32_t dvd_title_nb;
+  /** DVD titles, ordered by position, NULL otherwise. */
+  const mrl_metadata_title_all_t *dvd_titles;
+} mrl_metadata_all_t;
+
+/** \brief MRL probe flags. */
+typedef enum mrl_probe {
+  MRL_PROBE_PROPERTIES = (1 << 0),
+  MRL_PROBE_METADATA   = (1 << 1),
+} mrl_probe_t;
+
+/** \brief Callback for each MRL probed by mrl_probe_batch(). */
+typedef void (*mrl_probe_cb_t) (mrl_t *mrl, int pos, void *data);
+
 #define PLAYER_VIDEO_ASPECT_RATIO_MULT         10000.0    /* *10000         */
 #define PLAYER_VIDEO_FRAMEDURATION_RATIO_DIV   90000.0    /* 1/90000 sec    */
 
@@ -459,8 +745,8 @@ void mrl_add_subtitle (player_t *player, mrl_t *mrl, char *subtitle);
 /**
  * \brief Free a MRL object.
  *
- * Never use this function when the MRL (or a linked MRL) is set in the
- * playlist of a player controller.
+ * Never use this function when the MRL is set in the playlist of a player
+ * controller.
  *
  * \warning Must be used only as the last mrl function for one MRL object.
  * \warning MT-Safe in multithreaded applications (see \ref mtlevel).
@@ -713,13 +999,79 @@ char *mrl_get_video_codec (player_t *player, mrl_t *mrl);
  */
 off_t mrl_get_size (player_t *player, mrl_t *mrl);
 
+/**
+ * \brief Get all properties of the stream.
+ *
+ * All properties are retrieved at once, instead of calling
+ * mrl_get_property(), mrl_get_audio_codec() and mrl_get_video_codec() for
+ * each value.
+ *
+ * The field \p version of \p prop must be set to
+ * ::MRL_PROPERTIES_ALL_VERSION before the call. Only the fields known by
+ * both libplayer and the caller are set.
+ *
+ * Wrappers supported (even partially):
+ *  GStreamer, MPlayer, VLC, xine
+ *
+ * \warning The structure must be released with mrl_properties_all_release().
+ * \warning MT-Safe in multithreaded applications (see \ref mtlevel).
+ * \param[in] player      Player controller.
+ * \param[in] mrl         MRL object, NULL for current.
+ * \param[in,out] prop    Properties.
+ * \return Version of the structure set by libplayer, 0 otherwise.
+ */
+int mrl_get_properties_all (player_t *player,
+                            mrl_t *mrl, mrl_properties_all_t *prop);
+
+/**
+ * \brief Release the strings of properties.
+ *
+ * \param[in] prop        Properties set by mrl_get_properties_all().
+ */
+void mrl_properties_all_release (mrl_properties_all_t *prop);
+
+/**
+ * \brief Get all metadata of the stream.
+ *
+ * All metadata are retrieved at once, instead of calling mrl_get_metadata()
+ * for each value.
+ *
+ * The field \p version of \p meta must be set to
+ * ::MRL_METADATA_ALL_VERSION before the call. Only the fields known by
+ * both libplayer and the caller are set.
+ *
+ * Since the version 2, the subtitles, the audio streams, the audio CD tracks
+ * and the DVD titles are enumerated by the same call.
+ *
+ * This function can be slow when the stream is not (fastly) reachable.
+ *
+ * Wrappers supported (even partially):
+ *  GStreamer, MPlayer, VLC, xine
+ *
+ * \warning The structure must be released with mrl_metadata_all_release().
+ * \warning MT-Safe in multithreaded applications (see \ref mtlevel).
+ * \param[in] player      Player controller.
+ * \param[in] mrl         MRL object, NULL for current.
+ * \param[in,out] meta    Metadata.
+ * \return Version of the structure set by libplayer, 0 otherwise.
+ */
+int mrl_get_metadata_all (player_t *player,
+                          mrl_t *mrl, mrl_metadata_all_t *meta);
+
+/**
+ * \brief Release the strings of metadata.
+ *
+ * \param[in] meta        Metadata set by mrl_get_metadata_all().
+ */
+void mrl_metadata_all_release (mrl_metadata_all_t *meta);
+
 /**
  * \brief Take a video snapshot.
  *
  * One frame at the \p pos (in second) is saved to \p dst.
  *
  * Wrappers supported (even partially):
- *  MPlayer, VLC
+ *  GStreamer, MPlayer, VLC, xine
  *
  * \warning MT-Safe in multithreaded applications (see \ref mtlevel).
  * \param[in] player      Player controller.
@@ -732,6 +1084,91 @@ off_t mrl_get_size (player_t *player, mrl_t *mrl);
 void mrl_video_snapshot (player_t *player, mrl_t *mrl,
                          int pos, mrl_snapshot_t t, const char *dst);
 
+/**
+ * \brief Take a video snapshot in memory.
+ *
+ * One frame at the \p pos (in second) is returned in \p buf instead of
+ * a file. With ::MRL_SNAPSHOT_RGB24, the raw pixels are returned with the
+ * size of the frame and the stride, else \p buf contains the same data
+ * that mrl_video_snapshot() would write in the file.
+ *
+ * Wrappers supported (even partially):
+ *  GStreamer, MPlayer, VLC, xine
+ *
+ * \warning The buffer must be released with mrl_snapshot_buffer_release().
+ * \warning MT-Safe in multithreaded applications (see \ref mtlevel).
+ * \param[in] player      Player controller.
+ * \param[in] mrl         MRL object, NULL for current.
+ * \param[in] pos         Time position (second).
+ * \param[in] t           Image type.
+ * \param[out] buf        Snapshot.
+ * \return 1 for success, 0 if the snapshot is not available.
+ */
+int mrl_video_snapshot_to_buffer (player_t *player, mrl_t *mrl, int pos,
+                                  mrl_snapshot_t t, mrl_snapshot_buffer_t *buf);
+
+/**
+ * \brief Release the data of a snapshot in memory.
+ *
+ * \param[in] buf         Snapshot filled by mrl_video_snapshot_to_buffer().
+ */
+void mrl_snapshot_buffer_release (mrl_snapshot_buffer_t *buf);
+
+/**
+ * \brief Take several video snapshots at once.
+ *
+ * One frame for each position of \p pos (in second) is saved. Unlike
+ * mrl_video_snapshot(), all frames are extracted by the same decoder
+ * session when the wrapper supports it, the stream is opened only once.
+ *
+ * The destination \p dst is a pattern with exactly one integer conversion
+ * (\%i or \%d, with optional flags and width) which is replaced by the index
+ * of the position in \p pos. For example "thumb-\%02i.jpg".
+ *
+ * Wrappers supported (even partially):
+ *  GStreamer, MPlayer, VLC, xine
+ *
+ * \warning MT-Safe in multithreaded applications (see \ref mtlevel).
+ * \param[in] player      Player controller.
+ * \param[in] mrl         MRL object, NULL for current.
+ * \param[in] pos         Array of time positions (second).
+ * \param[in] n           Number of positions in \p pos.
+ * \param[in] t           Image file type.
+ * \param[in] dst         Destination file pattern, NULL for
+ *                        "snapshot-\%i.<ext>" in the current directory.
+ */
+void mrl_video_snapshot_batch (player_t *player, mrl_t *mrl,
+                               const int *pos, int n,
+                               mrl_snapshot_t t, const char *dst);
+
+/**
+ * \brief Probe a list of MRL objects in parallel.
+ *
+ * The properties and (or) the metadata of the \p n MRL objects in \p list
+ * are retrieved by several probes running at the same time. The number of
+ * parallel probes is limited by player_init_param_t::probe_workers.
+ * MRL objects already probed are not probed again.
+ *
+ * The callback \p cb is called as soon as one MRL is probed, \p pos is the
+ * position of this MRL in \p list. Because the callback is called from an
+ * internal thread of libplayer, it must never use the player controller.
+ *
+ * This function returns only when all MRL objects are probed.
+ *
+ * Wrappers supported (even partially):
+ *  GStreamer, MPlayer, VLC, xine
+ *
+ * \warning MT-Safe in multithreaded applications (see \ref mtlevel).
+ * \param[in] player      Player controller.
+ * \param[in] list        Array of MRL objects.
+ * \param[in] n           Number of MRL objects in \p list.
+ * \param[in] flags       What to probe (::mrl_probe_t).
+ * \param[in] cb          Completion callback, NULL to ignore.
+ * \param[in] data        User data for the callback.
+ */
+void mrl_probe_batch (player_t *player, mrl_t **list, int n, int flags,
+                      mrl_probe_cb_t cb, void *data);
+
 /**
  * @}
  */
@@ -748,6 +1185,19 @@ typedef enum player_mrl_add {
   PLAYER_MRL_ADD_QUEUE
 } player_mrl_add_t;
 
+/**
+ * \brief Callback for the progress of a playlist import.
+ *
+ * \warning This callback is called by an internal thread of libplayer. The
+ *          player controller must never be used in the callback.
+ * \param[in] entries    Number of MRL objects already appended.
+ * \param[in] pos        Position in bytes in the playlist file.
+ * \param[in] size       Size in bytes of the playlist file.
+ * \param[in] data       User data.
+ */
+typedef void (*player_playlist_import_cb_t) (int entries,
+                                             off_t pos, off_t size, void *data);
+
 /**
  * \name Player to MRL connection.
  * @{
@@ -784,6 +1234,74 @@ void player_mrl_set (player_t *player, mrl_t *mrl);
  */
 void player_mrl_append (player_t *player, mrl_t *mrl, player_mrl_add_t when);
 
+/**
+ * \brief Append several MRL objects in the internal playlist.
+ *
+ * The playlist (and the shuffle order) is updated only once for all the
+ * MRL objects. With PLAYER_MRL_ADD_NOW, the first appended MRL is played.
+ *
+ * \warning MT-Safe in multithreaded applications (see \ref mtlevel).
+ * \param[in] player      Player controller.
+ * \param[in] list        Array of MRL objects to append.
+ * \param[in] n           Number of MRL objects in the array.
+ * \param[in] when        Just append, or append and play the first one.
+ */
+void player_mrl_append_bulk (player_t *player,
+                             mrl_t **list, int n, player_mrl_add_t when);
+
+/**
+ * \brief Import a playlist file in the internal playlist.
+ *
+ * The formats M3U, PLS and XSPF are supported. The file is parsed in one pass
+ * and the MRL objects are appended by chunks. They are not probed by the
+ * import; the properties and metadata are retrieved when they are requested
+ * or when the MRL is played. The entries not supported by the wrapper are
+ * ignored.
+ *
+ * \warning MT-Safe in multithreaded applications (see \ref mtlevel).
+ * \param[in] player      Player controller.
+ * \param[in] path        Path on the playlist file.
+ * \param[in] when        Just append, or append and play the first entry.
+ * \param[in] cb          Progress callback (can be NULL).
+ * \param[in] data        User data for the callback.
+ * \return Number of MRL objects appended, -1 on error.
+ */
+int player_playlist_import (player_t *player, const char *path,
+                            player_mrl_add_t when,
+                            player_playlist_import_cb_t cb, void *data);
+
+/**
+ * \brief Save the internal playlist in a snapshot file.
+ *
+ * The snapshot contains the MRL objects (resource arguments, subtitles,
+ * properties and metadata already retrieved), the current MRL object and
+ * the state of the loop and the shuffle.
+ *
+ * \warning MT-Safe in multithreaded applications (see \ref mtlevel).
+ * \param[in] player      Player controller.
+ * \param[in] path        Path on the snapshot file.
+ * \return 0 on success, -1 on error.
+ */
+int player_playlist_save (player_t *player, const char *path);
+
+/**
+ * \brief Load a snapshot file in the internal playlist.
+ *
+ * The MRL objects of the internal playlist are replaced by the MRL objects
+ * saved with player_playlist_save(). The snapshot is mapped in memory and
+ * the MRL objects are created only when they are used, then loading is fast
+ * even with a very big playlist. The properties and the metadata are
+ * retrieved again if the snapshot was saved with an other wrapper.
+ *
+ * The playback is stopped.
+ *
+ * \warning MT-Safe in multithreaded applications (see \ref mtlevel).
+ * \param[in] player      Player controller.
+ * \param[in] path        Path on the snapshot file.
+ * \return Number of MRL objects in the playlist, -1 on error.
+ */
+int player_playlist_load (player_t *player, const char *path);
+
 /**
  * \brief Remove current MRL object in the internal playlist.
  *
@@ -824,6 +1342,19 @@ void player_mrl_previous (player_t *player);
  */
 void player_mrl_next (player_t *player);
 
+/**
+ * \brief Go to an MRL object in the internal playlist by its index.
+ *
+ * Playback is started if the MRL object exists. The first MRL object of the
+ * playlist has the index 0. With the shuffle, the MRL object is considered
+ * as already played.
+ *
+ * \warning MT-Safe in multithreaded applications (see \ref mtlevel).
+ * \param[in] player      Player controller.
+ * \param[in] index       Index of the MRL object in the playlist.
+ */
+void player_mrl_goto (player_t *player, int index);
+
 /**
  * \brief Go to the next MRL object accordingly to the loop and shuffle.
  *
@@ -874,6 +1405,20 @@ typedef enum player_x_window_flags {
   PLAYER_X_WINDOW_H    = (1 << 3),
 } player_x_window_flags_t;
 
+/** \brief Statistics of the probe cache. */
+typedef struct player_probe_cache_stats_s {
+  /** Probes served by the cache. */
+  uint32_t hits;
+  /** Probes not (or no longer) in the cache. */
+  uint32_t misses;
+  /** Number of MRL in the cache. */
+  uint32_t entries;
+  /** Number of MRL evicted because of the size limit. */
+  uint32_t evictions;
+  /** Size of the cache file (byte). */
+  off_t size;
+} player_probe_cache_stats_t;
+
 /**
  * \name Player tuning & properties.
  * @{
@@ -1022,6 +1567,20 @@ void player_osd_show_text (player_t *player,
  */
 void player_osd_state (player_t *player, int value);
 
+/**
+ * \brief Get the statistics of the probe cache.
+ *
+ * The cache is shared by all player controllers using the same file, then
+ * the statistics are global to these controllers.
+ * All values are 0 if the cache is disabled.
+ *
+ * \warning MT-Safe in multithreaded applications (see \ref mtlevel).
+ * \param[in] player      Player controller.
+ * \param[out] stats      Statistics.
+ */
+void player_probe_cache_get_stats (player_t *player,
+                                   player_probe_cache_stats_t *stats);
+
 /**
  * @}
  */
@@ -1073,6 +1632,29 @@ player_pb_state_t player_playback_get_state (player_t *player);
  */
 void player_playback_start (player_t *player);
 
+/**
+ * \brief Prepare a playback ahead of time.
+ *
+ * The MRL is opened, demuxed and paused on the first frame when the wrapper
+ * can do it while nothing is playing (or in a second stream). When this MRL
+ * is then started with player_playback_start(), the output begins
+ * immediately. It is useful for zapping, when the next MRL is known.
+ *
+ * When the wrapper can't prepare the MRL, at least the properties are
+ * retrieved, then the start has nothing else to identify.
+ *
+ * The prepared stream is released by the next start, or by another
+ * preparation.
+ *
+ * Wrappers supported (even partially):
+ *  GStreamer, MPlayer, xine
+ *
+ * \warning MT-Safe in multithreaded applications (see \ref mtlevel).
+ * \param[in] player      Player controller.
+ * \param[in] mrl         MRL to prepare.
+ */
+void player_playback_prepare (player_t *player, mrl_t *mrl);
+
 /**
  * \brief Stop playback.
  *
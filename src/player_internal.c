@@ -22,6 +22,7 @@
 
 #include <pthread.h>
 #include <stdlib.h>
+#include <string.h>
 #include <inttypes.h>
 
 #include "player.h"
@@ -30,6 +31,10 @@
 #include "playlist.h"
 #include "event.h"
 #include "window.h"
+#include "probe_cache.h"
+#include "frame_ring.h"
+#include "audio_tap.h"
+#include "playlist_import.h"
 
 #define MODULE_NAME "player"
 
@@ -49,6 +54,27 @@ player_sv_init (player_t *player)
   if (!player)
     return res;
 
+  if (player->probe_cache_path)
+    player->probe_cache = pl_probe_cache_open (player,
+                                               player->probe_cache_path,
+                                               player->probe_cache_size);
+
+  /* the ring must exist before the wrapper is initialized */
+  if (player->vo == PLAYER_VO_FRAMES)
+  {
+    player->frames = pl_frame_ring_new (player, player->frame_ring);
+    if (!player->frames)
+    {
+      pl_log (player, PLAYER_MSG_ERROR,
+              MODULE_NAME, "no frame callback for the video output");
+      return res;
+    }
+  }
+
+  /* the wrapper taps the audio only if the tap exists */
+  if (player->audio_cb || player->audio_meter_cb)
+    player->audio_tap = pl_audio_tap_new (player);
+
   /* player specific init */
   PLAYER_FUNCS_RES (init, res)
 
@@ -65,6 +91,15 @@ player_sv_uninit (player_t *player)
 
   /* free player specific private properties */
   PLAYER_FUNCS (uninit)
+
+  pl_probe_cache_close (player, player->probe_cache);
+  player->probe_cache = NULL;
+
+  pl_frame_ring_free (player->frames);
+  player->frames = NULL;
+
+  pl_audio_tap_free (player->audio_tap);
+  player->audio_tap = NULL;
 }
 
 void
@@ -130,6 +165,29 @@ player_sv_mrl_append (player_t *player, mrl_t *mrl, player_mrl_add_t when)
   }
 }
 
+void
+player_sv_mrl_append_bulk (player_t *player,
+                           mrl_t **list, int n, player_mrl_add_t when)
+{
+  int first;
+
+  pl_log (player, PLAYER_MSG_VERBOSE, MODULE_NAME, __FUNCTION__);
+
+  if (!player || !list || n <= 0)
+    return;
+
+  first = pl_playlist_count_mrl (player->playlist);
+  pl_playlist_append_bulk (player->playlist, list, n);
+
+  /* play the first one now ? */
+  if (when == PLAYER_MRL_ADD_NOW)
+  {
+    player_sv_playback_stop (player);
+    pl_playlist_goto_mrl (player->playlist, first);
+    player_sv_playback_start (player);
+  }
+}
+
 void
 player_sv_mrl_remove (player_t *player)
 {
@@ -185,9 +243,142 @@ player_sv_mrl_next (player_t *player)
   player_sv_playback_start (player);
 }
 
+void
+player_sv_mrl_goto (player_t *player, int index)
+{
+  pl_log (player, PLAYER_MSG_VERBOSE, MODULE_NAME, __FUNCTION__);
+
+  if (!player)
+    return;
+
+  if (index < 0 || index >= pl_playlist_count_mrl (player->playlist))
+    return;
+
+  player_sv_playback_stop (player);
+  pl_playlist_goto_mrl (player->playlist, index);
+  player_sv_playback_start (player);
+}
+
+int
+player_sv_playlist_import (player_t *player, const char *path,
+                           player_mrl_add_t when,
+                           player_playlist_import_cb_t cb, void *data)
+{
+  int first, res;
+
+  pl_log (player, PLAYER_MSG_VERBOSE, MODULE_NAME, __FUNCTION__);
+
+  if (!player || !path)
+    return -1;
+
+  first = pl_playlist_count_mrl (player->playlist);
+  res = pl_playlist_import (player, path, cb, data);
+
+  /* play the first entry now ? */
+  if (res > 0 && when == PLAYER_MRL_ADD_NOW)
+  {
+    player_sv_playback_stop (player);
+    pl_playlist_goto_mrl (player->playlist, first);
+    player_sv_playback_start (player);
+  }
+
+  return res;
+}
+
+int
+player_sv_playlist_save (player_t *player, const char *path)
+{
+  int res;
+
+  pl_log (player, PLAYER_MSG_VERBOSE, MODULE_NAME, __FUNCTION__);
+
+  if (!player || !path)
+    return -1;
+
+  res = pl_playlist_save (player->playlist, path, player->type);
+  if (res)
+    pl_log (player, PLAYER_MSG_ERROR,
+            MODULE_NAME, "unable to save the playlist in %s", path);
+
+  return res;
+}
+
+int
+player_sv_playlist_load (player_t *player, const char *path)
+{
+  int res;
+
+  pl_log (player, PLAYER_MSG_VERBOSE, MODULE_NAME, __FUNCTION__);
+
+  if (!player || !path)
+    return -1;
+
+  player_sv_playback_stop (player);
+
+  res = pl_playlist_load (player->playlist,
+                          path, player->type, player->metadata_pack);
+  if (res < 0)
+    pl_log (player, PLAYER_MSG_ERROR,
+            MODULE_NAME, "unable to load the playlist %s", path);
+
+  return res;
+}
+
+static void
+player_video_size (player_t *player, mrl_t *mrl)
+{
+  mrl_properties_video_t *video;
+
+  if (!mrl->prop || !mrl->prop->video)
+    return;
+
+  video = mrl->prop->video;
+  player->w = video->width;
+  player->h = video->height;
+  player->aspect = video->aspect / PLAYER_VIDEO_ASPECT_RATIO_MULT;
+}
+
+/* give the next MRL to the wrapper for a gapless playback */
+static void
+player_gapless_preload (player_t *player)
+{
+  mrl_t *mrl;
+
+  if (!player->gapless || player->pb_mode != PLAYER_PB_AUTO
+      || !player->funcs->pb_preload)
+    return;
+
+  mrl = pl_playlist_next_play_peek (player->playlist);
+  if (mrl)
+    player->funcs->pb_preload (player, mrl);
+}
+
+/*
+ * Called at the end of a stream with the MRL expected to be the next one.
+ * Returns 1 if the wrapper has already switched to this MRL, otherwise the
+ * wrapper has dropped what it has maybe preloaded.
+ */
+static int
+player_gapless_switch (player_t *player, mrl_t *mrl)
+{
+  playback_status_t res;
+
+  if (!player->gapless || !player->funcs->pb_gapless)
+    return 0;
+
+  res = player->funcs->pb_gapless (player, mrl);
+  if (res != PLAYER_PB_OK || !mrl)
+    return 0;
+
+  pl_log (player, PLAYER_MSG_INFO, MODULE_NAME, "gapless switch");
+  return 1;
+}
+
 void
 player_sv_mrl_next_play (player_t *player)
 {
+  mrl_t *mrl;
+
   pl_log (player, PLAYER_MSG_VERBOSE, MODULE_NAME, __FUNCTION__);
 
   if (!player)
@@ -195,10 +386,26 @@ player_sv_mrl_next_play (player_t *player)
 
   if (player->pb_mode != PLAYER_PB_AUTO)
   {
+    /* the preloaded MRL is not the one given by player_sv_mrl_next() */
+    player_gapless_switch (player, NULL);
     player_sv_mrl_next (player);
     return;
   }
 
+  mrl = pl_playlist_next_play_peek (player->playlist);
+  if (player->state == PLAYER_STATE_IDLE && player_gapless_switch (player, mrl))
+  {
+    pl_playlist_next_play (player->playlist);
+    player_video_size (player, mrl);
+    player->state = PLAYER_STATE_RUNNING;
+
+    /* notify front-end */
+    player_event_send (player, PLAYER_EVENT_PLAYBACK_START);
+
+    player_gapless_preload (player);
+    return;
+  }
+
   player_sv_playback_stop (player);
 
   if (!pl_playlist_next_play (player->playlist))
@@ -210,6 +417,25 @@ player_sv_mrl_next_play (player_t *player)
   player_sv_playback_start (player);
 }
 
+/* end of the stream, see player_event_cb() */
+void
+player_sv_mrl_finished (player_t *player)
+{
+  pl_log (player, PLAYER_MSG_VERBOSE, MODULE_NAME, __FUNCTION__);
+
+  if (!player)
+    return;
+
+  /* the end of a gapless playback, nothing else to play */
+  if (player->pb_mode != PLAYER_PB_AUTO)
+  {
+    player_gapless_switch (player, NULL);
+    return;
+  }
+
+  player_sv_mrl_next_play (player);
+}
+
 /***************************************************************************/
 /*                                                                         */
 /* Player tuning & properties                                              */
@@ -381,6 +607,19 @@ player_sv_osd_state (player_t *player, int value)
   PLAYER_FUNCS (osd_state, value)
 }
 
+void
+player_sv_probe_cache_get_stats (player_t *player,
+                                 player_probe_cache_stats_t *stats)
+{
+  pl_log (player, PLAYER_MSG_VERBOSE, MODULE_NAME, __FUNCTION__);
+
+  if (!player || !stats)
+    return;
+
+  memset (stats, 0, sizeof (*stats));
+  pl_probe_cache_stats (player->probe_cache, stats);
+}
+
 /***************************************************************************/
 /*                                                                         */
 /* Playback related controls                                               */
@@ -427,13 +666,7 @@ player_sv_playback_start (player_t *player)
   if (!mrl) /* nothing to playback */
     return;
 
-  if (mrl->prop && mrl->prop->video)
-  {
-    mrl_properties_video_t *video = mrl->prop->video;
-    player->w = video->width;
-    player->h = video->height;
-    player->aspect = video->aspect / PLAYER_VIDEO_ASPECT_RATIO_MULT;
-  }
+  player_video_size (player, mrl);
 
   /* player specific playback_start() */
   PLAYER_FUNCS_RES (pb_start, res)
@@ -445,6 +678,27 @@ player_sv_playback_start (player_t *player)
 
   /* notify front-end */
   player_event_send (player, PLAYER_EVENT_PLAYBACK_START);
+
+  player_gapless_preload (player);
+}
+
+void
+player_sv_playback_prepare (player_t *player, mrl_t *mrl)
+{
+  playback_status_t res = PLAYER_PB_ERROR;
+
+  pl_log (player, PLAYER_MSG_VERBOSE, MODULE_NAME, __FUNCTION__);
+
+  if (!player || !mrl)
+    return;
+
+  /* player specific playback_prepare() */
+  if (player->funcs->pb_prepare)
+    res = player->funcs->pb_prepare (player, mrl);
+
+  /* nothing to identify with the start */
+  if (res != PLAYER_PB_OK)
+    mrl_retrieve_properties (player, mrl);
 }
 
 void
@@ -28,6 +28,9 @@
 struct playlist_s;
 struct event_handler_s;
 struct supervisor_s;
+struct probe_cache_s;
+struct frame_ring_s;
+struct audio_tap_s;
 
 typedef enum init_status {
   PLAYER_INIT_OK,
@@ -56,40 +59,38 @@ typedef enum identify_flags {
 typedef struct mrl_metadata_cd_track_s {
   char *name;
   uint32_t length;
-  struct mrl_metadata_cd_track_s *next;
 } mrl_metadata_cd_track_t;
 
 typedef struct mrl_metadata_cd_s {
   uint32_t discid;
   uint32_t tracks;
-  mrl_metadata_cd_track_t *track;
+  mrl_metadata_cd_track_t *track; /* array, see mrl_metadata_cd_get_track() */
+  uint32_t track_nb;
 } mrl_metadata_cd_t;
 
 typedef struct mrl_metadata_dvd_title_s {
   uint32_t chapters;
   uint32_t angles;
   uint32_t length;
-  struct mrl_metadata_dvd_title_s *next;
 } mrl_metadata_dvd_title_t;
 
 typedef struct mrl_metadata_dvd_s {
   char *volumeid;
   uint8_t titles;
-  mrl_metadata_dvd_title_t *title;
+  mrl_metadata_dvd_title_t *title; /* array, see mrl_metadata_dvd_get_title() */
+  uint32_t title_nb;
 } mrl_metadata_dvd_t;
 
 typedef struct mrl_metadata_sub_s {
   char *name;
   char *lang;
   uint32_t id;
-  struct mrl_metadata_sub_s *next;
 } mrl_metadata_sub_t;
 
 typedef struct mrl_metadata_audio_s {
   char *name;
   char *lang;
   uint32_t id;
-  struct mrl_metadata_audio_s *next;
 } mrl_metadata_audio_t;
 
 typedef struct mrl_metadata_s {
@@ -100,9 +101,12 @@ typedef struct mrl_metadata_s {
   char *year;
   char *track;
   char *comment;
-  mrl_metadata_sub_t *subs;
-  mrl_metadata_audio_t *audio_streams;
+  mrl_metadata_sub_t *subs;             /* array, see mrl_metadata_sub_get() */
+  uint32_t subs_nb;
+  mrl_metadata_audio_t *audio_streams;  /* array, see mrl_metadata_audio_get() */
+  uint32_t audio_nb;
   void *priv; /* private metadata, depending on resource type */
+  int packed; /* see mrl_metadata_pack() */
 } mrl_metadata_t;
 
 typedef struct mrl_properties_audio_s {
@@ -138,11 +142,9 @@ struct mrl_s {
   mrl_resource_t resource;
   mrl_properties_t *prop;
   mrl_metadata_t *meta;
+  int facets;  /* IDENTIFY_PROPERTIES and (or) IDENTIFY_METADATA retrieved */
+  int probing; /* a probe is in flight */
   void *priv; /* private data, depending on resource type */
-
-  /* for playlist management */
-  struct mrl_s *prev;
-  struct mrl_s *next;
 };
 
 typedef struct player_funcs_s {
@@ -151,11 +153,25 @@ typedef struct player_funcs_s {
   void (*uninit) (player_t *player);
   void (*set_verbosity) (player_t *player, player_verbosity_level_t level);
 
-  /* MRLs */
+  /*
+   * MRLs
+   * All facets allocated in the MRL (properties and/or metadata) must be
+   * retrieved with one call, see the probe planner (mrl_internal.c).
+   */
   void (*mrl_retrieve_props) (player_t *player, mrl_t *mrl);
   void (*mrl_retrieve_meta) (player_t *player, mrl_t *mrl);
+  /* facets from the engine (MRL playing), returns 0 if not possible */
+  int (*mrl_retrieve_live) (player_t *player, mrl_t *mrl);
   void (*mrl_video_snapshot) (player_t *player, mrl_t *mrl,
                               int pos, mrl_snapshot_t t, const char *dst);
+  /* frame in memory, returns 1 on success */
+  int (*mrl_video_snapshot_buffer) (player_t *player, mrl_t *mrl, int pos,
+                                    mrl_snapshot_t t,
+                                    mrl_snapshot_buffer_t *buf);
+  /* all frames with one decoder session, dst is a checked pattern */
+  void (*mrl_video_snapshot_batch) (player_t *player, mrl_t *mrl,
+                                    const int *pos, int n,
+                                    mrl_snapshot_t t, const char *dst);
 
   /* Player properties */
   int (*get_time_pos) (player_t *player);
@@ -174,6 +190,25 @@ typedef struct player_funcs_s {
   void (*pb_seek_chapter) (player_t *player, int value, int absolute);
   void (*pb_set_speed) (player_t *player, float value);
 
+  /*
+   * Gapless playback (see player_s::gapless)
+   * pb_preload gives the next MRL while the current one is playing; the
+   * wrapper can switch to it at the end of the stream, before sending
+   * PLAYER_EVENT_PLAYBACK_FINISHED.
+   * pb_gapless is called by the supervisor after this event, with the MRL
+   * expected to be playing (NULL if the playback must end). It returns
+   * PLAYER_PB_OK if this MRL is already playing, otherwise any stream
+   * started by the wrapper with the preload must be stopped.
+   */
+  void (*pb_preload) (player_t *player, mrl_t *mrl);
+  playback_status_t (*pb_gapless) (player_t *player, mrl_t *mrl);
+
+  /*
+   * Open the MRL and pause on the first frame, pb_start() must begin the
+   * output immediately when this MRL is started.
+   */
+  playback_status_t (*pb_prepare) (player_t *player, mrl_t *mrl);
+
   /* Audio */
   int (*audio_get_volume) (player_t *player);
   void (*audio_set_volume) (player_t *player, int value);
@@ -246,6 +281,9 @@ struct player_s {
   player_verbosity_level_t verbosity;
   pthread_mutex_t mutex_verb;
 
+  pthread_mutex_t mutex_probe; /* probe planner (coalesced probes) */
+  pthread_cond_t  cond_probe;
+
   struct playlist_s *playlist;
 
   player_state_t state;       /* state of the playback        */
@@ -262,11 +300,25 @@ struct player_s {
   float aspect;               /* video aspect                 */
 
   player_quality_level_t quality; /* picture decoding quality */
+  int probe_workers;          /* max parallel probes for batches */
+  char *probe_cache_path;     /* probe cache file, NULL to disable */
+  off_t probe_cache_size;     /* max size of the probe cache file */
+  int metadata_pack;          /* intern and pack the metadata */
+  int gapless;                /* preload the next MRL (PLAYER_PB_AUTO) */
+  int audio_only;             /* the video is never decoded, no window */
+  struct probe_cache_s *probe_cache;
+  int frame_ring;             /* number of buffers for the frames */
+  struct frame_ring_s *frames; /* decoded frames with PLAYER_VO_FRAMES */
+  int audio_meter_interval;   /* period of the audio meters (ms) */
+  struct audio_tap_s *audio_tap; /* decoded audio, NULL without callback */
 
   struct supervisor_s    *supervisor; /* manage all public operations        */
   struct event_handler_s *event;      /* event handler                       */
   int (*event_cb) (player_event_t e, void *data); /* frontend event callback */
-  void *user_data;                  /* user data for frontend event callback */
+  void (*frame_cb) (const player_frame_t *frame, void *data); /* frames */
+  void (*audio_cb) (const player_audio_t *audio, void *data); /* audio tap */
+  void (*audio_meter_cb) (const player_audio_meter_t *meter, void *data);
+  void *user_data;  /* user data for frontend event/frame/audio callbacks */
 
   struct player_funcs_s *funcs; /* bindings to player specific functions     */
   void *priv;                   /* specific conf related to the player type  */
@@ -292,27 +344,32 @@ mrl_properties_t *mrl_properties_new (void);
 void mrl_properties_free (mrl_properties_t *prop);
 mrl_metadata_t *mrl_metadata_new (mrl_resource_t res);
 void mrl_metadata_free (mrl_metadata_t *meta, mrl_resource_t res);
+mrl_metadata_t *mrl_metadata_pack (mrl_metadata_t *meta);
 mrl_metadata_cd_track_t *mrl_metadata_cd_get_track (mrl_metadata_cd_t *cd,
                                                     uint32_t id);
-mrl_metadata_cd_track_t *mrl_metadata_cd_track_new (void);
 mrl_metadata_dvd_title_t *mrl_metadata_dvd_get_title (mrl_metadata_dvd_t *dvd,
                                                       uint32_t id);
-mrl_metadata_dvd_title_t *mrl_metadata_dvd_title_new (void);
-mrl_metadata_sub_t *mrl_metadata_sub_get (mrl_metadata_sub_t **sub, uint32_t id);
-mrl_metadata_audio_t *mrl_metadata_audio_get (mrl_metadata_audio_t **audio,
+mrl_metadata_sub_t *mrl_metadata_sub_get (mrl_metadata_t *meta, uint32_t id);
+mrl_metadata_audio_t *mrl_metadata_audio_get (mrl_metadata_t *meta,
                                               uint32_t id);
-void mrl_list_free (mrl_t *mrl);
+void mrl_retrieve_properties (player_t *player, mrl_t *mrl);
+void mrl_retrieve_deferred (player_t *player, mrl_t *mrl);
+int mrl_snapshot_ppm_unpack (mrl_snapshot_buffer_t *buf);
 
 /*****************************************************************************/
 /*                   MRL Internal (Supervisor) functions                     */
 /*****************************************************************************/
 
-void mrl_sv_free (mrl_t *mrl, int recursive);
+void mrl_sv_free (mrl_t *mrl);
 uint32_t mrl_sv_get_property (player_t *player,
                               mrl_t *mrl, mrl_properties_type_t p);
 char *mrl_sv_get_audio_codec (player_t *player, mrl_t *mrl);
 char *mrl_sv_get_video_codec (player_t *player, mrl_t *mrl);
 off_t mrl_sv_get_size (player_t *player, mrl_t *mrl);
+int mrl_sv_get_properties_all (player_t *player,
+                               mrl_t *mrl, mrl_properties_all_t *prop);
+int mrl_sv_get_metadata_all (player_t *player,
+                             mrl_t *mrl, mrl_metadata_all_t *meta);
 char *mrl_sv_get_metadata (player_t *player, mrl_t *mrl, mrl_metadata_type_t m);
 char *mrl_sv_get_metadata_cd_track (player_t *player,
                                     mrl_t *mrl, int trackid, uint32_t *length);
@@ -331,8 +388,17 @@ mrl_type_t mrl_sv_get_type (player_t *player, mrl_t *mrl);
 mrl_resource_t mrl_sv_get_resource (player_t *player, mrl_t *mrl);
 void mrl_sv_add_subtitle (player_t *player, mrl_t *mrl, char *subtitle);
 mrl_t *mrl_sv_new (player_t *player, mrl_resource_t res, void *args);
+mrl_t *mrl_sv_new_lazy (player_t *player, mrl_resource_t res, void *args);
 void mrl_sv_video_snapshot (player_t *player, mrl_t *mrl,
                             int pos, mrl_snapshot_t t, const char *dst);
+int mrl_sv_video_snapshot_to_buffer (player_t *player, mrl_t *mrl, int pos,
+                                     mrl_snapshot_t t,
+                                     mrl_snapshot_buffer_t *buf);
+void mrl_sv_video_snapshot_batch (player_t *player, mrl_t *mrl,
+                                  const int *pos, int n,
+                                  mrl_snapshot_t t, const char *dst);
+void mrl_sv_probe_batch (player_t *player, mrl_t **list, int n, int flags,
+                         mrl_probe_cb_t cb, void *data);
 
 /*****************************************************************************/
 /*                 Player Internal (Supervisor) functions                    */
@@ -347,11 +413,20 @@ void player_sv_set_verbosity (player_t *player, player_verbosity_level_t level);
 mrl_t *player_sv_mrl_get_current (player_t *player);
 void player_sv_mrl_set (player_t *player, mrl_t *mrl);
 void player_sv_mrl_append (player_t *player, mrl_t *mrl, player_mrl_add_t when);
+void player_sv_mrl_append_bulk (player_t *player,
+                                mrl_t **list, int n, player_mrl_add_t when);
 void player_sv_mrl_remove (player_t *player);
 void player_sv_mrl_remove_all (player_t *player);
 void player_sv_mrl_previous (player_t *player);
 void player_sv_mrl_next (player_t *player);
+void player_sv_mrl_goto (player_t *player, int index);
+int player_sv_playlist_import (player_t *player, const char *path,
+                               player_mrl_add_t when,
+                               player_playlist_import_cb_t cb, void *data);
+int player_sv_playlist_save (player_t *player, const char *path);
+int player_sv_playlist_load (player_t *player, const char *path);
 void player_sv_mrl_next_play (player_t *player);
+void player_sv_mrl_finished (player_t *player);
 
 /* Player tuning & properties */
 int player_sv_get_time_pos (player_t *player);
@@ -366,10 +441,13 @@ void player_sv_x_window_set_properties (player_t *player,
 void player_sv_osd_show_text (player_t *player,
                               const char *text, int x, int y, int duration);
 void player_sv_osd_state (player_t *player, int value);
+void player_sv_probe_cache_get_stats (player_t *player,
+                                      player_probe_cache_stats_t *stats);
 
 /* Playback related controls */
 player_pb_state_t player_sv_playback_get_state (player_t *player);
 void player_sv_playback_start (player_t *player);
+void player_sv_playback_prepare (player_t *player, mrl_t *mrl);
 void player_sv_playback_stop (player_t *player);
 void player_sv_playback_pause (player_t *player);
 void player_sv_playback_seek (player_t *player,
@@ -19,28 +19,78 @@
  * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
  */
 
+#include <stdio.h>
 #include <stdlib.h>
+#include <string.h> /* memmove */
 #include <time.h> /* time */
+#include <inttypes.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
 
 #include "player.h"
 #include "player_internals.h"
 #include "playlist.h"
+#include "serialize.h"
 
+#define PLAYLIST_SIZE_MIN 16
+
+#define SNAPSHOT_MAGIC    0x4c50504c /* LPPL */
+#define SNAPSHOT_VERSION  2
+#define SNAPSHOT_HEADER   (12 * sizeof (uint32_t))
+
+/*
+ * The MRLs are stored in an array, then the count, the first, the last and
+ * any index are reached in O(1). The mrl_t pointers are the handles.
+ *
+ * The shuffle uses an incremental Fisher-Yates. 'shuffle_list' is a
+ * permutation of the indexes where [0, shuffle_it] are already played, the
+ * next MRL is randomly picked in the rest of the list. 'shuffle_pos' is the
+ * inverse permutation.
+ */
 struct playlist_s {
-  mrl_t *mrl_list;
-  int    reset;
+  mrl_t **mrl_list;
+  int     mrl_cnt;
+  int     mrl_size;
+  int     mrl_cur;
+  int     reset;
 
   int          shuffle;
   int         *shuffle_list;
+  int         *shuffle_pos;
   int          shuffle_it;
-  int          shuffle_cnt;
   unsigned int shuffle_seed;
 
   int           loop;
   int           loop_cnt;
   player_loop_t loop_mode;
+
+  /*
+   * Snapshot loaded with pl_playlist_load(), the MRLs are materialized only
+   * when they are touched. The MRLs not yet materialized are NULL in
+   * 'mrl_list' and 'snap_rec' gives their record in the snapshot.
+   */
+  uint8_t  *snap_map;
+  size_t    snap_size;
+  uint32_t  snap_cnt;
+  uint32_t *snap_rec;
+  uint32_t  snap_wrapper;   /* wrapper which has saved the snapshot */
+  int       snap_facets;
+  int       snap_pack;
 };
 
+/*
+ * Snapshot file (host byte order):
+ *
+ *  header:  magic, version, wrapper, count, current, shuffle, shuffle_it,
+ *           shuffle_seed, loop, loop_cnt, loop_mode, reset (u32)
+ *  offsets: offset of each record in the file (u64 x count)
+ *  shuffle: permutation of the shuffle (u32 x count)
+ *  records: one record for each MRL, see pl_serial_put_mrl()
+ */
+
 
 playlist_t *
 pl_playlist_new (int shuffle, int loop, player_loop_t loop_mode)
@@ -57,16 +107,44 @@ pl_playlist_new (int shuffle, int loop, player_loop_t loop_mode)
   return playlist;
 }
 
+static void
+playlist_snapshot_unmap (playlist_t *playlist)
+{
+  if (playlist->snap_map)
+    munmap (playlist->snap_map, playlist->snap_size);
+
+  playlist->snap_map  = NULL;
+  playlist->snap_size = 0;
+  playlist->snap_cnt  = 0;
+}
+
+static void
+playlist_free_mrls (playlist_t *playlist)
+{
+  int i;
+
+  for (i = 0; i < playlist->mrl_cnt; i++)
+    mrl_sv_free (playlist->mrl_list[i]);
+
+  playlist_snapshot_unmap (playlist);
+
+  playlist->mrl_cnt = 0;
+  playlist->mrl_cur = 0;
+  playlist->shuffle_it = -1;
+}
+
 void
 pl_playlist_free (playlist_t *playlist)
 {
   if (!playlist)
     return;
 
-  if (playlist->mrl_list)
-    mrl_list_free (playlist->mrl_list);
+  playlist_free_mrls (playlist);
 
+  PFREE (playlist->mrl_list);
   PFREE (playlist->shuffle_list);
+  PFREE (playlist->shuffle_pos);
+  PFREE (playlist->snap_rec);
   PFREE (playlist);
 }
 
@@ -81,53 +159,103 @@ pl_playlist_set_loop (playlist_t *playlist, int loop, player_loop_t mode)
   playlist->loop_mode = mode;
 }
 
+static int
+playlist_grow (playlist_t *playlist, int cnt)
+{
+  int size;
+  mrl_t **list;
+  int *shuffle_list, *shuffle_pos;
+  uint32_t *snap_rec;
+
+  if (cnt <= playlist->mrl_size)
+    return 0;
+
+  size = playlist->mrl_size ? playlist->mrl_size : PLAYLIST_SIZE_MIN;
+  while (size < cnt)
+    size *= 2;
+
+  list = realloc (playlist->mrl_list, size * sizeof (*list));
+  if (!list)
+    return -1;
+  playlist->mrl_list = list;
+
+  shuffle_list = realloc (playlist->shuffle_list, size * sizeof (int));
+  if (!shuffle_list)
+    return -1;
+  playlist->shuffle_list = shuffle_list;
+
+  shuffle_pos = realloc (playlist->shuffle_pos, size * sizeof (int));
+  if (!shuffle_pos)
+    return -1;
+  playlist->shuffle_pos = shuffle_pos;
+
+  snap_rec = realloc (playlist->snap_rec, size * sizeof (uint32_t));
+  if (!snap_rec)
+    return -1;
+  playlist->snap_rec = snap_rec;
+
+  playlist->mrl_size = size;
+  return 0;
+}
+
 static void
-playlist_goto_mrl (playlist_t *playlist, int value)
+playlist_shuffle_swap (playlist_t *playlist, int a, int b)
 {
-  if (!playlist)
+  int tmp;
+
+  tmp = playlist->shuffle_list[a];
+  playlist->shuffle_list[a] = playlist->shuffle_list[b];
+  playlist->shuffle_list[b] = tmp;
+
+  playlist->shuffle_pos[playlist->shuffle_list[a]] = a;
+  playlist->shuffle_pos[playlist->shuffle_list[b]] = b;
+}
+
+/* move the MRL in the played part of the permutation */
+static void
+playlist_shuffle_played (playlist_t *playlist, int idx)
+{
+  if (playlist->shuffle_pos[idx] <= playlist->shuffle_it)
     return;
 
-  pl_playlist_first_mrl (playlist);
-  while (pl_playlist_next_mrl_available (playlist) && value--)
-    pl_playlist_next_mrl (playlist);
+  playlist->shuffle_it++;
+  playlist_shuffle_swap (playlist,
+                         playlist->shuffle_it, playlist->shuffle_pos[idx]);
 }
 
+/* pick randomly the next MRL to play in the rest of the permutation */
 static void
-playlist_shuffle_init (playlist_t *playlist)
+playlist_shuffle_pick (playlist_t *playlist)
 {
-  int i;
+  int r;
+
+  playlist->shuffle_it++;
+  r = playlist->shuffle_it + (int) (rand_r (&playlist->shuffle_seed)
+                                    % (playlist->mrl_cnt - playlist->shuffle_it));
+  playlist_shuffle_swap (playlist, playlist->shuffle_it, r);
 
+  playlist->mrl_cur = playlist->shuffle_list[playlist->shuffle_it];
+}
+
+/*
+ * Any permutation can be used to start a new Fisher-Yates, then the list
+ * of the previous shuffle is reused as is.
+ */
+static void
+playlist_shuffle_init (playlist_t *playlist)
+{
   if (!playlist)
     return;
 
   if (!playlist->shuffle_seed)
     playlist->shuffle_seed = time (NULL);
 
-  playlist->shuffle_cnt = pl_playlist_count_mrl (playlist);
+  playlist->shuffle_it = -1;
 
-  PFREE (playlist->shuffle_list);
-
-  playlist->shuffle_list = malloc (playlist->shuffle_cnt * sizeof (int));
-  if (!playlist->shuffle_list)
+  if (!playlist->mrl_cnt)
     return;
 
-  /* init list */
-  for (i = 0; i < playlist->shuffle_cnt; i++)
-    *(playlist->shuffle_list + i) = i;
-
-  /* pseudo-random shuffle */
-  for (i = 0; i < (playlist->shuffle_cnt - 1); i++)
-  {
-    int r, tmp;
-    r = i + (int) (rand_r (&playlist->shuffle_seed)
-                   / (double) RAND_MAX * (playlist->shuffle_cnt - i));
-    tmp = *(playlist->shuffle_list + i);
-    *(playlist->shuffle_list + i) = *(playlist->shuffle_list + r);
-    *(playlist->shuffle_list + r) = tmp;
-  }
-
-  playlist->shuffle_it = 0;
-  playlist_goto_mrl (playlist, *playlist->shuffle_list); /* first mrl to play */
+  playlist_shuffle_pick (playlist); /* first mrl to play */
 }
 
 void
@@ -148,23 +276,19 @@ playlist_shuffle_next_available (playlist_t *playlist)
   if (!playlist)
     return 0;
 
-  return playlist->shuffle_it < playlist->shuffle_cnt - 1;
+  return playlist->shuffle_it < playlist->mrl_cnt - 1;
 }
 
 static void
 playlist_shuffle_next (playlist_t *playlist)
 {
-  int *value;
-
   if (!playlist)
     return;
 
   if (!playlist_shuffle_next_available (playlist))
     return;
 
-  playlist->shuffle_it++;
-  value = playlist->shuffle_list + playlist->shuffle_it;
-  playlist_goto_mrl (playlist, *value);
+  playlist_shuffle_pick (playlist);
 }
 
 static void
@@ -252,59 +376,141 @@ pl_playlist_next_play (playlist_t *playlist)
   return 1;
 }
 
-int
-pl_playlist_count_mrl (playlist_t *playlist)
+/*
+ * Index of the MRL which will be played by pl_playlist_next_play(), -1 if
+ * the playback will end. The state of the playlist is not altered, the
+ * random pick of the shuffle is computed with a copy of the seed, then the
+ * same MRL is picked by pl_playlist_next_play().
+ */
+static int
+playlist_next_play_index (playlist_t *playlist)
 {
-  int cnt = 1;
-  mrl_t *mrl;
+  unsigned int seed = playlist->shuffle_seed;
+  int loop_cnt = playlist->reset ? playlist->loop : playlist->loop_cnt;
+  int it;
 
-  if (!playlist || !playlist->mrl_list)
-    return 0;
+  switch (playlist->loop_mode)
+  {
+  case PLAYER_LOOP_ELEMENT:
+    return loop_cnt ? playlist->mrl_cur : -1;
 
-  mrl = playlist->mrl_list;
-  while (mrl->prev)
-    mrl = mrl->prev;
+  case PLAYER_LOOP_PLAYLIST:
+    if (playlist->shuffle ? playlist_shuffle_next_available (playlist)
+                          : pl_playlist_next_mrl_available (playlist))
+      break; /* next mrl */
 
-  while (mrl->next)
-  {
-    mrl = mrl->next;
-    cnt++;
+    if (!loop_cnt || !playlist->mrl_cnt)
+      return -1;
+
+    if (!playlist->shuffle)
+      return 0;
+
+    return playlist->shuffle_list[rand_r (&seed) % playlist->mrl_cnt];
+
+  case PLAYER_LOOP_DISABLE:
+  default:
+    break; /* next mrl */
   }
 
-  return cnt;
+  if (!playlist->shuffle)
+    return pl_playlist_next_mrl_available (playlist)
+           ? playlist->mrl_cur + 1 : -1;
+
+  if (!playlist_shuffle_next_available (playlist))
+    return -1;
+
+  it = playlist->shuffle_it + 1;
+  return playlist->shuffle_list[it + (int) (rand_r (&seed)
+                                            % (playlist->mrl_cnt - it))];
 }
 
-mrl_t *
-pl_playlist_get_mrl (playlist_t *playlist)
+static int
+playlist_snapshot_record (playlist_t *playlist,
+                          uint32_t rec, serial_reader_t *rd)
 {
-  mrl_t *mrl;
+  uint64_t start, end;
+  uint64_t base = SNAPSHOT_HEADER + (uint64_t) playlist->snap_cnt * 12;
+
+  if (!playlist->snap_map || rec >= playlist->snap_cnt)
+    return -1;
+
+  memcpy (&start, playlist->snap_map + SNAPSHOT_HEADER + rec * 8, 8);
+  if (rec + 1 < playlist->snap_cnt)
+    memcpy (&end, playlist->snap_map + SNAPSHOT_HEADER + (rec + 1) * 8, 8);
+  else
+    end = playlist->snap_size;
 
+  if (start < base || start > end || end > playlist->snap_size)
+    return -1;
+
+  rd->it  = playlist->snap_map + start;
+  rd->end = playlist->snap_map + end;
+  rd->err = 0;
+  return 0;
+}
+
+/* materialize the MRL if it comes from the snapshot */
+static mrl_t *
+playlist_mrl (playlist_t *playlist, int idx)
+{
+  serial_reader_t rd;
+
+  if (playlist->mrl_list[idx] || !playlist->snap_map)
+    return playlist->mrl_list[idx];
+
+  if (!playlist_snapshot_record (playlist, playlist->snap_rec[idx], &rd))
+    playlist->mrl_list[idx] = pl_serial_get_mrl (&rd, playlist->snap_facets);
+
+  if (playlist->mrl_list[idx] && playlist->snap_pack)
+    playlist->mrl_list[idx]->meta =
+      mrl_metadata_pack (playlist->mrl_list[idx]->meta);
+
+  return playlist->mrl_list[idx];
+}
+
+int
+pl_playlist_count_mrl (playlist_t *playlist)
+{
   if (!playlist)
+    return 0;
+
+  return playlist->mrl_cnt;
+}
+
+mrl_t *
+pl_playlist_get_mrl (playlist_t *playlist)
+{
+  if (!playlist || !playlist->mrl_cnt)
     return NULL;
 
-  mrl = playlist->mrl_list;
+  return playlist_mrl (playlist, playlist->mrl_cur);
+}
+
+mrl_t *
+pl_playlist_next_play_peek (playlist_t *playlist)
+{
+  int idx;
+
+  if (!playlist || !playlist->mrl_cnt)
+    return NULL;
 
-  return mrl;
+  idx = playlist_next_play_index (playlist);
+  return idx < 0 ? NULL : playlist_mrl (playlist, idx);
 }
 
 void
 pl_playlist_set_mrl (playlist_t *playlist, mrl_t *mrl)
 {
-  mrl_t *mrl_list;
-
   if (!playlist || !mrl)
     return;
 
-  mrl_list = playlist->mrl_list;
-  if (mrl_list)
+  if (playlist->mrl_cnt)
   {
-    mrl->prev = mrl_list->prev;
-    mrl->next = mrl_list->next;
-    mrl_sv_free (mrl_list, 0);
-    playlist->mrl_list = mrl;
+    mrl_sv_free (playlist->mrl_list[playlist->mrl_cur]);
+    playlist->mrl_list[playlist->mrl_cur] = mrl;
   }
   else
-    playlist->mrl_list = mrl;
+    pl_playlist_append_mrl (playlist, mrl);
 
   playlist_reset_counter (playlist, PLAYER_LOOP_ELEMENT);
 }
@@ -312,39 +518,54 @@ pl_playlist_set_mrl (playlist_t *playlist, mrl_t *mrl)
 void
 pl_playlist_append_mrl (playlist_t *playlist, mrl_t *mrl)
 {
-  mrl_t *mrl_list;
+  int idx;
 
   if (!playlist || !mrl)
     return;
 
-  mrl_list = playlist->mrl_list;
-  if (mrl_list)
-  {
-    while (mrl_list->next)
-      mrl_list = mrl_list->next;
+  if (playlist_grow (playlist, playlist->mrl_cnt + 1))
+    return;
 
-    mrl_list->next = mrl;
-    mrl->prev = mrl_list;
-  }
-  else
+  idx = playlist->mrl_cnt++;
+  playlist->mrl_list[idx] = mrl;
+
+  /* not played yet with the current shuffle */
+  playlist->shuffle_list[idx] = idx;
+  playlist->shuffle_pos[idx] = idx;
+  playlist->snap_rec[idx] = 0;
+
+  if (!idx)
   {
-    playlist->mrl_list = mrl;
+    playlist->mrl_cur = 0;
+    if (playlist->shuffle)
+      playlist->shuffle_it = 0;
     playlist_reset_counter (playlist, PLAYER_LOOP_ELEMENT);
   }
 }
 
+/* the array and the shuffle indexes are grown only once for all MRLs */
+void
+pl_playlist_append_bulk (playlist_t *playlist, mrl_t **list, int n)
+{
+  int i;
+
+  if (!playlist || !list || n <= 0)
+    return;
+
+  if (playlist_grow (playlist, playlist->mrl_cnt + n))
+    return;
+
+  for (i = 0; i < n; i++)
+    pl_playlist_append_mrl (playlist, list[i]);
+}
+
 int
 pl_playlist_next_mrl_available (playlist_t *playlist)
 {
-  int res = 0;
-
   if (!playlist)
     return 0;
 
-  if (playlist->mrl_list && playlist->mrl_list->next)
-    res = 1;
-
-  return res;
+  return playlist->mrl_cur < playlist->mrl_cnt - 1;
 }
 
 void
@@ -353,25 +574,17 @@ pl_playlist_next_mrl (playlist_t *playlist)
   if (!playlist)
     return;
 
-  if (playlist->mrl_list && playlist->mrl_list->next)
-  {
-    playlist->mrl_list = playlist->mrl_list->next;
-    playlist_reset_counter (playlist, PLAYER_LOOP_ELEMENT);
-  }
+  if (pl_playlist_next_mrl_available (playlist))
+    pl_playlist_goto_mrl (playlist, playlist->mrl_cur + 1);
 }
 
 int
 pl_playlist_previous_mrl_available (playlist_t *playlist)
 {
-  int res = 0;
-
   if (!playlist)
     return 0;
 
-  if (playlist->mrl_list && playlist->mrl_list->prev)
-    res = 1;
-
-  return res;
+  return playlist->mrl_cnt && playlist->mrl_cur > 0;
 }
 
 void
@@ -380,77 +593,81 @@ pl_playlist_previous_mrl (playlist_t *playlist)
   if (!playlist)
     return;
 
-  if (playlist->mrl_list && playlist->mrl_list->prev)
-  {
-    playlist->mrl_list = playlist->mrl_list->prev;
-    playlist_reset_counter (playlist, PLAYER_LOOP_ELEMENT);
-  }
+  if (pl_playlist_previous_mrl_available (playlist))
+    pl_playlist_goto_mrl (playlist, playlist->mrl_cur - 1);
 }
 
 void
 pl_playlist_first_mrl (playlist_t *playlist)
 {
-  mrl_t *mrl;
-
-  if (!playlist || !playlist->mrl_list)
+  if (!playlist || !playlist->mrl_cnt)
     return;
 
-  mrl = playlist->mrl_list;
-  while (mrl->prev)
-    mrl = mrl->prev;
-  playlist->mrl_list = mrl;
-
-  playlist_reset_counter (playlist, PLAYER_LOOP_ELEMENT);
+  pl_playlist_goto_mrl (playlist, 0);
 }
 
 void
 pl_playlist_last_mrl (playlist_t *playlist)
 {
-  mrl_t *mrl;
-
-  if (!playlist || !playlist->mrl_list)
+  if (!playlist || !playlist->mrl_cnt)
     return;
 
-  mrl = playlist->mrl_list;
-  while (mrl->next)
-    mrl = mrl->next;
-  playlist->mrl_list = mrl;
+  pl_playlist_goto_mrl (playlist, playlist->mrl_cnt - 1);
+}
+
+int
+pl_playlist_goto_mrl (playlist_t *playlist, int idx)
+{
+  if (!playlist || idx < 0 || idx >= playlist->mrl_cnt)
+    return 0;
+
+  playlist->mrl_cur = idx;
+
+  /* the MRL is considered as played with the current shuffle */
+  if (playlist->shuffle)
+    playlist_shuffle_played (playlist, idx);
 
   playlist_reset_counter (playlist, PLAYER_LOOP_ELEMENT);
+  return 1;
 }
 
 void
 pl_playlist_remove_mrl (playlist_t *playlist)
 {
-  mrl_t *mrl, *mrl_p, *mrl_n;
+  int i, idx, pos;
 
-  if (!playlist || !playlist->mrl_list)
+  if (!playlist || !playlist->mrl_cnt)
     return;
 
-  mrl = playlist->mrl_list;
-  mrl_p = mrl->prev;
-  mrl_n = mrl->next;
+  idx = playlist->mrl_cur;
+  mrl_sv_free (playlist->mrl_list[idx]);
 
-  mrl_sv_free (mrl, 0);
+  playlist->mrl_cnt--;
+  memmove (playlist->mrl_list + idx, playlist->mrl_list + idx + 1,
+           (playlist->mrl_cnt - idx) * sizeof (*playlist->mrl_list));
+  memmove (playlist->snap_rec + idx, playlist->snap_rec + idx + 1,
+           (playlist->mrl_cnt - idx) * sizeof (uint32_t));
 
-  /* link previous with the next and use the next as the current MRL */
-  if (mrl_p && mrl_n) {
-    mrl_p->next = mrl_n;
-    mrl_n->prev = mrl_p;
-    playlist->mrl_list = mrl_n;
-  }
-  /* use the previous as the current MRL */
-  else if (mrl_p) {
-    mrl_p->next = NULL;
-    playlist->mrl_list = mrl_p;
-  }
-  /* use the next as the current MRL */
-  else if (mrl_n) {
-    mrl_n->prev = NULL;
-    playlist->mrl_list = mrl_n;
+  /* remove the index of the permutation and shift the following indexes */
+  pos = playlist->shuffle_pos[idx];
+  memmove (playlist->shuffle_list + pos, playlist->shuffle_list + pos + 1,
+           (playlist->mrl_cnt - pos) * sizeof (int));
+  if (pos <= playlist->shuffle_it)
+    playlist->shuffle_it--;
+
+  for (i = 0; i < playlist->mrl_cnt; i++)
+  {
+    if (playlist->shuffle_list[i] > idx)
+      playlist->shuffle_list[i]--;
+    playlist->shuffle_pos[playlist->shuffle_list[i]] = i;
   }
-  else
-    playlist->mrl_list = NULL;
+
+  /* use the next as the current MRL, or the previous for the last one */
+  if (idx == playlist->mrl_cnt && idx)
+    playlist->mrl_cur = idx - 1;
+
+  if (playlist->shuffle && playlist->mrl_cnt)
+    playlist_shuffle_played (playlist, playlist->mrl_cur);
 
   playlist_reset_counter (playlist, PLAYER_LOOP_ELEMENT);
 }
@@ -461,11 +678,222 @@ pl_playlist_empty (playlist_t *playlist)
   if (!playlist)
     return;
 
-  if (playlist->mrl_list)
+  playlist_free_mrls (playlist);
+
+  playlist_reset_counter (playlist, PLAYER_LOOP_ELEMENT);
+}
+
+/*****************************************************************************/
+/*                                 Snapshot                                  */
+/*****************************************************************************/
+
+static int
+playlist_write (int fd, const uint8_t *data, size_t len)
+{
+  while (len)
   {
-    mrl_list_free (playlist->mrl_list);
-    playlist->mrl_list = NULL;
+    ssize_t res = write (fd, data, len);
+    if (res < 0)
+      return -1;
+
+    data += res;
+    len  -= res;
   }
 
-  playlist_reset_counter (playlist, PLAYER_LOOP_ELEMENT);
+  return 0;
+}
+
+/*
+ * The snapshot is written in a temporary file and renamed, then a snapshot
+ * still mapped by this playlist (or an other one) is never altered.
+ */
+int
+pl_playlist_save (playlist_t *playlist, const char *path, uint32_t wrapper)
+{
+  serial_buf_t head = { NULL, 0, 0, 0 };
+  serial_buf_t recs = { NULL, 0, 0, 0 };
+  uint64_t base;
+  char *tmp;
+  int i, fd, res = -1, verbatim;
+
+  if (!playlist || !path)
+    return -1;
+
+  /* the facets of an other wrapper must not be saved for this one */
+  verbatim = playlist->snap_facets && playlist->snap_wrapper == wrapper;
+
+  base = SNAPSHOT_HEADER + (uint64_t) playlist->mrl_cnt * 12;
+
+  pl_serial_put_u32 (&head, SNAPSHOT_MAGIC);
+  pl_serial_put_u32 (&head, SNAPSHOT_VERSION);
+  pl_serial_put_u32 (&head, wrapper);
+  pl_serial_put_u32 (&head, playlist->mrl_cnt);
+  pl_serial_put_u32 (&head, playlist->mrl_cur);
+  pl_serial_put_u32 (&head, playlist->shuffle);
+  pl_serial_put_u32 (&head, playlist->shuffle_it);
+  pl_serial_put_u32 (&head, playlist->shuffle_seed);
+  pl_serial_put_u32 (&head, playlist->loop);
+  pl_serial_put_u32 (&head, playlist->loop_cnt);
+  pl_serial_put_u32 (&head, playlist->loop_mode);
+  pl_serial_put_u32 (&head, playlist->reset);
+
+  for (i = 0; i < playlist->mrl_cnt; i++)
+  {
+    serial_reader_t rd;
+    mrl_t *mrl;
+
+    pl_serial_put_u64 (&head, base + recs.len);
+
+    if (playlist->mrl_list[i])
+      pl_serial_put_mrl (&recs, playlist->mrl_list[i]);
+    else if (playlist_snapshot_record (playlist, playlist->snap_rec[i], &rd))
+      recs.err = 1;
+    /* not materialized, the record is copied as is */
+    else if (verbatim)
+      pl_serial_put (&recs, rd.it, rd.end - rd.it);
+    /* or saved again without its facets */
+    else if ((mrl = pl_serial_get_mrl (&rd, 0)))
+    {
+      pl_serial_put_mrl (&recs, mrl);
+      mrl_sv_free (mrl);
+    }
+    else
+      recs.err = 1;
+  }
+
+  for (i = 0; i < playlist->mrl_cnt; i++)
+    pl_serial_put_u32 (&head, playlist->shuffle_list[i]);
+
+  if (head.err || recs.err)
+    goto out;
+
+  tmp = malloc (strlen (path) + 5);
+  if (!tmp)
+    goto out;
+  sprintf (tmp, "%s.tmp", path);
+
+  fd = open (tmp, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+  if (fd >= 0)
+  {
+    if (!playlist_write (fd, head.data, head.len)
+        && !playlist_write (fd, recs.data, recs.len))
+      res = 0;
+
+    if (close (fd))
+      res = -1;
+
+    if (!res && rename (tmp, path))
+      res = -1;
+    if (res)
+      unlink (tmp);
+  }
+
+  PFREE (tmp);
+
+ out:
+  PFREE (head.data);
+  PFREE (recs.data);
+  return res;
+}
+
+/*
+ * The current MRLs are replaced by the MRLs of the snapshot. Only the
+ * snapshot is mapped here; the records are read by playlist_mrl().
+ * The properties and the metadata are dropped with a snapshot of an other
+ * wrapper. The metadata are packed with 'pack' (see mrl_metadata_pack()).
+ */
+int
+pl_playlist_load (playlist_t *playlist,
+                  const char *path, uint32_t wrapper, int pack)
+{
+  uint32_t header[12];
+  uint8_t *map;
+  struct stat st;
+  int i, fd, cnt, valid = 1;
+
+  if (!playlist || !path)
+    return -1;
+
+  fd = open (path, O_RDONLY);
+  if (fd < 0)
+    return -1;
+
+  if (fstat (fd, &st) || st.st_size < (off_t) SNAPSHOT_HEADER)
+  {
+    close (fd);
+    return -1;
+  }
+
+  map = mmap (NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close (fd);
+  if (map == MAP_FAILED)
+    return -1;
+
+  memcpy (header, map, sizeof (header));
+  cnt = header[3];
+
+  if (header[0] != SNAPSHOT_MAGIC || header[1] != SNAPSHOT_VERSION
+      || cnt < 0
+      || SNAPSHOT_HEADER + (uint64_t) cnt * 12 > (uint64_t) st.st_size)
+  {
+    munmap (map, st.st_size);
+    return -1;
+  }
+
+  playlist_free_mrls (playlist);
+
+  if (playlist_grow (playlist, cnt))
+  {
+    munmap (map, st.st_size);
+    return -1;
+  }
+
+  playlist->snap_map    = map;
+  playlist->snap_size   = st.st_size;
+  playlist->snap_cnt    = cnt;
+  playlist->snap_pack   = pack;
+  playlist->snap_wrapper = header[2];
+  playlist->snap_facets =
+    header[2] == wrapper ? IDENTIFY_PROPERTIES | IDENTIFY_METADATA : 0;
+
+  memset (playlist->mrl_list, 0, cnt * sizeof (*playlist->mrl_list));
+  memcpy (playlist->shuffle_list,
+          map + SNAPSHOT_HEADER + (size_t) cnt * 8, cnt * sizeof (int));
+
+  for (i = 0; i < cnt; i++)
+  {
+    playlist->snap_rec[i] = i;
+    playlist->shuffle_pos[i] = -1;
+  }
+
+  /* the shuffle list must be a permutation */
+  for (i = 0; i < cnt && valid; i++)
+  {
+    int idx = playlist->shuffle_list[i];
+
+    if (idx < 0 || idx >= cnt || playlist->shuffle_pos[idx] >= 0)
+      valid = 0;
+    else
+      playlist->shuffle_pos[idx] = i;
+  }
+
+  if (!valid)
+    for (i = 0; i < cnt; i++)
+      playlist->shuffle_list[i] = playlist->shuffle_pos[i] = i;
+
+  playlist->mrl_cnt      = cnt;
+  playlist->mrl_cur      = (int) header[4] < cnt ? (int) header[4] : 0;
+  playlist->shuffle      = header[5];
+  playlist->shuffle_it   = valid && (int) header[6] >= -1
+                           && (int) header[6] < cnt ? (int) header[6] : -1;
+  playlist->shuffle_seed = header[7];
+  playlist->loop         = header[8];
+  playlist->loop_cnt     = header[9];
+  playlist->loop_mode    = header[10];
+  playlist->reset        = header[11];
+
+  if (playlist->mrl_cur < 0)
+    playlist->mrl_cur = 0;
+
+  return cnt;
 }
@@ -29,17 +29,24 @@ void pl_playlist_free (playlist_t *playlist);
 void pl_playlist_set_loop (playlist_t *playlist, int loop, player_loop_t mode);
 void pl_playlist_set_shuffle (playlist_t *playlist, int shuffle);
 int pl_playlist_next_play (playlist_t *playlist);
+mrl_t *pl_playlist_next_play_peek (playlist_t *playlist);
 int pl_playlist_count_mrl (playlist_t *playlist);
 mrl_t *pl_playlist_get_mrl (playlist_t *playlist);
 void pl_playlist_set_mrl (playlist_t *playlist, mrl_t *mrl);
 void pl_playlist_append_mrl (playlist_t *playlist, mrl_t *mrl);
+void pl_playlist_append_bulk (playlist_t *playlist, mrl_t **list, int n);
 int pl_playlist_next_mrl_available (playlist_t *playlist);
 void pl_playlist_next_mrl (playlist_t *playlist);
 int pl_playlist_previous_mrl_available (playlist_t *playlist);
 void pl_playlist_previous_mrl (playlist_t *playlist);
 void pl_playlist_first_mrl (playlist_t *playlist);
 void pl_playlist_last_mrl (playlist_t *playlist);
+int pl_playlist_goto_mrl (playlist_t *playlist, int idx);
 void pl_playlist_remove_mrl (playlist_t *playlist);
 void pl_playlist_empty (playlist_t *playlist);
 
+int pl_playlist_save (playlist_t *playlist, const char *path, uint32_t wrapper);
+int pl_playlist_load (playlist_t *playlist,
+                      const char *path, uint32_t wrapper, int pack);
+
 #endif /* PLAYLIST_H */
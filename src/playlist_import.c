@@ -0,0 +1,523 @@
+/*
+ * GeeXboX libplayer: a multimedia A/V abstraction layer API.
+ * Copyright (C) 2010 Mathieu Schroeter <mathieu@schroetersa.ch>
+ *
+ * This file is part of libplayer.
+ *
+ * libplayer is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * libplayer is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with libplayer; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/*
+ * Streaming importer for M3U, PLS and XSPF playlists.
+ *
+ * The file is mapped in memory and parsed in one pass. The MRLs are created
+ * without probe (see mrl_sv_new_lazy()) and appended to the playlist by
+ * chunks, the callback of the application is called after each chunk.
+ */
+
+#define _GNU_SOURCE /* memmem */
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <ctype.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+
+#include "player.h"
+#include "player_internals.h"
+#include "logs.h"
+#include "playlist.h"
+#include "playlist_import.h"
+
+#define MODULE_NAME "playlist_import"
+
+#define IMPORT_CHUNK 512
+
+typedef enum import_format {
+  IMPORT_M3U,
+  IMPORT_PLS,
+  IMPORT_XSPF,
+} import_format_t;
+
+typedef struct import_s {
+  player_t *player;
+  const char *dir;      /* directory of the playlist for relative paths */
+  size_t dir_len;
+
+  mrl_t *chunk[IMPORT_CHUNK];
+  int nb;               /* MRLs in the chunk */
+  int entries;          /* MRLs appended to the playlist */
+  int skipped;
+
+  off_t size;
+  player_playlist_import_cb_t cb;
+  void *data;
+} import_t;
+
+static const struct {
+  const char *scheme;
+  mrl_resource_t res;
+} g_import_schemes[] = {
+  { "ftp://",   MRL_RESOURCE_FTP  },
+  { "http://",  MRL_RESOURCE_HTTP },
+  { "mms://",   MRL_RESOURCE_MMS  },
+  { "rtp://",   MRL_RESOURCE_RTP  },
+  { "rtsp://",  MRL_RESOURCE_RTSP },
+  { "smb://",   MRL_RESOURCE_SMB  },
+  { "tcp://",   MRL_RESOURCE_TCP  },
+  { "udp://",   MRL_RESOURCE_UDP  },
+  { "unsv://",  MRL_RESOURCE_UNSV },
+};
+
+
+static import_format_t
+import_format (const char *path, const char *map, size_t size)
+{
+  const char *ext;
+  size_t i = 0;
+
+  ext = strrchr (path, '.');
+  if (ext)
+  {
+    if (!strcasecmp (ext, ".pls"))
+      return IMPORT_PLS;
+    if (!strcasecmp (ext, ".xspf"))
+      return IMPORT_XSPF;
+    if (!strcasecmp (ext, ".m3u") || !strcasecmp (ext, ".m3u8"))
+      return IMPORT_M3U;
+  }
+
+  /* unknown extension, look at the content */
+  if (size >= 3 && !memcmp (map, "\xEF\xBB\xBF", 3)) /* UTF-8 BOM */
+    i = 3;
+  while (i < size && isspace ((unsigned char) map[i]))
+    i++;
+
+  if (i < size && map[i] == '<')
+    return IMPORT_XSPF;
+  if (size - i >= 10 && !strncasecmp (map + i, "[playlist]", 10))
+    return IMPORT_PLS;
+
+  return IMPORT_M3U;
+}
+
+static int
+hex_value (char c)
+{
+  if (c >= '0' && c <= '9')
+    return c - '0';
+  if (c >= 'a' && c <= 'f')
+    return c - 'a' + 10;
+  if (c >= 'A' && c <= 'F')
+    return c - 'A' + 10;
+  return -1;
+}
+
+/* decode the %XX sequences of an URL (in place) */
+static void
+import_url_decode (char *str)
+{
+  char *out = str;
+
+  for (; *str; str++)
+  {
+    int h, l;
+
+    if (*str == '%'
+        && (h = hex_value (str[1])) >= 0 && (l = hex_value (str[2])) >= 0)
+    {
+      *out++ = (char) (h << 4 | l);
+      str += 2;
+    }
+    else
+      *out++ = *str;
+  }
+  *out = '\0';
+}
+
+static char *
+import_utf8 (char *out, unsigned long c)
+{
+  if (c < 0x80)
+    *out++ = (char) c;
+  else if (c < 0x800)
+  {
+    *out++ = (char) (0xC0 | c >> 6);
+    *out++ = (char) (0x80 | (c & 0x3F));
+  }
+  else if (c < 0x10000)
+  {
+    *out++ = (char) (0xE0 | c >> 12);
+    *out++ = (char) (0x80 | (c >> 6 & 0x3F));
+    *out++ = (char) (0x80 | (c & 0x3F));
+  }
+  else
+  {
+    *out++ = (char) (0xF0 | c >> 18);
+    *out++ = (char) (0x80 | (c >> 12 & 0x3F));
+    *out++ = (char) (0x80 | (c >> 6 & 0x3F));
+    *out++ = (char) (0x80 | (c & 0x3F));
+  }
+
+  return out;
+}
+
+/* decode the XML entities (in place), the result is never longer */
+static void
+import_xml_decode (char *str)
+{
+  static const struct {
+    const char *name;
+    char c;
+  } entities[] = {
+    { "amp;",  '&'  },
+    { "lt;",   '<'  },
+    { "gt;",   '>'  },
+    { "quot;", '"'  },
+    { "apos;", '\'' },
+  };
+  char *out = str;
+
+  while (*str)
+  {
+    unsigned int i;
+    char *end;
+
+    if (*str != '&')
+    {
+      *out++ = *str++;
+      continue;
+    }
+
+    if (str[1] == '#')
+    {
+      unsigned long c;
+
+      c = (str[2] == 'x' || str[2] == 'X')
+          ? strtoul (str + 3, &end, 16) : strtoul (str + 2, &end, 10);
+      if (*end == ';' && c && c < 0x110000)
+      {
+        out = import_utf8 (out, c);
+        str = end + 1;
+        continue;
+      }
+    }
+    else
+      for (i = 0; i < ARRAY_NB_ELEMENTS (entities); i++)
+      {
+        size_t len = strlen (entities[i].name);
+        if (!strncmp (str + 1, entities[i].name, len))
+        {
+          *out++ = entities[i].c;
+          str += len + 1;
+          break;
+        }
+      }
+
+    /* unknown entity, keep it as is */
+    if (*str == '&')
+      *out++ = *str++;
+  }
+  *out = '\0';
+}
+
+static void
+import_flush (import_t *im, off_t pos)
+{
+  if (im->nb)
+  {
+    pl_playlist_append_bulk (im->player->playlist, im->chunk, im->nb);
+    im->entries += im->nb;
+    im->nb = 0;
+  }
+
+  if (im->cb)
+    im->cb (im->entries, pos, im->size, im->data);
+}
+
+static mrl_t *
+import_mrl_local (import_t *im, const char *location)
+{
+  mrl_resource_local_args_t *args;
+  mrl_t *mrl;
+  char *path;
+
+  if (*location != '/' && im->dir_len)
+  {
+    path = malloc (im->dir_len + strlen (location) + 2);
+    if (!path)
+      return NULL;
+
+    memcpy (path, im->dir, im->dir_len);
+    path[im->dir_len] = '/';
+    strcpy (path + im->dir_len + 1, location);
+  }
+  else
+    path = strdup (location);
+
+  args = PCALLOC (mrl_resource_local_args_t, 1);
+  if (!path || !args)
+  {
+    PFREE (path);
+    PFREE (args);
+    return NULL;
+  }
+
+  args->location = path;
+
+  mrl = mrl_sv_new_lazy (im->player, MRL_RESOURCE_FILE, args);
+  if (!mrl)
+  {
+    PFREE (args->location);
+    PFREE (args);
+  }
+
+  return mrl;
+}
+
+static mrl_t *
+import_mrl_network (import_t *im, mrl_resource_t res, const char *url)
+{
+  mrl_resource_network_args_t *args;
+  mrl_t *mrl;
+
+  args = PCALLOC (mrl_resource_network_args_t, 1);
+  if (!args)
+    return NULL;
+
+  args->url = strdup (url);
+  if (!args->url)
+  {
+    PFREE (args);
+    return NULL;
+  }
+
+  mrl = mrl_sv_new_lazy (im->player, res, args);
+  if (!mrl)
+  {
+    PFREE (args->url);
+    PFREE (args);
+  }
+
+  return mrl;
+}
+
+static void
+import_entry (import_t *im, const char *str, size_t len, int xml, off_t pos)
+{
+  mrl_t *mrl = NULL;
+  char *entry, *it;
+  unsigned int i;
+
+  /* trim */
+  while (len && isspace ((unsigned char) *str))
+    str++, len--;
+  while (len && isspace ((unsigned char) str[len - 1]))
+    len--;
+
+  if (!len)
+    return;
+
+  entry = strndup (str, len);
+  if (!entry)
+    return;
+
+  if (xml)
+    import_xml_decode (entry);
+
+  it = strstr (entry, "://");
+  if (!it)
+    mrl = import_mrl_local (im, entry);
+  else if (!strncasecmp (entry, "file://", 7))
+  {
+    it = entry + 7;
+    if (!strncasecmp (it, "localhost/", 10))
+      it += 9;
+    import_url_decode (it);
+    mrl = import_mrl_local (im, it);
+  }
+  else
+  {
+    for (i = 0; i < ARRAY_NB_ELEMENTS (g_import_schemes); i++)
+      if (!strncasecmp (entry, g_import_schemes[i].scheme,
+                        strlen (g_import_schemes[i].scheme)))
+      {
+        mrl = import_mrl_network (im, g_import_schemes[i].res, entry);
+        break;
+      }
+  }
+
+  if (!mrl)
+  {
+    pl_log (im->player, PLAYER_MSG_WARNING,
+            MODULE_NAME, "entry ignored: %s", entry);
+    im->skipped++;
+  }
+
+  PFREE (entry);
+
+  if (!mrl)
+    return;
+
+  im->chunk[im->nb++] = mrl;
+  if (im->nb == IMPORT_CHUNK)
+    import_flush (im, pos);
+}
+
+static void
+import_lines (import_t *im, const char *map, size_t size, import_format_t fmt)
+{
+  const char *p = map, *end = map + size, *eol;
+
+  if (size >= 3 && !memcmp (map, "\xEF\xBB\xBF", 3)) /* UTF-8 BOM */
+    p += 3;
+
+  for (; p < end; p = eol + 1)
+  {
+    const char *line = p;
+
+    eol = memchr (p, '\n', end - p);
+    if (!eol)
+      eol = end;
+
+    while (line < eol && isspace ((unsigned char) *line))
+      line++;
+
+    if (line == eol)
+      continue;
+
+    if (fmt == IMPORT_M3U)
+    {
+      if (*line != '#') /* #EXTM3U, #EXTINF, comments */
+        import_entry (im, line, eol - line, 0, eol - map);
+      continue;
+    }
+
+    /* PLS: FileN=location */
+    if (eol - line > 4 && !strncasecmp (line, "file", 4))
+    {
+      const char *it = line + 4;
+
+      while (it < eol && isdigit ((unsigned char) *it))
+        it++;
+
+      if (it > line + 4 && it < eol && *it == '=')
+        import_entry (im, it + 1, eol - it - 1, 0, eol - map);
+    }
+  }
+}
+
+static void
+import_xspf (import_t *im, const char *map, size_t size)
+{
+  const char *p = map, *end = map + size;
+
+  while (p < end)
+  {
+    const char *start, *stop;
+
+    start = memmem (p, end - p, "<location>", 10);
+    if (!start)
+      break;
+    start += 10;
+
+    stop = memmem (start, end - start, "</location>", 11);
+    if (!stop)
+      break;
+
+    import_entry (im, start, stop - start, 1, stop - map);
+    p = stop + 11;
+  }
+}
+
+int
+pl_playlist_import (player_t *player, const char *path,
+                    player_playlist_import_cb_t cb, void *data)
+{
+  import_t *im;
+  import_format_t fmt;
+  struct stat st;
+  const char *it;
+  char *map;
+  int fd, entries;
+
+  if (!player || !path)
+    return -1;
+
+  fd = open (path, O_RDONLY);
+  if (fd < 0)
+  {
+    pl_log (player, PLAYER_MSG_ERROR,
+            MODULE_NAME, "unable to open the playlist %s", path);
+    return -1;
+  }
+
+  if (fstat (fd, &st) || !st.st_size)
+  {
+    close (fd);
+    return 0;
+  }
+
+  map = mmap (NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close (fd);
+  if (map == MAP_FAILED)
+  {
+    pl_log (player, PLAYER_MSG_ERROR,
+            MODULE_NAME, "unable to map the playlist %s", path);
+    return -1;
+  }
+
+  madvise (map, st.st_size, MADV_SEQUENTIAL);
+
+  im = PCALLOC (import_t, 1);
+  if (!im)
+  {
+    munmap (map, st.st_size);
+    return -1;
+  }
+
+  im->player = player;
+  im->size   = st.st_size;
+  im->cb     = cb;
+  im->data   = data;
+
+  it = strrchr (path, '/');
+  if (it)
+  {
+    im->dir     = path;
+    im->dir_len = it - path;
+  }
+
+  fmt = import_format (path, map, st.st_size);
+  if (fmt == IMPORT_XSPF)
+    import_xspf (im, map, st.st_size);
+  else
+    import_lines (im, map, st.st_size, fmt);
+
+  import_flush (im, st.st_size);
+
+  pl_log (player, PLAYER_MSG_INFO, MODULE_NAME,
+          "%i entries imported from %s (%i ignored)",
+          im->entries, path, im->skipped);
+
+  entries = im->entries;
+  PFREE (im);
+  munmap (map, st.st_size);
+
+  return entries;
+}
@@ -0,0 +1,893 @@
+/*
+ * GeeXboX libplayer: a multimedia A/V abstraction layer API.
+ * Copyright (C) 2010 Mathieu Schroeter <mathieu@schroetersa.ch>
+ *
+ * This file is part of libplayer.
+ *
+ * libplayer is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * libplayer is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with libplayer; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/*
+ * The probe cache is an append-only file. A header is followed by records,
+ * one record for each probe:
+ *
+ *  header: magic (u32), version (u32), clock (u32)
+ *  record: length (u32), last use (u32), wrapper (u32), file size (u64),
+ *          file mtime (u64), location (str), facets (u32), properties,
+ *          metadata
+ *
+ * A string is saved with its length (u32, '\0' included) followed by the
+ * characters. A NULL string has a length of 0.
+ *
+ * When a location is probed again, a new record is appended and the old one
+ * is simply forgotten. The file is compacted when its size limit is reached;
+ * the least recently used records are evicted at this time. The clock of the
+ * header is incremented with each hit or append, and its value is written in
+ * place in the last use of the record; the order is kept across the restarts
+ * and is the same for all processes.
+ *
+ * The file can be shared by several processes. It is locked (flock) while it
+ * is read or written, and the records appended by the other processes are
+ * indexed at this time. A compaction replaces the file (rename), then the
+ * other processes reopen it when they see a new inode behind the path.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <sys/file.h>
+
+#include "player.h"
+#include "player_internals.h"
+#include "logs.h"
+#include "probe_cache.h"
+#include "serialize.h"
+
+#define MODULE_NAME "probe_cache"
+
+#define PROBE_CACHE_MAGIC     0x4c505043 /* LPPC */
+#define PROBE_CACHE_VERSION   3
+#define PROBE_CACHE_HEADER    (3 * sizeof (uint32_t))
+#define PROBE_CACHE_CLOCK     (2 * sizeof (uint32_t)) /* offset in header */
+#define PROBE_CACHE_BUCKETS   4096
+#define PROBE_CACHE_SIZE_DEF  (16 * 1024 * 1024)
+
+#define FACET_PROPERTIES (1 << 0)
+#define FACET_METADATA   (1 << 1)
+
+typedef struct probe_cache_entry_s {
+  char *location;
+  uint32_t wrapper;
+  uint64_t size;
+  uint64_t mtime;
+  uint32_t facets;
+
+  off_t rec_off;            /* offset of the record in the file */
+  uint32_t rec_len;         /* length of the whole record */
+  off_t data_off;           /* offset of the properties and metadata */
+  uint32_t data_len;
+
+  uint32_t last;            /* last use, see probe_cache_compact() */
+  struct probe_cache_entry_s *next;
+} probe_cache_entry_t;
+
+struct probe_cache_s {
+  char *path;
+  int fd;
+  off_t size;               /* size of the file */
+  off_t max;
+
+  uint8_t *map;
+  off_t map_size;
+
+  probe_cache_entry_t *buckets[PROBE_CACHE_BUCKETS];
+  uint32_t entries;
+
+  uint32_t hits;
+  uint32_t misses;
+  uint32_t evictions;
+
+  int refcnt;
+  pthread_mutex_t mutex;
+  struct probe_cache_s *next;
+};
+
+/* all caches of the process, shared by the player controllers */
+static probe_cache_t *g_caches;
+static pthread_mutex_t g_caches_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+/*****************************************************************************/
+/*                              Index (in memory)                            */
+/*****************************************************************************/
+
+static unsigned int
+probe_cache_hash (const char *location, uint32_t wrapper)
+{
+  unsigned int hash = 5381 + wrapper;
+
+  while (*location)
+    hash = hash * 33 + (unsigned char) *location++;
+
+  return hash % PROBE_CACHE_BUCKETS;
+}
+
+static probe_cache_entry_t *
+probe_cache_lookup (probe_cache_t *cache,
+                    const char *location, uint32_t wrapper)
+{
+  probe_cache_entry_t *entry;
+
+  entry = cache->buckets[probe_cache_hash (location, wrapper)];
+  for (; entry; entry = entry->next)
+    if (entry->wrapper == wrapper && !strcmp (entry->location, location))
+      return entry;
+
+  return NULL;
+}
+
+static void
+probe_cache_remove (probe_cache_t *cache, probe_cache_entry_t *entry)
+{
+  probe_cache_entry_t **it;
+
+  it = &cache->buckets[probe_cache_hash (entry->location, entry->wrapper)];
+  for (; *it; it = &(*it)->next)
+    if (*it == entry)
+    {
+      *it = entry->next;
+      break;
+    }
+
+  PFREE (entry->location);
+  PFREE (entry);
+  cache->entries--;
+}
+
+/*
+ * The location is stolen by the index.
+ * The entry is updated if the location is already in the index.
+ */
+static probe_cache_entry_t *
+probe_cache_insert (probe_cache_t *cache, char *location, uint32_t wrapper)
+{
+  probe_cache_entry_t *entry;
+  unsigned int hash;
+
+  entry = probe_cache_lookup (cache, location, wrapper);
+  if (entry)
+  {
+    PFREE (location);
+    return entry;
+  }
+
+  entry = PCALLOC (probe_cache_entry_t, 1);
+  if (!entry)
+  {
+    PFREE (location);
+    return NULL;
+  }
+
+  hash = probe_cache_hash (location, wrapper);
+  entry->location = location;
+  entry->wrapper  = wrapper;
+  entry->next     = cache->buckets[hash];
+  cache->buckets[hash] = entry;
+  cache->entries++;
+
+  return entry;
+}
+
+static void
+probe_cache_clear (probe_cache_t *cache)
+{
+  unsigned int i;
+
+  for (i = 0; i < PROBE_CACHE_BUCKETS; i++)
+    while (cache->buckets[i])
+      probe_cache_remove (cache, cache->buckets[i]);
+}
+
+/*****************************************************************************/
+/*                                File mapping                               */
+/*****************************************************************************/
+
+static void
+probe_cache_unmap (probe_cache_t *cache)
+{
+  if (cache->map)
+    munmap (cache->map, cache->map_size);
+
+  cache->map = NULL;
+  cache->map_size = 0;
+}
+
+static int
+probe_cache_map (probe_cache_t *cache)
+{
+  if (cache->map && cache->map_size == cache->size)
+    return 0;
+
+  probe_cache_unmap (cache);
+
+  if (!cache->size)
+    return -1;
+
+  cache->map = mmap (NULL, cache->size, PROT_READ, MAP_SHARED, cache->fd, 0);
+  if (cache->map == MAP_FAILED)
+  {
+    cache->map = NULL;
+    return -1;
+  }
+
+  cache->map_size = cache->size;
+  return 0;
+}
+
+static int
+probe_cache_write_header (int fd, uint32_t clock)
+{
+  uint32_t header[3] = { PROBE_CACHE_MAGIC, PROBE_CACHE_VERSION, clock };
+
+  if (ftruncate (fd, 0))
+    return -1;
+
+  if (pwrite (fd, header, sizeof (header), 0) != sizeof (header))
+    return -1;
+
+  return 0;
+}
+
+static void
+probe_cache_scan (player_t *player, probe_cache_t *cache, off_t off)
+{
+  while (off + (off_t) sizeof (uint32_t) <= cache->size)
+  {
+    serial_reader_t rd;
+    probe_cache_entry_t *entry;
+    uint32_t len, last, wrapper, facets;
+    uint64_t size, mtime;
+    char *location;
+
+    memcpy (&len, cache->map + off, sizeof (len));
+    if (off + (off_t) sizeof (len) + len > cache->size)
+      break;
+
+    rd.it  = cache->map + off + sizeof (len);
+    rd.end = rd.it + len;
+    rd.err = 0;
+
+    last     = pl_serial_get_u32 (&rd);
+    wrapper  = pl_serial_get_u32 (&rd);
+    size     = pl_serial_get_u64 (&rd);
+    mtime    = pl_serial_get_u64 (&rd);
+    location = pl_serial_get_str (&rd);
+    facets   = pl_serial_get_u32 (&rd);
+
+    if (rd.err || !location)
+    {
+      PFREE (location);
+      break;
+    }
+
+    entry = probe_cache_insert (cache, location, wrapper);
+    if (entry)
+    {
+      entry->size     = size;
+      entry->mtime    = mtime;
+      entry->facets   = facets;
+      entry->last     = last;
+      entry->rec_off  = off;
+      entry->rec_len  = sizeof (len) + len;
+      entry->data_off = rd.it - cache->map;
+      entry->data_len = rd.end - rd.it;
+    }
+
+    off += sizeof (len) + len;
+  }
+
+  /* drop a truncated record (crash while appending for example) */
+  if (off < cache->size)
+  {
+    pl_log (player, PLAYER_MSG_WARNING, MODULE_NAME,
+            "%s: truncated at %"PRIi64, cache->path, (int64_t) off);
+    if (!ftruncate (cache->fd, off))
+    {
+      cache->size = off;
+      probe_cache_map (cache);
+    }
+  }
+}
+
+/*
+ * (Re)build the index from the whole file. The file must be locked.
+ */
+static int
+probe_cache_load (player_t *player, probe_cache_t *cache, off_t size)
+{
+  uint32_t header[2];
+
+  probe_cache_clear (cache);
+  probe_cache_unmap (cache);
+  cache->size = size;
+
+  if (cache->size < (off_t) PROBE_CACHE_HEADER
+      || pread (cache->fd, header, sizeof (header), 0) != sizeof (header)
+      || header[0] != PROBE_CACHE_MAGIC || header[1] != PROBE_CACHE_VERSION)
+  {
+    if (cache->size)
+      pl_log (player, PLAYER_MSG_WARNING,
+              MODULE_NAME, "%s: incompatible file, reset", cache->path);
+
+    if (probe_cache_write_header (cache->fd, 0))
+      return -1;
+    cache->size = PROBE_CACHE_HEADER;
+  }
+
+  if (probe_cache_map (cache))
+    return -1;
+
+  probe_cache_scan (player, cache, PROBE_CACHE_HEADER);
+  return 0;
+}
+
+static int
+probe_cache_entry_cmp (const void *a, const void *b)
+{
+  const probe_cache_entry_t *ea = *(probe_cache_entry_t * const *) a;
+  const probe_cache_entry_t *eb = *(probe_cache_entry_t * const *) b;
+
+  /* most recently used first */
+  return ea->last < eb->last ? 1 : ea->last > eb->last ? -1 : 0;
+}
+
+/*
+ * Rewrite the file with only the most recently used records, in order to
+ * keep (at most) 3/4 of the size limit.
+ */
+static void
+probe_cache_compact (player_t *player, probe_cache_t *cache)
+{
+  probe_cache_entry_t **list;
+  probe_cache_entry_t *entry;
+  unsigned int i, nb = 0;
+  size_t len;
+  char *tmp;
+  off_t off = PROBE_CACHE_HEADER;
+  off_t limit = cache->max / 4 * 3;
+  uint32_t clock;
+  int fd;
+
+  if (probe_cache_map (cache))
+    return;
+
+  list = PCALLOC (probe_cache_entry_t *, cache->entries);
+  if (!list && cache->entries)
+    return;
+
+  /* the last uses are maybe updated in place by the other processes */
+  for (i = 0; i < PROBE_CACHE_BUCKETS; i++)
+    for (entry = cache->buckets[i]; entry; entry = entry->next)
+    {
+      memcpy (&entry->last, cache->map + entry->rec_off + sizeof (uint32_t),
+              sizeof (entry->last));
+      list[nb++] = entry;
+    }
+
+  memcpy (&clock, cache->map + PROBE_CACHE_CLOCK, sizeof (clock));
+
+  qsort (list, nb, sizeof (*list), probe_cache_entry_cmp);
+
+  len = strlen (cache->path) + 5;
+  tmp = malloc (len);
+  if (!tmp)
+    goto out;
+  snprintf (tmp, len, "%s.tmp", cache->path);
+
+  fd = open (tmp, O_RDWR | O_CREAT | O_TRUNC, 0644);
+  if (fd < 0 || probe_cache_write_header (fd, clock))
+  {
+    if (fd >= 0)
+      close (fd);
+    goto out;
+  }
+
+  for (i = 0; i < nb; i++)
+  {
+    entry = list[i];
+
+    if (off + entry->rec_len > limit
+        || pwrite (fd, cache->map + entry->rec_off,
+                   entry->rec_len, off) != (ssize_t) entry->rec_len)
+    {
+      probe_cache_remove (cache, entry);
+      cache->evictions++;
+      continue;
+    }
+
+    entry->data_off = off + (entry->data_off - entry->rec_off);
+    entry->rec_off  = off;
+    off += entry->rec_len;
+  }
+
+  /* the other processes must wait until this record is appended */
+  if (flock (fd, LOCK_EX) || rename (tmp, cache->path))
+  {
+    /* the old file is unchanged, but not the index */
+    close (fd);
+    unlink (tmp);
+    if (probe_cache_load (player, cache, cache->size))
+      probe_cache_clear (cache);
+    goto out;
+  }
+
+  probe_cache_unmap (cache);
+  close (cache->fd);
+  cache->fd = fd;
+  cache->size = off;
+  probe_cache_map (cache);
+
+  pl_log (player, PLAYER_MSG_INFO, MODULE_NAME,
+          "%s: compacted, %u entries", cache->path, cache->entries);
+
+ out:
+  PFREE (tmp);
+  PFREE (list);
+}
+
+/*
+ * A record is used: the clock of the header is incremented and saved in the
+ * record. The file must be locked.
+ */
+static void
+probe_cache_touch (probe_cache_t *cache, probe_cache_entry_t *entry)
+{
+  uint32_t clock;
+
+  if (pread (cache->fd, &clock, sizeof (clock),
+             PROBE_CACHE_CLOCK) != sizeof (clock))
+    return;
+
+  clock++;
+  if (pwrite (cache->fd, &clock, sizeof (clock),
+              PROBE_CACHE_CLOCK) != sizeof (clock)
+      || pwrite (cache->fd, &clock, sizeof (clock),
+                 entry->rec_off + sizeof (uint32_t)) != sizeof (clock))
+    return;
+
+  entry->last = clock;
+}
+
+/*
+ * Lock the file for this process and synchronize the index with the records
+ * written by the other processes since the last lock.
+ */
+static int
+probe_cache_lock (player_t *player, probe_cache_t *cache)
+{
+  struct stat st_fd, st_path;
+  off_t old;
+  int fd;
+
+  for (;;)
+  {
+    if (flock (cache->fd, LOCK_EX))
+      return -1;
+
+    if (fstat (cache->fd, &st_fd))
+      goto err;
+
+    if (!stat (cache->path, &st_path)
+        && st_path.st_dev == st_fd.st_dev && st_path.st_ino == st_fd.st_ino)
+      break;
+
+    /* compacted (or removed) by an other process, reopen the path */
+    fd = open (cache->path, O_RDWR | O_CREAT, 0644);
+    if (fd < 0)
+      goto err;
+
+    probe_cache_clear (cache);
+    probe_cache_unmap (cache);
+    close (cache->fd);
+    cache->fd = fd;
+    cache->size = 0;
+  }
+
+  if (cache->map && st_fd.st_size == cache->size)
+    return 0;
+
+  /* not yet loaded, or reset (truncated) by an other process */
+  if (!cache->map || st_fd.st_size < cache->size)
+  {
+    if (probe_cache_load (player, cache, st_fd.st_size))
+      goto err;
+    return 0;
+  }
+
+  /* new records appended by an other process */
+  old = cache->size;
+  cache->size = st_fd.st_size;
+  if (probe_cache_map (cache))
+    goto err;
+  probe_cache_scan (player, cache, old);
+  return 0;
+
+ err:
+  flock (cache->fd, LOCK_UN);
+  return -1;
+}
+
+static void
+probe_cache_unlock (probe_cache_t *cache)
+{
+  flock (cache->fd, LOCK_UN);
+}
+
+/*****************************************************************************/
+/*                              Cache location                               */
+/*****************************************************************************/
+
+/*
+ * Only the local files are cached, because the size and the time of the last
+ * modification are necessary in order to detect the changes.
+ */
+static char *
+probe_cache_location (mrl_t *mrl, struct stat *st)
+{
+  mrl_resource_local_args_t *args;
+  const char *location;
+  char *path;
+
+  if (!mrl || mrl->resource != MRL_RESOURCE_FILE)
+    return NULL;
+
+  args = mrl->priv;
+  if (!args || !args->location)
+    return NULL;
+
+  location = args->location;
+  if (strstr (location, "file://") == location)
+    location += 7;
+
+  path = realpath (location, NULL);
+  if (!path)
+    return NULL;
+
+  if (stat (path, st) || !S_ISREG (st->st_mode))
+  {
+    PFREE (path);
+    return NULL;
+  }
+
+  return path;
+}
+
+/*****************************************************************************/
+/*                           Probe cache functions                           */
+/*****************************************************************************/
+
+probe_cache_t *
+pl_probe_cache_open (player_t *player, const char *path, off_t max)
+{
+  probe_cache_t *cache;
+
+  if (!path)
+    return NULL;
+
+  pthread_mutex_lock (&g_caches_mutex);
+
+  for (cache = g_caches; cache; cache = cache->next)
+    if (!strcmp (cache->path, path))
+    {
+      cache->refcnt++;
+      pthread_mutex_unlock (&g_caches_mutex);
+      return cache;
+    }
+
+  cache = PCALLOC (probe_cache_t, 1);
+  if (!cache)
+    goto err;
+
+  cache->path = strdup (path);
+  cache->max  = max > 0 ? max : PROBE_CACHE_SIZE_DEF;
+  cache->fd   = open (path, O_RDWR | O_CREAT, 0644);
+  if (cache->fd < 0 || probe_cache_lock (player, cache))
+  {
+    pl_log (player, PLAYER_MSG_ERROR,
+            MODULE_NAME, "unable to open the probe cache (%s)", path);
+    goto err;
+  }
+
+  probe_cache_unlock (cache);
+
+  pl_log (player, PLAYER_MSG_INFO, MODULE_NAME,
+          "%s: %u entries", path, cache->entries);
+
+  pthread_mutex_init (&cache->mutex, NULL);
+  cache->refcnt = 1;
+  cache->next = g_caches;
+  g_caches = cache;
+
+  pthread_mutex_unlock (&g_caches_mutex);
+  return cache;
+
+ err:
+  if (cache)
+  {
+    probe_cache_clear (cache);
+    probe_cache_unmap (cache);
+    if (cache->fd >= 0)
+      close (cache->fd);
+    PFREE (cache->path);
+    PFREE (cache);
+  }
+  pthread_mutex_unlock (&g_caches_mutex);
+  return NULL;
+}
+
+void
+pl_probe_cache_close (player_t *player, probe_cache_t *cache)
+{
+  probe_cache_t **it;
+
+  if (!cache)
+    return;
+
+  pthread_mutex_lock (&g_caches_mutex);
+
+  if (--cache->refcnt > 0)
+  {
+    pthread_mutex_unlock (&g_caches_mutex);
+    return;
+  }
+
+  for (it = &g_caches; *it; it = &(*it)->next)
+    if (*it == cache)
+    {
+      *it = cache->next;
+      break;
+    }
+
+  pthread_mutex_unlock (&g_caches_mutex);
+
+  pl_log (player, PLAYER_MSG_INFO, MODULE_NAME,
+          "%s: %u hits, %u misses", cache->path, cache->hits, cache->misses);
+
+  probe_cache_clear (cache);
+  probe_cache_unmap (cache);
+  close (cache->fd);
+  pthread_mutex_destroy (&cache->mutex);
+  PFREE (cache->path);
+  PFREE (cache);
+}
+
+/*
+ * Restore the properties and (or) the metadata of a MRL. The facets not yet
+ * set in the MRL are restored when available, but the function succeeds only
+ * if all facets in \p flags (IDENTIFY_PROPERTIES, IDENTIFY_METADATA) are
+ * available.
+ */
+int
+pl_probe_cache_get (player_t *player,
+                    probe_cache_t *cache, mrl_t *mrl, int flags)
+{
+  probe_cache_entry_t *entry;
+  serial_reader_t rd;
+  struct stat st;
+  char *location;
+  uint32_t facets = 0;
+  mrl_properties_t *prop = NULL;
+  mrl_metadata_t *meta = NULL;
+
+  if (!cache || !mrl)
+    return 0;
+
+  location = probe_cache_location (mrl, &st);
+  if (!location)
+    return 0;
+
+  if (flags & IDENTIFY_PROPERTIES)
+    facets |= FACET_PROPERTIES;
+  if (flags & IDENTIFY_METADATA)
+    facets |= FACET_METADATA;
+
+  pthread_mutex_lock (&cache->mutex);
+
+  if (probe_cache_lock (player, cache))
+  {
+    pthread_mutex_unlock (&cache->mutex);
+    PFREE (location);
+    return 0;
+  }
+
+  entry = probe_cache_lookup (cache, location, player->type);
+  if (entry && (entry->size  != (uint64_t) st.st_size ||
+                entry->mtime != (uint64_t) st.st_mtime))
+  {
+    /* outdated, the record will be dropped with the next compaction */
+    probe_cache_remove (cache, entry);
+    entry = NULL;
+  }
+
+  if (!entry || (entry->facets & facets) != facets || probe_cache_map (cache))
+    goto miss;
+
+  rd.it  = cache->map + entry->data_off;
+  rd.end = rd.it + entry->data_len;
+  rd.err = 0;
+
+  if (entry->facets & FACET_PROPERTIES)
+  {
+    prop = pl_serial_get_properties (&rd);
+    if (!prop)
+      goto miss;
+  }
+
+  if (entry->facets & FACET_METADATA)
+  {
+    meta = pl_serial_get_metadata (&rd, mrl->resource);
+    if (!meta)
+      goto miss;
+  }
+
+  probe_cache_touch (cache, entry);
+  cache->hits++;
+  probe_cache_unlock (cache);
+  pthread_mutex_unlock (&cache->mutex);
+
+  if (prop && !mrl->prop)
+    mrl->prop = prop;
+  else if (prop)
+    mrl_properties_free (prop);
+
+  if (meta && !mrl->meta)
+    mrl->meta = meta;
+  else if (meta)
+    mrl_metadata_free (meta, mrl->resource);
+
+  pl_log (player, PLAYER_MSG_VERBOSE, MODULE_NAME, "hit: %s", location);
+  PFREE (location);
+  return 1;
+
+ miss:
+  cache->misses++;
+  probe_cache_unlock (cache);
+  pthread_mutex_unlock (&cache->mutex);
+
+  if (prop)
+    mrl_properties_free (prop);
+
+  pl_log (player, PLAYER_MSG_VERBOSE, MODULE_NAME, "miss: %s", location);
+  PFREE (location);
+  return 0;
+}
+
+/*
+ * Append the properties and the metadata already available in the MRL.
+ */
+void
+pl_probe_cache_put (player_t *player, probe_cache_t *cache, mrl_t *mrl)
+{
+  probe_cache_entry_t *entry;
+  serial_buf_t buf = { NULL, 0, 0, 0 };
+  struct stat st;
+  char *location;
+  uint32_t facets = 0, len;
+  off_t off;
+  size_t data_off;
+
+  if (!cache || !mrl || (!mrl->prop && !mrl->meta))
+    return;
+
+  location = probe_cache_location (mrl, &st);
+  if (!location)
+    return;
+
+  if (mrl->prop)
+    facets |= FACET_PROPERTIES;
+  if (mrl->meta)
+    facets |= FACET_METADATA;
+
+  pl_serial_put_u32 (&buf, 0); /* length, set below */
+  pl_serial_put_u32 (&buf, 0); /* last use, see probe_cache_touch() */
+  pl_serial_put_u32 (&buf, player->type);
+  pl_serial_put_u64 (&buf, (uint64_t) st.st_size);
+  pl_serial_put_u64 (&buf, (uint64_t) st.st_mtime);
+  pl_serial_put_str (&buf, location);
+  pl_serial_put_u32 (&buf, facets);
+  data_off = buf.len;
+
+  if (mrl->prop)
+    pl_serial_put_properties (&buf, mrl->prop);
+  if (mrl->meta)
+    pl_serial_put_metadata (&buf, mrl->meta, mrl->resource);
+
+  if (buf.err)
+  {
+    PFREE (location);
+    PFREE (buf.data);
+    return;
+  }
+
+  len = buf.len - sizeof (len);
+  memcpy (buf.data, &len, sizeof (len));
+
+  pthread_mutex_lock (&cache->mutex);
+
+  if ((off_t) buf.len > cache->max - (off_t) PROBE_CACHE_HEADER
+      || probe_cache_lock (player, cache))
+  {
+    pthread_mutex_unlock (&cache->mutex);
+    goto out;
+  }
+
+  if (cache->size + (off_t) buf.len > cache->max)
+    probe_cache_compact (player, cache);
+
+  off = cache->size;
+  if (pwrite (cache->fd, buf.data, buf.len, off) != (ssize_t) buf.len)
+  {
+    pl_log (player, PLAYER_MSG_WARNING,
+            MODULE_NAME, "%s: unable to append", cache->path);
+    if (ftruncate (cache->fd, off))
+      pl_log (player, PLAYER_MSG_ERROR,
+              MODULE_NAME, "%s: unable to truncate", cache->path);
+    goto unlock;
+  }
+
+  cache->size += buf.len;
+
+  entry = probe_cache_insert (cache, location, player->type);
+  location = NULL;
+  if (entry)
+  {
+    entry->size     = st.st_size;
+    entry->mtime    = st.st_mtime;
+    entry->facets   = facets;
+    entry->rec_off  = off;
+    entry->rec_len  = buf.len;
+    entry->data_off = off + data_off;
+    entry->data_len = buf.len - data_off;
+    probe_cache_touch (cache, entry);
+  }
+
+ unlock:
+  probe_cache_unlock (cache);
+  pthread_mutex_unlock (&cache->mutex);
+ out:
+  PFREE (location);
+  PFREE (buf.data);
+}
+
+void
+pl_probe_cache_stats (probe_cache_t *cache, player_probe_cache_stats_t *stats)
+{
+  if (!cache || !stats)
+    return;
+
+  pthread_mutex_lock (&cache->mutex);
+  stats->hits      = cache->hits;
+  stats->misses    = cache->misses;
+  stats->entries   = cache->entries;
+  stats->evictions = cache->evictions;
+  stats->size      = cache->size;
+  pthread_mutex_unlock (&cache->mutex);
+}
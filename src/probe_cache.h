@@ -0,0 +1,39 @@
+/*
+ * GeeXboX libplayer: a multimedia A/V abstraction layer API.
+ * Copyright (C) 2010 Mathieu Schroeter <mathieu@schroetersa.ch>
+ *
+ * This file is part of libplayer.
+ *
+ * libplayer is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * libplayer is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with libplayer; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#ifndef PROBE_CACHE_H
+#define PROBE_CACHE_H
+
+#include <sys/types.h>
+
+typedef struct probe_cache_s probe_cache_t;
+
+probe_cache_t *pl_probe_cache_open (player_t *player,
+                                    const char *path, off_t max);
+void pl_probe_cache_close (player_t *player, probe_cache_t *cache);
+
+int pl_probe_cache_get (player_t *player,
+                        probe_cache_t *cache, mrl_t *mrl, int flags);
+void pl_probe_cache_put (player_t *player, probe_cache_t *cache, mrl_t *mrl);
+void pl_probe_cache_stats (probe_cache_t *cache,
+                           player_probe_cache_stats_t *stats);
+
+#endif /* PROBE_CACHE_H */
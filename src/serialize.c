@@ -0,0 +1,762 @@
+/*
+ * GeeXboX libplayer: a multimedia A/V abstraction layer API.
+ * Copyright (C) 2010 Mathieu Schroeter <mathieu@schroetersa.ch>
+ *
+ * This file is part of libplayer.
+ *
+ * libplayer is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * libplayer is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with libplayer; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/*
+ * Binary serialization of the MRLs, shared by the probe cache and the
+ * playlist snapshots. The values are saved in the host byte order.
+ *
+ * A string is saved with its length (u32, '\0' included) followed by the
+ * characters. A NULL string has a length of 0.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+
+#include "player.h"
+#include "player_internals.h"
+#include "serialize.h"
+
+/*****************************************************************************/
+/*                                 Buffers                                   */
+/*****************************************************************************/
+
+void
+pl_serial_put (serial_buf_t *buf, const void *data, size_t len)
+{
+  if (buf->len + len > buf->alloc)
+  {
+    size_t alloc = buf->alloc ? buf->alloc : 256;
+    uint8_t *tmp;
+
+    while (alloc < buf->len + len)
+      alloc *= 2;
+
+    tmp = realloc (buf->data, alloc);
+    if (!tmp)
+    {
+      buf->err = 1;
+      return;
+    }
+
+    buf->data  = tmp;
+    buf->alloc = alloc;
+  }
+
+  memcpy (buf->data + buf->len, data, len);
+  buf->len += len;
+}
+
+void
+pl_serial_put_u32 (serial_buf_t *buf, uint32_t val)
+{
+  pl_serial_put (buf, &val, sizeof (val));
+}
+
+void
+pl_serial_put_u64 (serial_buf_t *buf, uint64_t val)
+{
+  pl_serial_put (buf, &val, sizeof (val));
+}
+
+void
+pl_serial_put_str (serial_buf_t *buf, const char *str)
+{
+  uint32_t len = str ? strlen (str) + 1 : 0;
+
+  pl_serial_put_u32 (buf, len);
+  if (len)
+    pl_serial_put (buf, str, len);
+}
+
+void
+pl_serial_get (serial_reader_t *rd, void *data, size_t len)
+{
+  if (rd->err || rd->it + len > rd->end)
+  {
+    rd->err = 1;
+    memset (data, 0, len);
+    return;
+  }
+
+  memcpy (data, rd->it, len);
+  rd->it += len;
+}
+
+uint32_t
+pl_serial_get_u32 (serial_reader_t *rd)
+{
+  uint32_t val;
+
+  pl_serial_get (rd, &val, sizeof (val));
+  return val;
+}
+
+uint64_t
+pl_serial_get_u64 (serial_reader_t *rd)
+{
+  uint64_t val;
+
+  pl_serial_get (rd, &val, sizeof (val));
+  return val;
+}
+
+char *
+pl_serial_get_str (serial_reader_t *rd)
+{
+  uint32_t len;
+  char *str;
+
+  len = pl_serial_get_u32 (rd);
+  if (!len || rd->err)
+    return NULL;
+
+  if (rd->it + len > rd->end || rd->it[len - 1] != '\0')
+  {
+    rd->err = 1;
+    return NULL;
+  }
+
+  str = strdup ((const char *) rd->it);
+  rd->it += len;
+  return str;
+}
+
+void
+pl_serial_put_properties (serial_buf_t *buf, mrl_properties_t *prop)
+{
+  mrl_properties_audio_t *audio = prop->audio;
+  mrl_properties_video_t *video = prop->video;
+
+  pl_serial_put_u64 (buf, (uint64_t) prop->size);
+  pl_serial_put_u32 (buf, prop->seekable);
+  pl_serial_put_u32 (buf, prop->length);
+
+  pl_serial_put_u32 (buf, !!audio);
+  if (audio)
+  {
+    pl_serial_put_str (buf, audio->codec);
+    pl_serial_put_u32 (buf, audio->bitrate);
+    pl_serial_put_u32 (buf, audio->bits);
+    pl_serial_put_u32 (buf, audio->channels);
+    pl_serial_put_u32 (buf, audio->samplerate);
+  }
+
+  pl_serial_put_u32 (buf, !!video);
+  if (video)
+  {
+    pl_serial_put_str (buf, video->codec);
+    pl_serial_put_u32 (buf, video->bitrate);
+    pl_serial_put_u32 (buf, video->width);
+    pl_serial_put_u32 (buf, video->height);
+    pl_serial_put_u32 (buf, video->aspect);
+    pl_serial_put_u32 (buf, video->channels);
+    pl_serial_put_u32 (buf, video->streams);
+    pl_serial_put_u32 (buf, video->frameduration);
+  }
+}
+
+mrl_properties_t *
+pl_serial_get_properties (serial_reader_t *rd)
+{
+  mrl_properties_t *prop;
+
+  prop = mrl_properties_new ();
+  if (!prop)
+    return NULL;
+
+  prop->size     = (off_t) pl_serial_get_u64 (rd);
+  prop->seekable = pl_serial_get_u32 (rd);
+  prop->length   = pl_serial_get_u32 (rd);
+
+  if (pl_serial_get_u32 (rd))
+  {
+    mrl_properties_audio_t *audio = mrl_properties_audio_new ();
+
+    prop->audio = audio;
+    if (!audio)
+      goto err;
+
+    audio->codec      = pl_serial_get_str (rd);
+    audio->bitrate    = pl_serial_get_u32 (rd);
+    audio->bits       = pl_serial_get_u32 (rd);
+    audio->channels   = pl_serial_get_u32 (rd);
+    audio->samplerate = pl_serial_get_u32 (rd);
+  }
+
+  if (pl_serial_get_u32 (rd))
+  {
+    mrl_properties_video_t *video = mrl_properties_video_new ();
+
+    prop->video = video;
+    if (!video)
+      goto err;
+
+    video->codec         = pl_serial_get_str (rd);
+    video->bitrate       = pl_serial_get_u32 (rd);
+    video->width         = pl_serial_get_u32 (rd);
+    video->height        = pl_serial_get_u32 (rd);
+    video->aspect        = pl_serial_get_u32 (rd);
+    video->channels      = pl_serial_get_u32 (rd);
+    video->streams       = pl_serial_get_u32 (rd);
+    video->frameduration = pl_serial_get_u32 (rd);
+  }
+
+  if (!rd->err)
+    return prop;
+
+ err:
+  mrl_properties_free (prop);
+  return NULL;
+}
+
+/* discid, tracks, then the name and the length of each track */
+static void
+serial_put_cd (serial_buf_t *buf, mrl_metadata_cd_t *cd)
+{
+  uint32_t i;
+
+  pl_serial_put_u32 (buf, cd->discid);
+  pl_serial_put_u32 (buf, cd->tracks);
+
+  pl_serial_put_u32 (buf, cd->track_nb);
+  for (i = 0; i < cd->track_nb; i++)
+  {
+    pl_serial_put_str (buf, cd->track[i].name);
+    pl_serial_put_u32 (buf, cd->track[i].length);
+  }
+}
+
+static int
+serial_get_cd (serial_reader_t *rd, mrl_metadata_cd_t *cd)
+{
+  uint32_t i, nb, tracks;
+
+  /* the tracks are set once the array is restored, as it is bounded by them */
+  cd->discid = pl_serial_get_u32 (rd);
+  tracks     = pl_serial_get_u32 (rd);
+
+  nb = pl_serial_get_u32 (rd);
+  for (i = 0; i < nb && !rd->err; i++)
+  {
+    mrl_metadata_cd_track_t *track = mrl_metadata_cd_get_track (cd, i + 1);
+
+    if (!track)
+      return -1;
+
+    track->name   = pl_serial_get_str (rd);
+    track->length = pl_serial_get_u32 (rd);
+  }
+
+  cd->tracks = tracks;
+  return rd->err ? -1 : 0;
+}
+
+/* volumeid, titles, then the chapters, angles and length of each title */
+static void
+serial_put_dvd (serial_buf_t *buf, mrl_metadata_dvd_t *dvd)
+{
+  uint32_t i;
+
+  pl_serial_put_str (buf, dvd->volumeid);
+  pl_serial_put_u32 (buf, dvd->titles);
+
+  pl_serial_put_u32 (buf, dvd->title_nb);
+  for (i = 0; i < dvd->title_nb; i++)
+  {
+    pl_serial_put_u32 (buf, dvd->title[i].chapters);
+    pl_serial_put_u32 (buf, dvd->title[i].angles);
+    pl_serial_put_u32 (buf, dvd->title[i].length);
+  }
+}
+
+static int
+serial_get_dvd (serial_reader_t *rd, mrl_metadata_dvd_t *dvd)
+{
+  uint32_t i, nb, titles;
+
+  /* same as serial_get_cd() */
+  dvd->volumeid = pl_serial_get_str (rd);
+  titles        = pl_serial_get_u32 (rd);
+
+  nb = pl_serial_get_u32 (rd);
+  for (i = 0; i < nb && !rd->err; i++)
+  {
+    mrl_metadata_dvd_title_t *title = mrl_metadata_dvd_get_title (dvd, i + 1);
+
+    if (!title)
+      return -1;
+
+    title->chapters = pl_serial_get_u32 (rd);
+    title->angles   = pl_serial_get_u32 (rd);
+    title->length   = pl_serial_get_u32 (rd);
+  }
+
+  dvd->titles = (uint8_t) titles;
+  return rd->err ? -1 : 0;
+}
+
+/*
+ * The private part (CD or DVD) follows the streams, according to the
+ * resource of the MRL.
+ */
+void
+pl_serial_put_metadata (serial_buf_t *buf,
+                        mrl_metadata_t *meta, mrl_resource_t res)
+{
+  uint32_t i;
+
+  pl_serial_put_str (buf, meta->title);
+  pl_serial_put_str (buf, meta->artist);
+  pl_serial_put_str (buf, meta->genre);
+  pl_serial_put_str (buf, meta->album);
+  pl_serial_put_str (buf, meta->year);
+  pl_serial_put_str (buf, meta->track);
+  pl_serial_put_str (buf, meta->comment);
+
+  pl_serial_put_u32 (buf, meta->subs_nb);
+  for (i = 0; i < meta->subs_nb; i++)
+  {
+    pl_serial_put_u32 (buf, meta->subs[i].id);
+    pl_serial_put_str (buf, meta->subs[i].name);
+    pl_serial_put_str (buf, meta->subs[i].lang);
+  }
+
+  pl_serial_put_u32 (buf, meta->audio_nb);
+  for (i = 0; i < meta->audio_nb; i++)
+  {
+    pl_serial_put_u32 (buf, meta->audio_streams[i].id);
+    pl_serial_put_str (buf, meta->audio_streams[i].name);
+    pl_serial_put_str (buf, meta->audio_streams[i].lang);
+  }
+
+  switch (res)
+  {
+  case MRL_RESOURCE_CDDA:
+  case MRL_RESOURCE_CDDB:
+    serial_put_cd (buf, meta->priv);
+    break;
+
+  case MRL_RESOURCE_DVD:
+  case MRL_RESOURCE_DVDNAV:
+    serial_put_dvd (buf, meta->priv);
+    break;
+
+  default:
+    break;
+  }
+}
+
+mrl_metadata_t *
+pl_serial_get_metadata (serial_reader_t *rd, mrl_resource_t res)
+{
+  mrl_metadata_t *meta;
+  uint32_t i, nb;
+
+  meta = mrl_metadata_new (res);
+  if (!meta)
+    return NULL;
+
+  meta->title   = pl_serial_get_str (rd);
+  meta->artist  = pl_serial_get_str (rd);
+  meta->genre   = pl_serial_get_str (rd);
+  meta->album   = pl_serial_get_str (rd);
+  meta->year    = pl_serial_get_str (rd);
+  meta->track   = pl_serial_get_str (rd);
+  meta->comment = pl_serial_get_str (rd);
+
+  nb = pl_serial_get_u32 (rd);
+  for (i = 0; i < nb && !rd->err; i++)
+  {
+    uint32_t id = pl_serial_get_u32 (rd);
+    mrl_metadata_sub_t *sub = mrl_metadata_sub_get (meta, id);
+
+    if (!sub)
+      break;
+
+    sub->id = id;
+    PFREE (sub->name);
+    PFREE (sub->lang);
+    sub->name = pl_serial_get_str (rd);
+    sub->lang = pl_serial_get_str (rd);
+  }
+
+  nb = pl_serial_get_u32 (rd);
+  for (i = 0; i < nb && !rd->err; i++)
+  {
+    uint32_t id = pl_serial_get_u32 (rd);
+    mrl_metadata_audio_t *audio = mrl_metadata_audio_get (meta, id);
+
+    if (!audio)
+      break;
+
+    audio->id = id;
+    PFREE (audio->name);
+    PFREE (audio->lang);
+    audio->name = pl_serial_get_str (rd);
+    audio->lang = pl_serial_get_str (rd);
+  }
+
+  switch (res)
+  {
+  case MRL_RESOURCE_CDDA:
+  case MRL_RESOURCE_CDDB:
+    if (!meta->priv || serial_get_cd (rd, meta->priv))
+      goto err;
+    break;
+
+  case MRL_RESOURCE_DVD:
+  case MRL_RESOURCE_DVDNAV:
+    if (!meta->priv || serial_get_dvd (rd, meta->priv))
+      goto err;
+    break;
+
+  default:
+    break;
+  }
+
+  if (!rd->err)
+    return meta;
+
+ err:
+  mrl_metadata_free (meta, res);
+  return NULL;
+}
+
+/*****************************************************************************/
+/*                                  MRLs                                     */
+/*****************************************************************************/
+
+static void
+serial_put_args (serial_buf_t *buf, mrl_resource_t res, void *priv)
+{
+  switch (res)
+  {
+  case MRL_RESOURCE_FIFO:
+  case MRL_RESOURCE_FILE:
+  case MRL_RESOURCE_STDIN:
+  {
+    mrl_resource_local_args_t *args = priv;
+
+    pl_serial_put_str (buf, args->location);
+    pl_serial_put_u32 (buf, args->playlist);
+    break;
+  }
+
+  case MRL_RESOURCE_CDDA:
+  case MRL_RESOURCE_CDDB:
+  {
+    mrl_resource_cd_args_t *args = priv;
+
+    pl_serial_put_str (buf, args->device);
+    pl_serial_put_u32 (buf, args->speed);
+    pl_serial_put_u32 (buf, args->track_start);
+    pl_serial_put_u32 (buf, args->track_end);
+    break;
+  }
+
+  case MRL_RESOURCE_DVD:
+  case MRL_RESOURCE_DVDNAV:
+  case MRL_RESOURCE_VCD:
+  {
+    mrl_resource_videodisc_args_t *args = priv;
+
+    pl_serial_put_str (buf, args->device);
+    pl_serial_put_u32 (buf, args->speed);
+    pl_serial_put_u32 (buf, args->angle);
+    pl_serial_put_u32 (buf, args->title_start);
+    pl_serial_put_u32 (buf, args->title_end);
+    pl_serial_put_u32 (buf, args->chapter_start);
+    pl_serial_put_u32 (buf, args->chapter_end);
+    pl_serial_put_u32 (buf, args->track_start);
+    pl_serial_put_u32 (buf, args->track_end);
+    pl_serial_put_str (buf, args->audio_lang);
+    pl_serial_put_str (buf, args->sub_lang);
+    pl_serial_put_u32 (buf, args->sub_cc);
+    break;
+  }
+
+  case MRL_RESOURCE_DVB:
+  case MRL_RESOURCE_PVR:
+  case MRL_RESOURCE_RADIO:
+  case MRL_RESOURCE_TV:
+  case MRL_RESOURCE_VDR:
+  {
+    mrl_resource_tv_args_t *args = priv;
+
+    pl_serial_put_str (buf, args->device);
+    pl_serial_put_str (buf, args->driver);
+    pl_serial_put_str (buf, args->channel);
+    pl_serial_put_u32 (buf, args->input);
+    pl_serial_put_u32 (buf, args->width);
+    pl_serial_put_u32 (buf, args->height);
+    pl_serial_put_u32 (buf, args->fps);
+    pl_serial_put_str (buf, args->output_format);
+    pl_serial_put_str (buf, args->norm);
+    break;
+  }
+
+  case MRL_RESOURCE_FTP:
+  case MRL_RESOURCE_HTTP:
+  case MRL_RESOURCE_MMS:
+  case MRL_RESOURCE_NETVDR:
+  case MRL_RESOURCE_RTP:
+  case MRL_RESOURCE_RTSP:
+  case MRL_RESOURCE_SMB:
+  case MRL_RESOURCE_TCP:
+  case MRL_RESOURCE_UDP:
+  case MRL_RESOURCE_UNSV:
+  {
+    mrl_resource_network_args_t *args = priv;
+
+    pl_serial_put_str (buf, args->url);
+    pl_serial_put_str (buf, args->username);
+    pl_serial_put_str (buf, args->password);
+    pl_serial_put_str (buf, args->user_agent);
+    break;
+  }
+
+  default:
+    buf->err = 1;
+    break;
+  }
+}
+
+static void *
+serial_get_args (serial_reader_t *rd, mrl_resource_t res)
+{
+  switch (res)
+  {
+  case MRL_RESOURCE_FIFO:
+  case MRL_RESOURCE_FILE:
+  case MRL_RESOURCE_STDIN:
+  {
+    mrl_resource_local_args_t *args;
+
+    args = PCALLOC (mrl_resource_local_args_t, 1);
+    if (!args)
+      return NULL;
+
+    args->location = pl_serial_get_str (rd);
+    args->playlist = pl_serial_get_u32 (rd);
+    return args;
+  }
+
+  case MRL_RESOURCE_CDDA:
+  case MRL_RESOURCE_CDDB:
+  {
+    mrl_resource_cd_args_t *args;
+
+    args = PCALLOC (mrl_resource_cd_args_t, 1);
+    if (!args)
+      return NULL;
+
+    args->device      = pl_serial_get_str (rd);
+    args->speed       = pl_serial_get_u32 (rd);
+    args->track_start = pl_serial_get_u32 (rd);
+    args->track_end   = pl_serial_get_u32 (rd);
+    return args;
+  }
+
+  case MRL_RESOURCE_DVD:
+  case MRL_RESOURCE_DVDNAV:
+  case MRL_RESOURCE_VCD:
+  {
+    mrl_resource_videodisc_args_t *args;
+
+    args = PCALLOC (mrl_resource_videodisc_args_t, 1);
+    if (!args)
+      return NULL;
+
+    args->device        = pl_serial_get_str (rd);
+    args->speed         = pl_serial_get_u32 (rd);
+    args->angle         = pl_serial_get_u32 (rd);
+    args->title_start   = pl_serial_get_u32 (rd);
+    args->title_end     = pl_serial_get_u32 (rd);
+    args->chapter_start = pl_serial_get_u32 (rd);
+    args->chapter_end   = pl_serial_get_u32 (rd);
+    args->track_start   = pl_serial_get_u32 (rd);
+    args->track_end     = pl_serial_get_u32 (rd);
+    args->audio_lang    = pl_serial_get_str (rd);
+    args->sub_lang      = pl_serial_get_str (rd);
+    args->sub_cc        = pl_serial_get_u32 (rd);
+    return args;
+  }
+
+  case MRL_RESOURCE_DVB:
+  case MRL_RESOURCE_PVR:
+  case MRL_RESOURCE_RADIO:
+  case MRL_RESOURCE_TV:
+  case MRL_RESOURCE_VDR:
+  {
+    mrl_resource_tv_args_t *args;
+
+    args = PCALLOC (mrl_resource_tv_args_t, 1);
+    if (!args)
+      return NULL;
+
+    args->device        = pl_serial_get_str (rd);
+    args->driver        = pl_serial_get_str (rd);
+    args->channel       = pl_serial_get_str (rd);
+    args->input         = pl_serial_get_u32 (rd);
+    args->width         = pl_serial_get_u32 (rd);
+    args->height        = pl_serial_get_u32 (rd);
+    args->fps           = pl_serial_get_u32 (rd);
+    args->output_format = pl_serial_get_str (rd);
+    args->norm          = pl_serial_get_str (rd);
+    return args;
+  }
+
+  case MRL_RESOURCE_FTP:
+  case MRL_RESOURCE_HTTP:
+  case MRL_RESOURCE_MMS:
+  case MRL_RESOURCE_NETVDR:
+  case MRL_RESOURCE_RTP:
+  case MRL_RESOURCE_RTSP:
+  case MRL_RESOURCE_SMB:
+  case MRL_RESOURCE_TCP:
+  case MRL_RESOURCE_UDP:
+  case MRL_RESOURCE_UNSV:
+  {
+    mrl_resource_network_args_t *args;
+
+    args = PCALLOC (mrl_resource_network_args_t, 1);
+    if (!args)
+      return NULL;
+
+    args->url        = pl_serial_get_str (rd);
+    args->username   = pl_serial_get_str (rd);
+    args->password   = pl_serial_get_str (rd);
+    args->user_agent = pl_serial_get_str (rd);
+    return args;
+  }
+
+  default:
+    rd->err = 1;
+    return NULL;
+  }
+}
+
+/*
+ * record: resource (u32), type (u32), args, subtitles (u32 + str),
+ *         facets (u32), properties, metadata
+ */
+void
+pl_serial_put_mrl (serial_buf_t *buf, mrl_t *mrl)
+{
+  uint32_t nb = 0, facets = 0;
+
+  pl_serial_put_u32 (buf, mrl->resource);
+  pl_serial_put_u32 (buf, mrl->type);
+  serial_put_args (buf, mrl->resource, mrl->priv);
+
+  if (mrl->subs)
+    while (mrl->subs[nb])
+      nb++;
+  pl_serial_put_u32 (buf, nb);
+  for (nb = 0; mrl->subs && mrl->subs[nb]; nb++)
+    pl_serial_put_str (buf, mrl->subs[nb]);
+
+  /* only the facets completely retrieved */
+  if (mrl->prop && (mrl->facets & IDENTIFY_PROPERTIES))
+    facets |= IDENTIFY_PROPERTIES;
+  if (mrl->meta && (mrl->facets & IDENTIFY_METADATA))
+    facets |= IDENTIFY_METADATA;
+
+  pl_serial_put_u32 (buf, facets);
+  if (facets & IDENTIFY_PROPERTIES)
+    pl_serial_put_properties (buf, mrl->prop);
+  if (facets & IDENTIFY_METADATA)
+    pl_serial_put_metadata (buf, mrl->meta, mrl->resource);
+}
+
+/*
+ * The facets are dropped if they are not in 'facets' (saved by an other
+ * wrapper for example); they will be probed again.
+ */
+mrl_t *
+pl_serial_get_mrl (serial_reader_t *rd, int facets)
+{
+  mrl_t *mrl;
+  uint32_t i, nb, saved;
+
+  mrl = PCALLOC (mrl_t, 1);
+  if (!mrl)
+    return NULL;
+
+  mrl->resource = pl_serial_get_u32 (rd);
+  mrl->type     = pl_serial_get_u32 (rd);
+  mrl->priv     = serial_get_args (rd, mrl->resource);
+  if (!mrl->priv)
+    goto err;
+
+  nb = pl_serial_get_u32 (rd);
+  if (nb && !rd->err)
+  {
+    if (nb > (uint32_t) (rd->end - rd->it) / sizeof (uint32_t))
+      goto err;
+
+    mrl->subs = PCALLOC (char *, nb + 1);
+    if (!mrl->subs)
+      goto err;
+
+    for (i = 0; i < nb && !rd->err; i++)
+      mrl->subs[i] = pl_serial_get_str (rd);
+  }
+
+  saved = pl_serial_get_u32 (rd);
+  if (saved & IDENTIFY_PROPERTIES)
+  {
+    mrl->prop = pl_serial_get_properties (rd);
+    if (!mrl->prop)
+      goto err;
+    mrl->facets |= IDENTIFY_PROPERTIES;
+  }
+
+  if (saved & IDENTIFY_METADATA)
+  {
+    mrl->meta = pl_serial_get_metadata (rd, mrl->resource);
+    if (!mrl->meta)
+      goto err;
+    mrl->facets |= IDENTIFY_METADATA;
+  }
+
+  if (mrl->prop && !(facets & IDENTIFY_PROPERTIES))
+  {
+    mrl_properties_free (mrl->prop);
+    mrl->prop = NULL;
+    mrl->facets &= ~IDENTIFY_PROPERTIES;
+  }
+
+  if (mrl->meta && !(facets & IDENTIFY_METADATA))
+  {
+    mrl_metadata_free (mrl->meta, mrl->resource);
+    mrl->meta = NULL;
+    mrl->facets &= ~IDENTIFY_METADATA;
+  }
+
+  if (!rd->err)
+    return mrl;
+
+ err:
+  mrl_sv_free (mrl);
+  return NULL;
+}
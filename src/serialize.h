@@ -0,0 +1,61 @@
+/*
+ * GeeXboX libplayer: a multimedia A/V abstraction layer API.
+ * Copyright (C) 2010 Mathieu Schroeter <mathieu@schroetersa.ch>
+ *
+ * This file is part of libplayer.
+ *
+ * libplayer is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * libplayer is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with libplayer; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#ifndef SERIALIZE_H
+#define SERIALIZE_H
+
+#include <inttypes.h>
+#include <sys/types.h>
+
+typedef struct serial_buf_s {
+  uint8_t *data;
+  size_t len;
+  size_t alloc;
+  int err;
+} serial_buf_t;
+
+typedef struct serial_reader_s {
+  const uint8_t *it;
+  const uint8_t *end;
+  int err;
+} serial_reader_t;
+
+void pl_serial_put (serial_buf_t *buf, const void *data, size_t len);
+void pl_serial_put_u32 (serial_buf_t *buf, uint32_t val);
+void pl_serial_put_u64 (serial_buf_t *buf, uint64_t val);
+void pl_serial_put_str (serial_buf_t *buf, const char *str);
+
+void pl_serial_get (serial_reader_t *rd, void *data, size_t len);
+uint32_t pl_serial_get_u32 (serial_reader_t *rd);
+uint64_t pl_serial_get_u64 (serial_reader_t *rd);
+char *pl_serial_get_str (serial_reader_t *rd);
+
+void pl_serial_put_properties (serial_buf_t *buf, mrl_properties_t *prop);
+mrl_properties_t *pl_serial_get_properties (serial_reader_t *rd);
+void pl_serial_put_metadata (serial_buf_t *buf,
+                             mrl_metadata_t *meta, mrl_resource_t res);
+mrl_metadata_t *pl_serial_get_metadata (serial_reader_t *rd,
+                                        mrl_resource_t res);
+
+void pl_serial_put_mrl (serial_buf_t *buf, mrl_t *mrl);
+mrl_t *pl_serial_get_mrl (serial_reader_t *rd, int facets);
+
+#endif /* SERIALIZE_H */
@@ -82,7 +82,7 @@ supervisor_mrl_free (pl_unused player_t *player, void *in, pl_unused void *out)
   if (!in)
     return;
 
-  mrl_sv_free (in, 0);
+  mrl_sv_free (in);
 }
 
 static void
@@ -130,6 +130,30 @@ supervisor_mrl_get_size (player_t *player, void *in, void *out)
   *output = mrl_sv_get_size (player, in);
 }
 
+static void
+supervisor_mrl_get_properties_all (player_t *player, void *in, void *out)
+{
+  supervisor_data_mrl_all_t *input = in;
+  int *output = out;
+
+  if (!player || !in || !out)
+    return;
+
+  *output = mrl_sv_get_properties_all (player, input->mrl, input->all);
+}
+
+static void
+supervisor_mrl_get_metadata_all (player_t *player, void *in, void *out)
+{
+  supervisor_data_mrl_all_t *input = in;
+  int *output = out;
+
+  if (!player || !in || !out)
+    return;
+
+  *output = mrl_sv_get_metadata_all (player, input->mrl, input->all);
+}
+
 static void
 supervisor_mrl_get_metadata (player_t *player, void *in, void *out)
 {
@@ -299,6 +323,44 @@ supervisor_mrl_video_snapshot (player_t *player, void *in, pl_unused void *out)
                          input->pos, input->type, input->dst);
 }
 
+static void
+supervisor_mrl_video_snapshot_buffer (player_t *player, void *in, void *out)
+{
+  supervisor_data_snapshot_buffer_t *input = in;
+  int *output = out;
+
+  if (!player || !in || !out)
+    return;
+
+  *output = mrl_sv_video_snapshot_to_buffer (player, input->mrl, input->pos,
+                                             input->type, input->buf);
+}
+
+static void
+supervisor_mrl_video_snapshot_batch (player_t *player,
+                                     void *in, pl_unused void *out)
+{
+  supervisor_data_snapshot_batch_t *input = in;
+
+  if (!player || !in)
+    return;
+
+  mrl_sv_video_snapshot_batch (player, input->mrl, input->pos, input->n,
+                               input->type, input->dst);
+}
+
+static void
+supervisor_mrl_probe_batch (player_t *player, void *in, pl_unused void *out)
+{
+  supervisor_data_probe_t *input = in;
+
+  if (!player || !in)
+    return;
+
+  mrl_sv_probe_batch (player, input->list, input->n,
+                      input->flags, input->cb, input->data);
+}
+
 /************************* Player (Un)Initialization *************************/
 
 static void
@@ -370,6 +432,18 @@ supervisor_player_mrl_append (player_t *player,
   player_sv_mrl_append (player, input->mrl, input->value);
 }
 
+static void
+supervisor_player_mrl_append_bulk (player_t *player,
+                                   void *in, pl_unused void *out)
+{
+  supervisor_data_mrl_bulk_t *input = in;
+
+  if (!player || !in)
+    return;
+
+  player_sv_mrl_append_bulk (player, input->list, input->n, input->value);
+}
+
 static void
 supervisor_player_mrl_remove (player_t *player,
                               pl_unused void *in, pl_unused void *out)
@@ -410,6 +484,52 @@ supervisor_player_mrl_next (player_t *player,
   player_sv_mrl_next (player);
 }
 
+static void
+supervisor_player_mrl_goto (player_t *player, void *in, pl_unused void *out)
+{
+  int *input = in;
+
+  if (!player || !in)
+    return;
+
+  player_sv_mrl_goto (player, *input);
+}
+
+static void
+supervisor_player_playlist_import (player_t *player, void *in, void *out)
+{
+  supervisor_data_playlist_import_t *input = in;
+  int *output = out;
+
+  if (!player || !in || !out)
+    return;
+
+  *output = player_sv_playlist_import (player, input->path, input->value,
+                                       input->cb, input->data);
+}
+
+static void
+supervisor_player_playlist_save (player_t *player, void *in, void *out)
+{
+  int *output = out;
+
+  if (!player || !in || !out)
+    return;
+
+  *output = player_sv_playlist_save (player, in);
+}
+
+static void
+supervisor_player_playlist_load (player_t *player, void *in, void *out)
+{
+  int *output = out;
+
+  if (!player || !in || !out)
+    return;
+
+  *output = player_sv_playlist_load (player, in);
+}
+
 static void
 supervisor_player_mrl_next_play (player_t *player,
                                  pl_unused void *in, pl_unused void *out)
@@ -420,6 +540,16 @@ supervisor_player_mrl_next_play (player_t *player,
   player_sv_mrl_next_play (player);
 }
 
+static void
+supervisor_player_mrl_finished (player_t *player,
+                                pl_unused void *in, pl_unused void *out)
+{
+  if (!player)
+    return;
+
+  player_sv_mrl_finished (player);
+}
+
 /************************ Player tuning & properties *************************/
 
 static void
@@ -543,6 +673,16 @@ supervisor_player_osd_state (player_t *player, void *in, pl_unused void *out)
   player_sv_osd_state (player, *input);
 }
 
+static void
+supervisor_player_probe_cache_stats (player_t *player,
+                                     pl_unused void *in, void *out)
+{
+  if (!player || !out)
+    return;
+
+  player_sv_probe_cache_get_stats (player, out);
+}
+
 /************************ Playback related controls **************************/
 
 static void
@@ -567,6 +707,16 @@ supervisor_player_pb_start (player_t *player,
   player_sv_playback_start (player);
 }
 
+static void
+supervisor_player_pb_prepare (player_t *player,
+                              void *in, pl_unused void *out)
+{
+  if (!player || !in)
+    return;
+
+  player_sv_playback_prepare (player, in);
+}
+
 static void
 supervisor_player_pb_stop (player_t *player,
                            pl_unused void *in, pl_unused void *out)
@@ -1011,6 +1161,8 @@ static void (*g_supervisor_funcs[]) (player_t *player, void *in, void *out) = {
   [SV_FUNC_MRL_GET_AO_CODEC]             = supervisor_mrl_get_ao_codec,
   [SV_FUNC_MRL_GET_VO_CODEC]             = supervisor_mrl_get_vo_codec,
   [SV_FUNC_MRL_GET_SIZE]                 = supervisor_mrl_get_size,
+  [SV_FUNC_MRL_GET_PROPERTIES_ALL]       = supervisor_mrl_get_properties_all,
+  [SV_FUNC_MRL_GET_METADATA_ALL]         = supervisor_mrl_get_metadata_all,
   [SV_FUNC_MRL_GET_METADATA]             = supervisor_mrl_get_metadata,
   [SV_FUNC_MRL_GET_METADATA_CD_TRACK]    = supervisor_mrl_get_metadata_cd_track,
   [SV_FUNC_MRL_GET_METADATA_CD]          = supervisor_mrl_get_metadata_cd,
@@ -1025,6 +1177,9 @@ static void (*g_supervisor_funcs[]) (player_t *player, void *in, void *out) = {
   [SV_FUNC_MRL_ADD_SUBTITLE]             = supervisor_mrl_add_subtitle,
   [SV_FUNC_MRL_NEW]                      = supervisor_mrl_new,
   [SV_FUNC_MRL_VIDEO_SNAPSHOT]           = supervisor_mrl_video_snapshot,
+  [SV_FUNC_MRL_VIDEO_SNAPSHOT_BATCH]     = supervisor_mrl_video_snapshot_batch,
+  [SV_FUNC_MRL_VIDEO_SNAPSHOT_BUFFER]    = supervisor_mrl_video_snapshot_buffer,
+  [SV_FUNC_MRL_PROBE_BATCH]              = supervisor_mrl_probe_batch,
 
   /* Player (Un)Initialization */
   [SV_FUNC_PLAYER_INIT]                  = supervisor_player_init,
@@ -1035,11 +1190,17 @@ static void (*g_supervisor_funcs[]) (player_t *player, void *in, void *out) = {
   [SV_FUNC_PLAYER_MRL_GET_CURRENT]       = supervisor_player_mrl_get_current,
   [SV_FUNC_PLAYER_MRL_SET]               = supervisor_player_mrl_set,
   [SV_FUNC_PLAYER_MRL_APPEND]            = supervisor_player_mrl_append,
+  [SV_FUNC_PLAYER_MRL_APPEND_BULK]       = supervisor_player_mrl_append_bulk,
   [SV_FUNC_PLAYER_MRL_REMOVE]            = supervisor_player_mrl_remove,
   [SV_FUNC_PLAYER_MRL_REMOVE_ALL]        = supervisor_player_mrl_remove_all,
   [SV_FUNC_PLAYER_MRL_PREVIOUS]          = supervisor_player_mrl_previous,
   [SV_FUNC_PLAYER_MRL_NEXT]              = supervisor_player_mrl_next,
+  [SV_FUNC_PLAYER_MRL_GOTO]              = supervisor_player_mrl_goto,
+  [SV_FUNC_PLAYER_PLAYLIST_IMPORT]       = supervisor_player_playlist_import,
+  [SV_FUNC_PLAYER_PLAYLIST_SAVE]         = supervisor_player_playlist_save,
+  [SV_FUNC_PLAYER_PLAYLIST_LOAD]         = supervisor_player_playlist_load,
   [SV_FUNC_PLAYER_MRL_NEXT_PLAY]         = supervisor_player_mrl_next_play,
+  [SV_FUNC_PLAYER_MRL_FINISHED]          = supervisor_player_mrl_finished,
 
   /* Player tuning & properties */
   [SV_FUNC_PLAYER_GET_TIME_POS]          = supervisor_player_get_time_pos,
@@ -1052,10 +1213,12 @@ static void (*g_supervisor_funcs[]) (player_t *player, void *in, void *out) = {
   [SV_FUNC_PLAYER_X_WINDOW_SET_PROPS]    = supervisor_player_x_window_set_props,
   [SV_FUNC_PLAYER_OSD_SHOW_TEXT]         = supervisor_player_osd_show_text,
   [SV_FUNC_PLAYER_OSD_STATE]             = supervisor_player_osd_state,
+  [SV_FUNC_PLAYER_PROBE_CACHE_STATS]     = supervisor_player_probe_cache_stats,
 
   /* Playback related controls */
   [SV_FUNC_PLAYER_PB_GET_STATE]          = supervisor_player_pb_get_state,
   [SV_FUNC_PLAYER_PB_START]              = supervisor_player_pb_start,
+  [SV_FUNC_PLAYER_PB_PREPARE]            = supervisor_player_pb_prepare,
   [SV_FUNC_PLAYER_PB_STOP]               = supervisor_player_pb_stop,
   [SV_FUNC_PLAYER_PB_PAUSE]              = supervisor_player_pb_pause,
   [SV_FUNC_PLAYER_PB_SEEK]               = supervisor_player_pb_seek,
@@ -44,6 +44,8 @@ typedef enum supervisor_ctl {
   SV_FUNC_MRL_GET_AO_CODEC,
   SV_FUNC_MRL_GET_VO_CODEC,
   SV_FUNC_MRL_GET_SIZE,
+  SV_FUNC_MRL_GET_PROPERTIES_ALL,
+  SV_FUNC_MRL_GET_METADATA_ALL,
   SV_FUNC_MRL_GET_METADATA,
   SV_FUNC_MRL_GET_METADATA_CD_TRACK,
   SV_FUNC_MRL_GET_METADATA_CD,
@@ -58,6 +60,9 @@ typedef enum supervisor_ctl {
   SV_FUNC_MRL_ADD_SUBTITLE,
   SV_FUNC_MRL_NEW,
   SV_FUNC_MRL_VIDEO_SNAPSHOT,
+  SV_FUNC_MRL_VIDEO_SNAPSHOT_BATCH,
+  SV_FUNC_MRL_VIDEO_SNAPSHOT_BUFFER,
+  SV_FUNC_MRL_PROBE_BATCH,
 
   /* Player (Un)Initialization */
   SV_FUNC_PLAYER_INIT,
@@ -68,11 +73,17 @@ typedef enum supervisor_ctl {
   SV_FUNC_PLAYER_MRL_GET_CURRENT,
   SV_FUNC_PLAYER_MRL_SET,
   SV_FUNC_PLAYER_MRL_APPEND,
+  SV_FUNC_PLAYER_MRL_APPEND_BULK,
   SV_FUNC_PLAYER_MRL_REMOVE,
   SV_FUNC_PLAYER_MRL_REMOVE_ALL,
   SV_FUNC_PLAYER_MRL_PREVIOUS,
   SV_FUNC_PLAYER_MRL_NEXT,
+  SV_FUNC_PLAYER_MRL_GOTO,
+  SV_FUNC_PLAYER_PLAYLIST_IMPORT,
+  SV_FUNC_PLAYER_PLAYLIST_SAVE,
+  SV_FUNC_PLAYER_PLAYLIST_LOAD,
   SV_FUNC_PLAYER_MRL_NEXT_PLAY,
+  SV_FUNC_PLAYER_MRL_FINISHED,
 
   /* Player tuning & properties */
   SV_FUNC_PLAYER_GET_TIME_POS,
@@ -85,10 +96,12 @@ typedef enum supervisor_ctl {
   SV_FUNC_PLAYER_X_WINDOW_SET_PROPS,
   SV_FUNC_PLAYER_OSD_SHOW_TEXT,
   SV_FUNC_PLAYER_OSD_STATE,
+  SV_FUNC_PLAYER_PROBE_CACHE_STATS,
 
   /* Playback related controls */
   SV_FUNC_PLAYER_PB_GET_STATE,
   SV_FUNC_PLAYER_PB_START,
+  SV_FUNC_PLAYER_PB_PREPARE,
   SV_FUNC_PLAYER_PB_STOP,
   SV_FUNC_PLAYER_PB_PAUSE,
   SV_FUNC_PLAYER_PB_SEEK,
@@ -165,6 +178,24 @@ typedef struct supervisor_data_mrl_s {
   int value;
 } supervisor_data_mrl_t;
 
+typedef struct supervisor_data_mrl_bulk_s {
+  mrl_t **list;
+  int n;
+  int value;
+} supervisor_data_mrl_bulk_t;
+
+typedef struct supervisor_data_playlist_import_s {
+  const char *path;
+  int value;
+  player_playlist_import_cb_t cb;
+  void *data;
+} supervisor_data_playlist_import_t;
+
+typedef struct supervisor_data_mrl_all_s {
+  mrl_t *mrl;
+  void *all;
+} supervisor_data_mrl_all_t;
+
 typedef struct supervisor_data_sub_s {
   mrl_t *mrl;
   char *sub;
@@ -205,6 +236,29 @@ typedef struct supervisor_data_snapshot_s {
   const char *dst;
 } supervisor_data_snapshot_t;
 
+typedef struct supervisor_data_snapshot_buffer_s {
+  mrl_t *mrl;
+  int pos;
+  int type;
+  mrl_snapshot_buffer_t *buf;
+} supervisor_data_snapshot_buffer_t;
+
+typedef struct supervisor_data_snapshot_batch_s {
+  mrl_t *mrl;
+  const int *pos;
+  int n;
+  int type;
+  const char *dst;
+} supervisor_data_snapshot_batch_t;
+
+typedef struct supervisor_data_probe_s {
+  mrl_t **list;
+  int n;
+  int flags;
+  mrl_probe_cb_t cb;
+  void *data;
+} supervisor_data_probe_t;
+
 typedef struct supervisor_data_coord_s {
   int x;
   int y;
@@ -43,7 +43,13 @@ pl_window_init (window_t *vo)
 
   pl_log (vo->player, PLAYER_MSG_VERBOSE, MODULE_NAME, __FUNCTION__);
 
-  return vo->funcs ? vo->funcs->init (vo) : -1;
+  if (!vo->funcs)
+    return -1;
+
+  if (!vo->ready)
+    vo->ready = vo->funcs->init (vo) ? 1 : -1;
+
+  return vo->ready > 0;
 }
 
 void
@@ -54,8 +60,9 @@ pl_window_uninit (window_t *vo)
 
   pl_log (vo->player, PLAYER_MSG_VERBOSE, MODULE_NAME, __FUNCTION__);
 
-  if (vo->funcs)
+  if (vo->funcs && vo->ready > 0)
     vo->funcs->uninit (vo);
+  vo->ready = 0;
 }
 
 void
@@ -66,7 +73,12 @@ pl_window_map (window_t *vo)
 
   pl_log (vo->player, PLAYER_MSG_VERBOSE, MODULE_NAME, __FUNCTION__);
 
-  if (vo->funcs)
+  /* the window is created with the first video if not already done */
+  if (!vo->ready && !pl_window_init (vo))
+    pl_log (vo->player, PLAYER_MSG_WARNING,
+            MODULE_NAME, "initialization for X has failed");
+
+  if (vo->funcs && vo->ready > 0)
     vo->funcs->map (vo);
 }
 
@@ -166,6 +178,8 @@ pl_window_register (player_t *player)
     [PLAYER_VO_DIRECTFB]  = WIN_BACKEND_NULL,
     [PLAYER_VO_VDPAU]     = WIN_BACKEND_XCB,
     [PLAYER_VO_VAAPI]     = WIN_BACKEND_XCB,
+    [PLAYER_VO_V4L2]      = WIN_BACKEND_NULL,
+    [PLAYER_VO_FRAMES]    = WIN_BACKEND_NULL,
   };
   window_t *vo;
   window_funcs_t *funcs = NULL;
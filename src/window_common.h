@@ -143,6 +143,7 @@ struct window_s {
   window_funcs_t  *funcs;
   window_backend_t backend;
   void            *backend_data;
+  int              ready;   /* 1 initialized, -1 failed, 0 not yet */
 };
 
 #endif /* PLAYER_WINDOW_COMMON_H */
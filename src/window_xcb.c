@@ -21,7 +21,9 @@
 
 #define _GNU_SOURCE
 #include <stdlib.h>
+#include <string.h>
 #include <math.h>
+#include <time.h>
 #include <pthread.h>
 
 #ifdef USE_XLIB_HACK
@@ -48,6 +50,12 @@
 
 #define MODULE_NAME "window_xcb"
 
+#define RESIZE_INTERVAL 16666 /* us, at most one configure per frame (60 Hz) */
+
+/* client messages sent to win_wakeup, see x11_display_thread() */
+#define WIN_EVENT_RESIZE 1
+#define WIN_EVENT_QUIT   2
+
 static const uint32_t val_raised[] = { XCB_STACK_MODE_ABOVE };
 
 typedef struct x11_s {
@@ -67,13 +75,49 @@ typedef struct x11_s {
   int16_t  x_vid, y_vid;  /* position of win_video */
   uint16_t w_vid, h_vid;  /* size of win_video */
 
+  /* copy of the video size of the player, see win_video_size_copy() */
+  int   w_src, h_src;
+  float aspect_src;
+
   double pixel_aspect;
   void *data;
+
+  /* geometry of the parent and resizing, see x11_display_thread() */
+  window_t *win;
+  xcb_window_t win_parent; /* winid of the player, or 0 */
+  int resize;              /* a configure is pending */
+
+  struct x11_display_s *display;
+  struct x11_s *next;      /* windows of the same display */
 } x11_t;
 
+/*
+ * The connection, the screen and the VDPAU capabilities are shared by all
+ * the windows of the same X display in the process.
+ */
+typedef struct x11_display_s {
+  char *name;              /* x11_display of the players (or $DISPLAY) */
+  xcb_connection_t *conn;
+  xcb_screen_t     *screen;
+  xcb_window_t win_wakeup; /* InputOnly, target of our client messages */
+  int vdpau_caps;          /* -1 until the first probe */
+
+  pthread_t th_event;
+  int       th_event_run;
+
+  x11_t *windows;
+  int refcnt;
+  pthread_mutex_t mutex;   /* windows and vdpau_caps */
+  struct x11_display_s *next;
+} x11_display_t;
+
+/* all displays of the process, shared by the player controllers */
+static x11_display_t *g_displays;
+static pthread_mutex_t g_displays_mutex = PTHREAD_MUTEX_INITIALIZER;
+
 
 static int
-win_vdpau_caps_get (window_t *win)
+x11_vdpau_caps_probe (const char *name)
 {
   int flags = 0;
 #if defined (USE_XLIB_HACK) && defined (USE_VDPAU)
@@ -110,10 +154,7 @@ win_vdpau_caps_get (window_t *win)
     { WIN_VDPAU_DIVX5,   VDP_DECODER_PROFILE_DIVX5_HD_1080P      },
   };
 
-  if (!win)
-    return 0;
-
-  display = XOpenDisplay (win->player->x11_display);
+  display = XOpenDisplay (name);
   if (!display)
     return 0;
 
@@ -144,11 +185,36 @@ win_vdpau_caps_get (window_t *win)
  out:
   XCloseDisplay (display);
 #else /* USE_XLIB_HACK && USE_VDPAU */
-  (void) win;
+  (void) name;
 #endif /* !(USE_XLIB_HACK && USE_VDPAU) */
   return flags;
 }
 
+/* the capabilities are probed only once by display */
+static int
+win_vdpau_caps_get (window_t *win)
+{
+  x11_t *x11;
+  x11_display_t *d;
+  int caps;
+
+  if (!win)
+    return 0;
+
+  x11 = win->backend_data;
+  if (!x11 || !x11->display)
+    return x11_vdpau_caps_probe (win->player->x11_display);
+
+  d = x11->display;
+  pthread_mutex_lock (&d->mutex);
+  if (d->vdpau_caps < 0)
+    d->vdpau_caps = x11_vdpau_caps_probe (d->name);
+  caps = d->vdpau_caps;
+  pthread_mutex_unlock (&d->mutex);
+
+  return caps;
+}
+
 /*
  * Center the movie in the parent window and zoom to use the max of surface.
  */
@@ -269,12 +335,14 @@ win_video_pos_get (window_t *win, int *x, int *y)
 #define PL_X11_CHANGES_H 3
 
 static void
-win_resize (window_t *win)
+win_configure (window_t *win)
 {
   x11_t *x11;
   uint32_t changes[] = { 0, 0, 0, 0 }; /* x, y, w, h */
+  uint32_t changes_vid[4];
   int16_t x, y;
   uint16_t width, height;
+  int subwin;
 
   if (!win)
     return;
@@ -283,11 +351,8 @@ win_resize (window_t *win)
   if (!x11 || !x11->conn)
     return;
 
-  pthread_mutex_lock (&x11->mutex);
-  width  = x11->width;
-  height = x11->height;
-
-  if (win->player->winid)
+  /* the geometry of the parent is tracked by x11_display_thread() */
+  if (win->player->winid && !x11->display->th_event_run)
   {
     xcb_get_geometry_cookie_t cookie;
     xcb_get_geometry_reply_t *geom;
@@ -296,15 +361,18 @@ win_resize (window_t *win)
     geom = xcb_get_geometry_reply (x11->conn, cookie, NULL);
     if (geom)
     {
-      width  = geom->width;
-      height = geom->height;
+      pthread_mutex_lock (&x11->mutex);
+      x11->width  = geom->width;
+      x11->height = geom->height;
+      pthread_mutex_unlock (&x11->mutex);
       PFREE (geom);
     }
-
-    x11->width  = width;
-    x11->height = height;
   }
 
+  pthread_mutex_lock (&x11->mutex);
+  width  = x11->width;
+  height = x11->height;
+
   /* window position and size set by the user */
   x = x11->x;
   y = x11->y;
@@ -312,40 +380,24 @@ win_resize (window_t *win)
     width = x11->w;
   if (x11->h)
     height = x11->h;
-  pthread_mutex_unlock (&x11->mutex);
 
-  if (x11->use_subwin && x11->win_black)
+  subwin = x11->use_subwin && x11->win_black;
+  if (subwin)
   {
     /* reconfigure black and trans windows */
     changes[PL_X11_CHANGES_X] = x;
     changes[PL_X11_CHANGES_Y] = y;
     changes[PL_X11_CHANGES_W] = width;
     changes[PL_X11_CHANGES_H] = height;
-    xcb_configure_window (x11->conn, x11->win_black,
-                          XCB_CONFIG_WINDOW_X     |
-                          XCB_CONFIG_WINDOW_Y     |
-                          XCB_CONFIG_WINDOW_WIDTH |
-                          XCB_CONFIG_WINDOW_HEIGHT,
-                          changes);
-    if (x11->win_trans)
-      xcb_configure_window (x11->conn, x11->win_trans,
-                            XCB_CONFIG_WINDOW_WIDTH |
-                            XCB_CONFIG_WINDOW_HEIGHT,
-                            changes + 2);
 
     x11->x_vid = 0;
     x11->y_vid = 0;
-    x11->w_vid = win->player->w;
-    x11->h_vid = win->player->h;
+    x11->w_vid = x11->w_src;
+    x11->h_vid = x11->h_src;
 
     /* fix the size and offset */
-    zoom (win->player, width, height, win->player->aspect,
+    zoom (win->player, width, height, x11->aspect_src,
           &x11->x_vid, &x11->y_vid, &x11->w_vid, &x11->h_vid);
-
-    changes[PL_X11_CHANGES_X] = (uint32_t) x11->x_vid;
-    changes[PL_X11_CHANGES_Y] = (uint32_t) x11->y_vid;
-    changes[PL_X11_CHANGES_W] = x11->w_vid;
-    changes[PL_X11_CHANGES_H] = x11->h_vid;
   }
   else
   {
@@ -353,11 +405,27 @@ win_resize (window_t *win)
     x11->y_vid = y;
     x11->w_vid = width;
     x11->h_vid = height;
+  }
 
-    changes[PL_X11_CHANGES_X] = x;
-    changes[PL_X11_CHANGES_Y] = y;
-    changes[PL_X11_CHANGES_W] = width;
-    changes[PL_X11_CHANGES_H] = height;
+  changes_vid[PL_X11_CHANGES_X] = (uint32_t) x11->x_vid;
+  changes_vid[PL_X11_CHANGES_Y] = (uint32_t) x11->y_vid;
+  changes_vid[PL_X11_CHANGES_W] = x11->w_vid;
+  changes_vid[PL_X11_CHANGES_H] = x11->h_vid;
+  pthread_mutex_unlock (&x11->mutex);
+
+  if (subwin)
+  {
+    xcb_configure_window (x11->conn, x11->win_black,
+                          XCB_CONFIG_WINDOW_X     |
+                          XCB_CONFIG_WINDOW_Y     |
+                          XCB_CONFIG_WINDOW_WIDTH |
+                          XCB_CONFIG_WINDOW_HEIGHT,
+                          changes);
+    if (x11->win_trans)
+      xcb_configure_window (x11->conn, x11->win_trans,
+                            XCB_CONFIG_WINDOW_WIDTH |
+                            XCB_CONFIG_WINDOW_HEIGHT,
+                            changes + 2);
   }
 
   xcb_configure_window (x11->conn, x11->win_video,
@@ -365,13 +433,358 @@ win_resize (window_t *win)
                         XCB_CONFIG_WINDOW_Y     |
                         XCB_CONFIG_WINDOW_WIDTH |
                         XCB_CONFIG_WINDOW_HEIGHT,
-                        changes);
+                        changes_vid);
 
   xcb_flush (x11->conn);
 
   pl_log (win->player, PLAYER_MSG_INFO, MODULE_NAME, "window resized");
 }
 
+static xcb_screen_t *
+screen_of_display (xcb_connection_t *c, int screen)
+{
+  xcb_screen_iterator_t iter;
+  const xcb_setup_t *setup;
+
+  setup = xcb_get_setup (c);
+  if (!setup)
+    return NULL;
+
+  iter = xcb_setup_roots_iterator (setup);
+  for (; iter.rem; --screen, xcb_screen_next (&iter))
+    if (!screen)
+      return iter.data;
+
+  return NULL;
+}
+
+static xcb_connection_t *
+x11_connection (player_t *player, xcb_screen_t **screen)
+{
+  int screen_num = 0;
+  xcb_connection_t *conn;
+
+  *screen = NULL;
+
+  conn = xcb_connect (player->x11_display, &screen_num);
+  if (xcb_connection_has_error (conn))
+  {
+    pl_log (player, PLAYER_MSG_WARNING, MODULE_NAME, "Failed to open display");
+    return NULL;
+  }
+
+  *screen = screen_of_display (conn, screen_num);
+  if (!*screen)
+  {
+    pl_log (player, PLAYER_MSG_WARNING,
+            MODULE_NAME, "Failed to found the screen");
+    xcb_disconnect (conn);
+    return NULL;
+  }
+
+  return conn;
+}
+
+/* wake up x11_display_thread(), the message is sent to ourself */
+static void
+win_event_send (x11_display_t *d, uint32_t msg, xcb_window_t win)
+{
+  xcb_client_message_event_t ev;
+
+  memset (&ev, 0, sizeof (ev));
+  ev.response_type  = XCB_CLIENT_MESSAGE;
+  ev.format         = 32;
+  ev.window         = d->win_wakeup;
+  ev.type           = XCB_ATOM_NONE;
+  ev.data.data32[0] = msg;
+  ev.data.data32[1] = win;
+
+  xcb_send_event (d->conn, 0, d->win_wakeup,
+                  XCB_EVENT_MASK_NO_EVENT, (const char *) &ev);
+  xcb_flush (d->conn);
+}
+
+/*
+ * The windows concerned by the event are marked for a configure. Return 1
+ * if a configure is pending, -1 to stop the thread, 0 to ignore the event.
+ * The windows list must be locked.
+ */
+static int
+win_event_handle (x11_display_t *d, xcb_generic_event_t *ev)
+{
+  x11_t *x11;
+  int res = 0;
+
+  switch (ev->response_type & ~0x80)
+  {
+  case XCB_CONFIGURE_NOTIFY:
+  {
+    xcb_configure_notify_event_t *cn = (xcb_configure_notify_event_t *) ev;
+
+    for (x11 = d->windows; x11; x11 = x11->next)
+    {
+      if (cn->window != x11->win_parent)
+        continue;
+
+      pthread_mutex_lock (&x11->mutex);
+      if (cn->width != x11->width || cn->height != x11->height)
+        x11->resize = 1;
+      x11->width  = cn->width;
+      x11->height = cn->height;
+      pthread_mutex_unlock (&x11->mutex);
+      res |= x11->resize;
+    }
+    break;
+  }
+
+  case XCB_CLIENT_MESSAGE:
+  {
+    xcb_client_message_event_t *cm = (xcb_client_message_event_t *) ev;
+
+    if (cm->window != d->win_wakeup)
+      break;
+
+    if (cm->data.data32[0] == WIN_EVENT_QUIT)
+      return -1;
+
+    for (x11 = d->windows; x11; x11 = x11->next)
+      if (x11->win_video == cm->data.data32[1])
+      {
+        x11->resize = 1;
+        res = 1;
+      }
+    break;
+  }
+
+  default:
+    break;
+  }
+
+  return res;
+}
+
+static uint64_t
+win_time_us (void)
+{
+  struct timespec ts;
+
+  clock_gettime (CLOCK_MONOTONIC, &ts);
+  return (uint64_t) ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+/*
+ * The ConfigureNotify events of the parents and the resizing requested by
+ * win_resize() are received here, for all the windows of the display. A
+ * burst of events is coalesced in only one configure of the windows by
+ * frame interval.
+ */
+static void *
+x11_display_thread (void *arg)
+{
+  x11_display_t *d = arg;
+  xcb_generic_event_t *ev;
+  uint64_t last = 0;
+  x11_t *x11;
+
+  while ((ev = xcb_wait_for_event (d->conn)))
+  {
+    int res;
+    uint64_t now;
+
+    pthread_mutex_lock (&d->mutex);
+    res = win_event_handle (d, ev);
+    pthread_mutex_unlock (&d->mutex);
+    free (ev);
+    if (res < 0)
+      break;
+    if (!res)
+      continue;
+
+    now = win_time_us ();
+    if (now - last < RESIZE_INTERVAL)
+    {
+      struct timespec ts;
+      uint64_t wait = RESIZE_INTERVAL - (now - last);
+
+      ts.tv_sec  = wait / 1000000;
+      ts.tv_nsec = (wait % 1000000) * 1000;
+      nanosleep (&ts, NULL);
+    }
+
+    pthread_mutex_lock (&d->mutex);
+
+    /* all the events received in the meantime are merged */
+    while ((ev = xcb_poll_for_event (d->conn)))
+    {
+      res = win_event_handle (d, ev);
+      free (ev);
+      if (res < 0)
+      {
+        pthread_mutex_unlock (&d->mutex);
+        return NULL;
+      }
+    }
+
+    for (x11 = d->windows; x11; x11 = x11->next)
+      if (x11->resize)
+      {
+        x11->resize = 0;
+        win_configure (x11->win);
+      }
+
+    pthread_mutex_unlock (&d->mutex);
+    last = win_time_us ();
+  }
+
+  return NULL;
+}
+
+static x11_display_t *
+x11_display_get (player_t *player)
+{
+  x11_display_t *d;
+  const char *name;
+  uint32_t attribute[] = { 1 }; /* override_redirect */
+
+  name = player->x11_display ? player->x11_display : getenv ("DISPLAY");
+
+  pthread_mutex_lock (&g_displays_mutex);
+
+  for (d = g_displays; d; d = d->next)
+    if ((!d->name && !name) || (d->name && name && !strcmp (d->name, name)))
+    {
+      d->refcnt++;
+      pthread_mutex_unlock (&g_displays_mutex);
+      return d;
+    }
+
+  d = PCALLOC (x11_display_t, 1);
+  if (!d)
+    goto err;
+
+  d->conn = x11_connection (player, &d->screen);
+  if (!d->conn)
+  {
+    PFREE (d);
+    goto err;
+  }
+
+  d->name       = name ? strdup (name) : NULL;
+  d->vdpau_caps = -1;
+  pthread_mutex_init (&d->mutex, NULL);
+
+  d->win_wakeup = xcb_generate_id (d->conn);
+  xcb_create_window (d->conn, XCB_COPY_FROM_PARENT, d->win_wakeup,
+                     d->screen->root, 0, 0, 1, 1, 0,
+                     XCB_WINDOW_CLASS_INPUT_ONLY, d->screen->root_visual,
+                     XCB_CW_OVERRIDE_REDIRECT, attribute);
+  xcb_flush (d->conn);
+
+  if (!pthread_create (&d->th_event, NULL, x11_display_thread, d))
+    d->th_event_run = 1;
+  else
+    pl_log (player, PLAYER_MSG_WARNING,
+            MODULE_NAME, "the windows will be resized without event thread");
+
+  d->refcnt = 1;
+  d->next = g_displays;
+  g_displays = d;
+
+  pl_log (player, PLAYER_MSG_INFO, MODULE_NAME,
+          "new connection to the display %s", name ? name : "(default)");
+
+ err:
+  pthread_mutex_unlock (&g_displays_mutex);
+  return d;
+}
+
+static void
+x11_display_release (x11_display_t *d)
+{
+  x11_display_t **it;
+
+  pthread_mutex_lock (&g_displays_mutex);
+
+  if (--d->refcnt > 0)
+  {
+    pthread_mutex_unlock (&g_displays_mutex);
+    return;
+  }
+
+  for (it = &g_displays; *it; it = &(*it)->next)
+    if (*it == d)
+    {
+      *it = d->next;
+      break;
+    }
+
+  pthread_mutex_unlock (&g_displays_mutex);
+
+  if (d->th_event_run)
+  {
+    win_event_send (d, WIN_EVENT_QUIT, XCB_WINDOW_NONE);
+    pthread_join (d->th_event, NULL);
+  }
+
+  xcb_destroy_window (d->conn, d->win_wakeup);
+  xcb_disconnect (d->conn);
+  pthread_mutex_destroy (&d->mutex);
+  PFREE (d->name);
+  PFREE (d);
+}
+
+/* the window is no longer resized by x11_display_thread() */
+static void
+x11_display_detach (x11_t *x11)
+{
+  x11_display_t *d = x11->display;
+  x11_t **it;
+
+  pthread_mutex_lock (&d->mutex);
+  for (it = &d->windows; *it; it = &(*it)->next)
+    if (*it == x11)
+    {
+      *it = x11->next;
+      break;
+    }
+  pthread_mutex_unlock (&d->mutex);
+}
+
+/*
+ * The video size is written by the supervisor (player_video_size()), then
+ * it is copied for win_configure() which can run in x11_display_thread().
+ */
+static void
+win_video_size_copy (window_t *win, x11_t *x11)
+{
+  pthread_mutex_lock (&x11->mutex);
+  x11->w_src      = win->player->w;
+  x11->h_src      = win->player->h;
+  x11->aspect_src = win->player->aspect;
+  pthread_mutex_unlock (&x11->mutex);
+}
+
+static void
+win_resize (window_t *win)
+{
+  x11_t *x11;
+
+  if (!win)
+    return;
+
+  x11 = win->backend_data;
+  if (!x11 || !x11->conn)
+    return;
+
+  win_video_size_copy (win, x11);
+
+  /* no round trip, the configure is done by x11_display_thread() */
+  if (x11->display->th_event_run)
+    win_event_send (x11->display, WIN_EVENT_RESIZE, x11->win_video);
+  else
+    win_configure (win);
+}
+
 static void
 win_map (window_t *win)
 {
@@ -384,7 +797,8 @@ win_map (window_t *win)
   if (!x11 || !x11->conn)
     return;
 
-  win_resize (win);
+  win_video_size_copy (win, x11);
+  win_configure (win);
 
   if (x11->use_subwin && x11->win_black)
   {
@@ -438,6 +852,8 @@ win_uninit (window_t *win)
   if (!x11 || !x11->conn)
     return;
 
+  x11_display_detach (x11);
+
   xcb_unmap_window (x11->conn, x11->win_video);
   xcb_destroy_window (x11->conn, x11->win_video);
 
@@ -459,16 +875,13 @@ win_uninit (window_t *win)
     x11_visual_t *vis = x11->data;
     if (vis->display)
       XCloseDisplay (vis->display);
-#else /* USE_XLIB_HACK */
-    xcb_visual_t *vis = x11->data;
-    if (vis->connection)
-      xcb_disconnect (vis->connection);
-#endif /* !USE_XLIB_HACK */
+#endif /* USE_XLIB_HACK */
 #endif /* HAVE_XINE */
     PFREE (x11->data);
   }
 
-  xcb_disconnect (x11->conn);
+  xcb_flush (x11->conn);
+  x11_display_release (x11->display);
 
   pthread_mutex_destroy (&x11->mutex);
   win->backend_data = NULL;
@@ -538,51 +951,6 @@ xine_frame_output_cb (void *data, int video_width, int video_height,
 }
 #endif /* HAVE_XINE */
 
-static xcb_screen_t *
-screen_of_display (xcb_connection_t *c, int screen)
-{
-  xcb_screen_iterator_t iter;
-  const xcb_setup_t *setup;
-
-  setup = xcb_get_setup (c);
-  if (!setup)
-    return NULL;
-
-  iter = xcb_setup_roots_iterator (setup);
-  for (; iter.rem; --screen, xcb_screen_next (&iter))
-    if (!screen)
-      return iter.data;
-
-  return NULL;
-}
-
-static xcb_connection_t *
-x11_connection (player_t *player, xcb_screen_t **screen)
-{
-  int screen_num = 0;
-  xcb_connection_t *conn;
-
-  *screen = NULL;
-
-  conn = xcb_connect (player->x11_display, &screen_num);
-  if (xcb_connection_has_error (conn))
-  {
-    pl_log (player, PLAYER_MSG_WARNING, MODULE_NAME, "Failed to open display");
-    return NULL;
-  }
-
-  *screen = screen_of_display (conn, screen_num);
-  if (!*screen)
-  {
-    pl_log (player, PLAYER_MSG_WARNING,
-            MODULE_NAME, "Failed to found the screen");
-    xcb_disconnect (conn);
-    return NULL;
-  }
-
-  return conn;
-}
-
 /*
  * This X11 initialization seems to not work very well with Compiz Window
  * Manager and maybe all related managers. The main problem seems to be
@@ -616,10 +984,13 @@ win_init (window_t *win)
   if (!x11)
     return 0;
 
-  x11->conn = x11_connection (win->player, &x11->screen);
-  if (!x11->conn)
+  x11->display = x11_display_get (win->player);
+  if (!x11->display)
     goto err;
 
+  x11->conn   = x11->display->conn;
+  x11->screen = x11->display->screen;
+
   if (win->player->type == PLAYER_TYPE_MPLAYER)
     x11->use_subwin = 1;
   else if (win->player->type == PLAYER_TYPE_XINE)
@@ -633,9 +1004,9 @@ win_init (window_t *win)
     XSetEventQueueOwner (xine_conn, XlibOwnsEventQueue);
     xine_screen = XDefaultScreen (xine_conn);
 #else /* USE_XLIB_HACK */
-    xine_conn = x11_connection (win->player, &xine_screen);
-    if (!xine_conn)
-      goto err_conn;
+    /* the connection is thread-safe, xine uses the same */
+    xine_conn   = x11->conn;
+    xine_screen = x11->screen;
 #endif /* !USE_XLIB_HACK */
 #endif /* HAVE_XINE */
   }
@@ -741,8 +1112,24 @@ win_init (window_t *win)
     xcb_request_check (x11->conn, cookie);
   }
 
+  /* the geometry of the parent is given by the ConfigureNotify events */
+  if (win->player->winid)
+  {
+    const uint32_t mask[] = { XCB_EVENT_MASK_STRUCTURE_NOTIFY };
+
+    x11->win_parent = win_root;
+    xcb_change_window_attributes (x11->conn, win_root,
+                                  XCB_CW_EVENT_MASK, mask);
+  }
+
   xcb_flush (x11->conn);
 
+  x11->win = win;
+  pthread_mutex_lock (&x11->display->mutex);
+  x11->next = x11->display->windows;
+  x11->display->windows = x11;
+  pthread_mutex_unlock (&x11->display->mutex);
+
   x11->pixel_aspect = 1.0;
 
   if (win->player->type == PLAYER_TYPE_XINE)
@@ -779,10 +1166,10 @@ win_init (window_t *win)
   pl_log (win->player, PLAYER_MSG_INFO, MODULE_NAME, "window initialized");
   return 1;
 
-#ifdef HAVE_XINE
+#if defined (HAVE_XINE) && defined (USE_XLIB_HACK)
  err_conn:
-#endif /* HAVE_XINE */
-  xcb_disconnect (x11->conn);
+#endif /* HAVE_XINE && USE_XLIB_HACK */
+  x11_display_release (x11->display);
  err:
   PFREE (x11);
   win->backend_data = NULL;
@@ -212,6 +212,8 @@ pl_register_functions_dummy (void)
   funcs->mrl_retrieve_props = dummy_mrl_retrieve_properties;
   funcs->mrl_retrieve_meta  = dummy_mrl_retrieve_metadata;
   funcs->mrl_video_snapshot = NULL;
+  funcs->mrl_video_snapshot_buffer = NULL;
+  funcs->mrl_video_snapshot_batch = NULL;
 
   funcs->get_time_pos       = NULL;
   funcs->get_percent_pos    = NULL;
@@ -226,6 +228,9 @@ pl_register_functions_dummy (void)
   funcs->pb_seek            = dummy_playback_seek;
   funcs->pb_seek_chapter    = NULL;
   funcs->pb_set_speed       = NULL;
+  funcs->pb_preload         = NULL;
+  funcs->pb_gapless         = NULL;
+  funcs->pb_prepare         = NULL;
 
   funcs->audio_get_volume   = dummy_audio_get_volume;
   funcs->audio_set_volume   = dummy_audio_set_volume;
@@ -29,6 +29,7 @@
 #include <sys/stat.h>
 #include <unistd.h>
 #include <math.h>
+#include <pthread.h>
 
 #include <gst/gst.h>
 #include <gst/interfaces/streamvolume.h>
@@ -44,6 +45,8 @@
 #include "event.h"
 #include "fs_utils.h"
 #include "window.h"
+#include "frame_ring.h"
+#include "audio_tap.h"
 #include "wrapper_gstreamer.h"
 
 #define MODULE_NAME "gstreamer"
@@ -51,6 +54,26 @@
 #define NS_TO_MS(ns) (ns / 1000000)
 #define MS_TO_NS(ms) (ms * 1000000)
 
+#define PREROLL_TIMEOUT (5 * GST_SECOND)
+
+#define SNAPSHOT_POOL   2         /* prerolled pipelines for the snapshots */
+#define PLAY_FLAG_VIDEO (1 << 0)  /* GstPlayFlags of the playbin2 */
+#define PLAY_FLAG_TEXT  (1 << 2)
+#define PROBE_POOL      2         /* pipelines for the identification */
+
+typedef struct gstreamer_snapshot_s {
+  GstElement *bin;
+  GstElement *sink;     /* appsink, RGB 24 bits */
+  char *uri;            /* prerolled URI */
+  unsigned int stamp;   /* last use */
+} gstreamer_snapshot_t;
+
+typedef struct gstreamer_probe_s {
+  GstElement *bin;      /* playbin2 with fake sinks */
+  GstBus *bus;
+  int busy;
+} gstreamer_probe_t;
+
 /* player specific structure */
 typedef struct gstreamer_player_s {
   GstBus *bus;
@@ -58,6 +81,24 @@ typedef struct gstreamer_player_s {
   GstElement *video_sink;
   GstElement *audio_sink;
   GstElement *volume_ctrl;
+  mrl_t *live_mrl;  /* MRL set in the playbin */
+
+  /* gapless playback, see gstreamer_about_to_finish() */
+  pthread_mutex_t mutex_gapless;
+  mrl_t *gapless_mrl;   /* next MRL given by the preload */
+  char  *gapless_uri;
+  int    gapless_done;  /* the uri is set in the playbin */
+  int    gapless_switched; /* the playbin plays gapless_mrl */
+
+  mrl_t *prepared_mrl;  /* MRL prerolled by pb_prepare() */
+
+  /* snapshots, see gstreamer_snapshot_get() */
+  gstreamer_snapshot_t snapshot[SNAPSHOT_POOL];
+  unsigned int snapshot_stamp;
+
+  /* identification, see gstreamer_probe_get() */
+  pthread_mutex_t mutex_probe;
+  gstreamer_probe_t probe[PROBE_POOL];
 } gstreamer_player_t;
 
 typedef struct gstreamer_identifier_s {
@@ -99,6 +140,17 @@ get_uri (mrl_t *m)
   return NULL;
 }
 
+static void
+gstreamer_gapless_reset (gstreamer_player_t *g)
+{
+  pthread_mutex_lock (&g->mutex_gapless);
+  PFREE (g->gapless_uri);
+  g->gapless_mrl      = NULL;
+  g->gapless_done     = 0;
+  g->gapless_switched = 0;
+  pthread_mutex_unlock (&g->mutex_gapless);
+}
+
 static void
 gstreamer_set_eof (player_t *player)
 {
@@ -111,11 +163,59 @@ gstreamer_set_eof (player_t *player)
 
   /* properly shutdown playback engine */
   gst_element_set_state (g->bin, GST_STATE_NULL);
+  gstreamer_gapless_reset (g);
 
   /* tell player */
   player_event_send (player, PLAYER_EVENT_PLAYBACK_FINISHED);
 }
 
+/*
+ * Emitted by the streaming thread when the playbin needs the next uri.
+ * The preloaded uri is given here, then the playbin continues without
+ * EOS and posts "playbin2-stream-changed" when the new stream is playing.
+ */
+static void
+gstreamer_about_to_finish (GstElement *bin, gpointer data)
+{
+  player_t *player = data;
+  gstreamer_player_t *g = player->priv;
+
+  pthread_mutex_lock (&g->mutex_gapless);
+  if (g->gapless_uri && !g->gapless_done)
+  {
+    pl_log (player, PLAYER_MSG_INFO,
+            MODULE_NAME, "preload uri: %s", g->gapless_uri);
+    g_object_set (G_OBJECT (bin), "uri", g->gapless_uri, NULL);
+    g->gapless_done = 1;
+  }
+  pthread_mutex_unlock (&g->mutex_gapless);
+}
+
+static void
+gstreamer_stream_changed (player_t *player)
+{
+  gstreamer_player_t *g = player->priv;
+  int switched = 0;
+
+  pthread_mutex_lock (&g->mutex_gapless);
+  if (g->gapless_done && !g->gapless_switched)
+  {
+    g->live_mrl = g->gapless_mrl;
+    g->gapless_switched = 1;
+    switched = 1;
+  }
+  pthread_mutex_unlock (&g->mutex_gapless);
+
+  if (!switched)
+    return;
+
+  pl_log (player, PLAYER_MSG_INFO,
+          MODULE_NAME, "Playback of stream has ended");
+
+  /* the playbin continues with the preloaded MRL */
+  player_event_send (player, PLAYER_EVENT_PLAYBACK_FINISHED);
+}
+
 static gboolean
 bus_callback (pl_unused GstBus *bus, GstMessage *msg, gpointer data)
 {
@@ -148,6 +248,14 @@ bus_callback (pl_unused GstBus *bus, GstMessage *msg, gpointer data)
     gstreamer_set_eof (player);
     break;
   }
+  case GST_MESSAGE_ELEMENT:
+  {
+    const GstStructure *st = gst_message_get_structure (msg);
+
+    if (st && gst_structure_has_name (st, "playbin2-stream-changed"))
+      gstreamer_stream_changed (player);
+    break;
+  }
   case GST_MESSAGE_STATE_CHANGED:
   {
     GstState old_state, new_state;
@@ -177,13 +285,96 @@ bus_callback (pl_unused GstBus *bus, GstMessage *msg, gpointer data)
 
 #define VIDEO_SINK_NAME "video-sink"
 
+static void
+gstreamer_frame_release (void *priv)
+{
+  gst_buffer_unref (GST_BUFFER (priv));
+}
+
+/*
+ * The decoded buffers are not copied, the ring keeps a reference on each
+ * buffer until the frontend callback has returned.
+ */
+static GstFlowReturn
+gstreamer_frame_cb (GstElement *sink, gpointer data)
+{
+  player_t *player = data;
+  player_frame_t frame;
+  GstBuffer *buf = NULL;
+  GstStructure *st;
+  int width = 0, height = 0, lines;
+  guint size;
+
+  g_signal_emit_by_name (sink, "pull-buffer", &buf);
+  if (!buf)
+    return GST_FLOW_OK;
+
+  if (GST_BUFFER_CAPS (buf))
+  {
+    st = gst_caps_get_structure (GST_BUFFER_CAPS (buf), 0);
+    gst_structure_get_int (st, "width", &width);
+    gst_structure_get_int (st, "height", &height);
+  }
+
+  /* I420 layout of GStreamer (rows aligned on 4 bytes) */
+  memset (&frame, 0, sizeof (frame));
+  lines = GST_ROUND_UP_2 (height);
+  frame.format    = PLAYER_FRAME_I420;
+  frame.width     = width;
+  frame.height    = height;
+  frame.stride[0] = GST_ROUND_UP_4 (width);
+  frame.stride[1] = GST_ROUND_UP_4 (GST_ROUND_UP_2 (width) / 2);
+  frame.stride[2] = frame.stride[1];
+  frame.plane[0]  = GST_BUFFER_DATA (buf);
+  frame.plane[1]  = frame.plane[0] + frame.stride[0] * lines;
+  frame.plane[2]  = frame.plane[1] + frame.stride[1] * lines / 2;
+  size = frame.stride[0] * lines + frame.stride[1] * lines;
+
+  if (width <= 0 || height <= 0 || GST_BUFFER_SIZE (buf) < size)
+  {
+    gst_buffer_unref (buf);
+    return GST_FLOW_OK;
+  }
+
+  frame.pts = GST_BUFFER_TIMESTAMP_IS_VALID (buf)
+              ? (int64_t) NS_TO_MS (GST_BUFFER_TIMESTAMP (buf)) : -1;
+
+  pl_frame_ring_push (player->frames, &frame, gstreamer_frame_release, buf);
+  return GST_FLOW_OK;
+}
+
+static GstElement *
+gstreamer_frames_sink (player_t *player)
+{
+  GstElement *sink;
+  GstCaps *caps;
+
+  sink = gst_element_factory_make ("appsink", VIDEO_SINK_NAME);
+  if (!sink)
+    return NULL;
+
+  /* the colorspace is converted by the playbin */
+  caps = gst_caps_new_simple ("video/x-raw-yuv",
+                              "format", GST_TYPE_FOURCC,
+                              GST_MAKE_FOURCC ('I', '4', '2', '0'), NULL);
+
+  /* the streaming thread is never blocked by the appsink */
+  g_object_set (G_OBJECT (sink), "caps", caps,
+                                 "sync", TRUE,
+                                 "emit-signals", TRUE,
+                                 "max-buffers", 1,
+                                 "drop", TRUE, NULL);
+  gst_caps_unref (caps);
+
+  g_signal_connect (sink, "new-buffer",
+                    G_CALLBACK (gstreamer_frame_cb), player);
+  return sink;
+}
+
 static GstElement *
 gstreamer_set_video_sink (player_t *player)
 {
   GstElement *sink = NULL;
-#ifdef HAVE_WIN_XCB
-  int ret;
-#endif /* HAVE_WIN_XCB */
 
   if (!player)
     return NULL;
@@ -215,21 +406,14 @@ gstreamer_set_video_sink (player_t *player)
   case PLAYER_VO_V4L2:
     sink = gst_element_factory_make ("v4l2sink", VIDEO_SINK_NAME);
     break;
+  case PLAYER_VO_FRAMES:
+    sink = gstreamer_frames_sink (player);
+    break;
   default:
     break;
   }
 
-#ifdef HAVE_WIN_XCB
-  ret = pl_window_init (player->window);
-  if (player->vo != PLAYER_VO_AUTO && !ret)
-  {
-    gst_object_unref (GST_OBJECT (sink));
-    pl_log (player, PLAYER_MSG_ERROR,
-            MODULE_NAME, "X initialization has failed");
-    return NULL;
-  }
-#endif /* HAVE_WIN_XCB */
-
+  /* the window is created by pl_window_map() with the first video */
   return sink;
 }
 
@@ -269,6 +453,101 @@ gstreamer_set_audio_sink (player_t *player)
   return sink;
 }
 
+static GstFlowReturn
+gstreamer_audio_cb (GstElement *sink, gpointer data)
+{
+  player_t *player = data;
+  GstBuffer *buf = NULL;
+  GstStructure *st;
+  int channels = 0, rate = 0;
+
+  g_signal_emit_by_name (sink, "pull-buffer", &buf);
+  if (!buf)
+    return GST_FLOW_OK;
+
+  if (GST_BUFFER_CAPS (buf))
+  {
+    st = gst_caps_get_structure (GST_BUFFER_CAPS (buf), 0);
+    gst_structure_get_int (st, "channels", &channels);
+    gst_structure_get_int (st, "rate", &rate);
+  }
+
+  if (channels > 0)
+    pl_audio_tap_push (player->audio_tap,
+                       (const int16_t *) GST_BUFFER_DATA (buf),
+                       GST_BUFFER_SIZE (buf) / (channels * 2), channels, rate,
+                       GST_BUFFER_TIMESTAMP_IS_VALID (buf)
+                       ? (int64_t) NS_TO_MS (GST_BUFFER_TIMESTAMP (buf)) : -1);
+
+  gst_buffer_unref (buf);
+  return GST_FLOW_OK;
+}
+
+/*
+ * The audio is split by a tee between the audio sink and an appsink (signed
+ * 16 bits). The queue of the tap is leaky, then the audio output is never
+ * blocked by the callback.
+ */
+static GstElement *
+gstreamer_audio_tap (player_t *player, GstElement *sink)
+{
+  GstElement *bin, *tee, *q_out, *q_tap, *conv, *app;
+  GstCaps *caps;
+  GstPad *pad;
+
+  bin   = gst_bin_new ("audio-tap");
+  tee   = gst_element_factory_make ("tee", NULL);
+  q_out = gst_element_factory_make ("queue", NULL);
+  q_tap = gst_element_factory_make ("queue", NULL);
+  conv  = gst_element_factory_make ("audioconvert", NULL);
+  app   = gst_element_factory_make ("appsink", NULL);
+
+  if (!bin || !tee || !q_out || !q_tap || !conv || !app)
+  {
+    GstElement *e[] = { bin, tee, q_out, q_tap, conv, app };
+    unsigned int i;
+
+    for (i = 0; i < ARRAY_NB_ELEMENTS (e); i++)
+      if (e[i])
+        gst_object_unref (GST_OBJECT (e[i]));
+    return NULL;
+  }
+
+  caps = gst_caps_new_simple ("audio/x-raw-int",
+                              "width",      G_TYPE_INT,     16,
+                              "depth",      G_TYPE_INT,     16,
+                              "signed",     G_TYPE_BOOLEAN, TRUE,
+                              "endianness", G_TYPE_INT,     G_BYTE_ORDER,
+                              NULL);
+  g_object_set (G_OBJECT (app), "caps", caps,
+                                "sync", TRUE,
+                                "emit-signals", TRUE, NULL);
+  gst_caps_unref (caps);
+
+  g_object_set (G_OBJECT (q_tap), "leaky", 2 /* downstream */, NULL);
+
+  g_signal_connect (app, "new-buffer",
+                    G_CALLBACK (gstreamer_audio_cb), player);
+
+  /* the sink must survive to the bin if the links are not possible */
+  gst_object_ref (sink);
+  gst_bin_add_many (GST_BIN (bin), tee, q_out, sink, q_tap, conv, app, NULL);
+
+  if (!gst_element_link_many (tee, q_out, sink, NULL)
+      || !gst_element_link_many (tee, q_tap, conv, app, NULL))
+  {
+    gst_object_unref (GST_OBJECT (bin));
+    return NULL;
+  }
+  gst_object_unref (sink);
+
+  pad = gst_element_get_static_pad (tee, "sink");
+  gst_element_add_pad (bin, gst_ghost_pad_new ("sink", pad));
+  gst_object_unref (GST_OBJECT (pad));
+
+  return bin;
+}
+
 #ifdef HAVE_WIN_XCB
 static GstBusSyncReply
 bus_sync_handler_cb (pl_unused GstBus *bus, GstMessage *message, gpointer data)
@@ -549,90 +828,384 @@ identify_bus_callback (pl_unused GstBus *bus, GstMessage *msg, gpointer data)
   return TRUE;
 }
 
+static void
+identify_get_size (mrl_t *mrl)
+{
+  mrl_resource_local_args_t *args;
+  const char *location;
+
+  if (!mrl->prop || mrl->resource != MRL_RESOURCE_FILE)
+    return;
+
+  args = mrl->priv;
+  if (!args || !args->location)
+    return;
+
+  location = args->location;
+  if (strstr (location, "file://") == location)
+    location += 7;
+
+  mrl->prop->size = pl_file_size (location);
+}
+
+static int
+gstreamer_probe_new (gstreamer_probe_t *p)
+{
+  GstElement *vs, *as;
+
+  p->bin = gst_element_factory_make ("playbin2", NULL);
+  vs     = gst_element_factory_make ("fakesink", VIDEO_SINK_NAME);
+  as     = gst_element_factory_make ("fakesink", AUDIO_SINK_NAME);
+
+  if (!p->bin || !vs || !as)
+  {
+    if (p->bin)
+      gst_object_unref (GST_OBJECT (p->bin));
+    if (vs)
+      gst_object_unref (GST_OBJECT (vs));
+    if (as)
+      gst_object_unref (GST_OBJECT (as));
+    p->bin = NULL;
+    return -1;
+  }
+
+  g_object_set (vs, "sync", TRUE, NULL);
+  g_object_set (G_OBJECT (p->bin), "video-sink", vs,
+                                   "audio-sink", as, NULL);
+
+  p->bus  = gst_pipeline_get_bus (GST_PIPELINE (p->bin));
+  p->busy = 0;
+  return 0;
+}
+
+static void
+gstreamer_probe_free (gstreamer_probe_t *p)
+{
+  if (!p->bin)
+    return;
+
+  gst_element_set_state (p->bin, GST_STATE_NULL);
+  gst_object_unref (GST_OBJECT (p->bus));
+  gst_object_unref (GST_OBJECT (p->bin));
+  p->bin = NULL;
+  p->bus = NULL;
+}
+
+/*
+ * The pipelines are created with the player and they are only reset to
+ * the NULL state between two MRLs. NULL is returned when all the pipelines
+ * of the pool are busy.
+ */
+static gstreamer_probe_t *
+gstreamer_probe_get (gstreamer_player_t *g)
+{
+  gstreamer_probe_t *p = NULL;
+  int i;
+
+  pthread_mutex_lock (&g->mutex_probe);
+  for (i = 0; i < PROBE_POOL; i++)
+    if (g->probe[i].bin && !g->probe[i].busy)
+    {
+      p = &g->probe[i];
+      p->busy = 1;
+      break;
+    }
+  pthread_mutex_unlock (&g->mutex_probe);
+
+  return p;
+}
+
+static void
+gstreamer_probe_release (gstreamer_player_t *g, gstreamer_probe_t *p)
+{
+  gst_element_set_state (p->bin, GST_STATE_NULL);
+
+  /* drop the messages not popped for this MRL */
+  gst_bus_set_flushing (p->bus, TRUE);
+  gst_bus_set_flushing (p->bus, FALSE);
+
+  pthread_mutex_lock (&g->mutex_probe);
+  p->busy = 0;
+  pthread_mutex_unlock (&g->mutex_probe);
+}
+
 static void
 gstreamer_identify (player_t *player, mrl_t *mrl, int flags)
 {
-  GstBus *bus;
-  GstElement *bin, *vs, *as;
-  gstreamer_identifier_t *id;
+  gstreamer_player_t *g = player->priv;
+  gstreamer_probe_t tmp, *p;
+  gstreamer_identifier_t id;
   char *uri;
 
-  /*
-   * TODO can we avoid constructing a pipeline twice and simply get all props
-   * and metadata in one shot?
-   */
+  identify_get_size (mrl);
 
-  if (mrl->prop)
+  uri = get_uri (mrl);
+  if (!uri)
+  {
+    pl_log (player, PLAYER_MSG_WARNING, MODULE_NAME,
+            "unrecognized resource type: %d", mrl->resource);
+    return;
+  }
+
+  /* a temporary pipeline is used when the pool is exhausted */
+  p = gstreamer_probe_get (g);
+  if (!p)
   {
-    if (mrl->resource == MRL_RESOURCE_FILE)
+    p = &tmp;
+    if (gstreamer_probe_new (p))
     {
-      mrl_resource_local_args_t *args = mrl->priv;
-      if (args && args->location)
-      {
-        const char *location = args->location;
+      pl_log (player, PLAYER_MSG_ERROR,
+              MODULE_NAME, "unable to create the identification pipeline");
+      PFREE (uri);
+      return;
+    }
+  }
 
-        if (strstr (location, "file://") == location)
-          location += 7;
+  /* map the identification struct */
+  id.player      = player;
+  id.mrl         = mrl;
+  id.bin         = p->bin;
+  id.flags       = flags;
+  id.audio_codec = NULL;
+  id.video_codec = NULL;
 
-        mrl->prop->size = pl_file_size (location);
-      }
+  pl_log (player, PLAYER_MSG_VERBOSE, MODULE_NAME, "identify: %s", uri);
+
+  g_object_set (p->bin, "uri", uri, NULL);
+
+  /* put GStreamer engine in paused mode */
+  gst_element_set_state (p->bin, GST_STATE_PAUSED);
+
+  /* wait for stream parsing event */
+  while (1)
+  {
+    GstMessage *msg;
+    gboolean res;
+
+    msg = gst_bus_timed_pop_filtered (p->bus, PREROLL_TIMEOUT,
+                                      GST_MESSAGE_ASYNC_DONE |
+                                      GST_MESSAGE_TAG | GST_MESSAGE_ERROR);
+    if (!msg)
+    {
+      pl_log (player, PLAYER_MSG_WARNING,
+              MODULE_NAME, "identification of %s has timed out", uri);
+      break;
     }
+
+    res = identify_bus_callback (p->bus, msg, &id);
+    gst_message_unref (msg);
+    if (!res)
+      break;
   }
 
-  /* create a new pipeline for stream identification */
-  bin = gst_element_factory_make ("playbin2", "identifier");
-  bus = gst_pipeline_get_bus (GST_PIPELINE (bin));
+  if (p == &tmp)
+    gstreamer_probe_free (p);
+  else
+    gstreamer_probe_release (g, p);
 
-  /* create a fake video sink */
-  vs = gst_element_factory_make ("fakesink", VIDEO_SINK_NAME);
-  g_object_set (vs, "sync", TRUE, NULL);
-  g_object_set (G_OBJECT (bin), "video-sink", vs, NULL);
+  PFREE (uri);
+  PFREE (id.audio_codec);
+  PFREE (id.video_codec);
+}
 
-  /* create a fake audio sink */
-  as = gst_element_factory_make ("fakesink", AUDIO_SINK_NAME);
-  g_object_set (G_OBJECT (bin), "audio-sink", as, NULL);
+static int
+gstreamer_snapshot_new (gstreamer_snapshot_t *s)
+{
+  GstElement *as;
+  GstCaps *caps;
 
-  /* map the identification struct */
-  id              = malloc (sizeof (gstreamer_identifier_t));
-  id->player      = player;
-  id->mrl         = mrl;
-  id->bin         = bin;
-  id->flags       = flags;
-  id->audio_codec = NULL;
-  id->video_codec = NULL;
+  s->bin  = gst_element_factory_make ("playbin2", NULL);
+  s->sink = gst_element_factory_make ("appsink", NULL);
+  as      = gst_element_factory_make ("fakesink", NULL);
 
-  uri = get_uri (mrl);
-  if (uri)
+  if (!s->bin || !s->sink || !as)
   {
-    pl_log (player, PLAYER_MSG_VERBOSE, MODULE_NAME, "identify: %s", uri);
+    if (s->bin)
+      gst_object_unref (GST_OBJECT (s->bin));
+    if (s->sink)
+      gst_object_unref (GST_OBJECT (s->sink));
+    if (as)
+      gst_object_unref (GST_OBJECT (as));
+    s->bin  = NULL;
+    s->sink = NULL;
+    return -1;
+  }
 
-    g_object_set (bin, "uri", uri, NULL);
+  /* the colorspace is converted by the playbin */
+  caps = gst_caps_new_simple ("video/x-raw-rgb",
+                              "bpp",        G_TYPE_INT, 24,
+                              "depth",      G_TYPE_INT, 24,
+                              "endianness", G_TYPE_INT, G_BIG_ENDIAN,
+                              "red_mask",   G_TYPE_INT, 0xff0000,
+                              "green_mask", G_TYPE_INT, 0x00ff00,
+                              "blue_mask",  G_TYPE_INT, 0x0000ff,
+                              NULL);
+  g_object_set (G_OBJECT (s->sink), "caps", caps, "sync", FALSE, NULL);
+  gst_caps_unref (caps);
+
+  /* only the video is decoded */
+  g_object_set (G_OBJECT (s->bin), "video-sink", s->sink,
+                                   "audio-sink", as,
+                                   "flags", PLAY_FLAG_VIDEO, NULL);
+  return 0;
+}
 
-    /*
-     * Put GStreamer engine in paused mode
-     * Everything will be cleaned up by event loop at message reception
-     */
-    gst_element_set_state (bin, GST_STATE_PAUSED);
+static void
+gstreamer_snapshot_free (gstreamer_snapshot_t *s)
+{
+  if (s->bin)
+  {
+    gst_element_set_state (s->bin, GST_STATE_NULL);
+    gst_object_unref (GST_OBJECT (s->bin));
+  }
 
-    /* wait for stream parsing event */
-    while (1)
-    {
-      GstMessage *msg =
-        gst_bus_timed_pop_filtered (bus, GST_CLOCK_TIME_NONE,
-                                    GST_MESSAGE_ASYNC_DONE |
-                                    GST_MESSAGE_TAG | GST_MESSAGE_ERROR);
+  PFREE (s->uri);
+  s->bin  = NULL;
+  s->sink = NULL;
+}
 
-      if (!identify_bus_callback (bus, msg, id))
-        break;
+/*
+ * The pipelines stay prerolled (paused) between the snapshots. The pipeline
+ * of the same URI is reused, then only a seek is necessary for the next
+ * position, else the least recently used pipeline is prerolled again.
+ */
+static gstreamer_snapshot_t *
+gstreamer_snapshot_get (player_t *player, mrl_t *mrl)
+{
+  gstreamer_player_t *g = player->priv;
+  gstreamer_snapshot_t *s = NULL;
+  GstStateChangeReturn st;
+  char *uri;
+  int i;
+
+  uri = get_uri (mrl);
+  if (!uri)
+    return NULL;
+
+  for (i = 0; i < SNAPSHOT_POOL; i++)
+  {
+    gstreamer_snapshot_t *it = &g->snapshot[i];
+
+    if (it->uri && !strcmp (it->uri, uri))
+    {
+      s = it;
+      break;
     }
+
+    if (!s || it->stamp < s->stamp)
+      s = it;
   }
-  else
+
+  s->stamp = ++g->snapshot_stamp;
+
+  if (s->uri && !strcmp (s->uri, uri))
+  {
+    PFREE (uri);
+    return s;
+  }
+
+  PFREE (s->uri);
+
+  if (!s->bin && gstreamer_snapshot_new (s))
+  {
+    PFREE (uri);
+    return NULL;
+  }
+
+  gst_element_set_state (s->bin, GST_STATE_READY);
+  g_object_set (G_OBJECT (s->bin), "uri", uri, NULL);
+
+  gst_element_set_state (s->bin, GST_STATE_PAUSED);
+  st = gst_element_get_state (s->bin, NULL, NULL, PREROLL_TIMEOUT);
+  if (st != GST_STATE_CHANGE_SUCCESS)
+  {
+    pl_log (player, PLAYER_MSG_WARNING,
+            MODULE_NAME, "unable to preroll %s for the snapshot", uri);
+    gst_element_set_state (s->bin, GST_STATE_READY);
+    PFREE (uri);
+    return NULL;
+  }
+
+  s->uri = uri;
+  return s;
+}
+
+/* RGB 24 bits frame at the position (second) */
+static GstBuffer *
+gstreamer_snapshot_frame (player_t *player, mrl_t *mrl, int pos)
+{
+  gstreamer_snapshot_t *s;
+  GstBuffer *frame = NULL;
+
+  s = gstreamer_snapshot_get (player, mrl);
+  if (!s)
+    return NULL;
+
+  if (gst_element_seek_simple (s->bin, GST_FORMAT_TIME,
+                               GST_SEEK_FLAG_FLUSH | GST_SEEK_FLAG_ACCURATE,
+                               (gint64) pos * GST_SECOND)
+      && gst_element_get_state (s->bin, NULL, NULL, PREROLL_TIMEOUT)
+         == GST_STATE_CHANGE_SUCCESS)
+    g_signal_emit_by_name (s->sink, "pull-preroll", &frame);
+
+  if (!frame)
+  {
     pl_log (player, PLAYER_MSG_WARNING, MODULE_NAME,
-            "unrecognized resource type: %d", mrl->resource);
+            "frame at %is is unavailable, maybe GStreamer can't seek in %s",
+            pos, s->uri);
+    gst_element_set_state (s->bin, GST_STATE_READY);
+    PFREE (s->uri);
+  }
 
-  PFREE (uri);
-  PFREE (id->audio_codec);
-  PFREE (id->video_codec);
+  return frame;
+}
+
+static GstBuffer *
+gstreamer_snapshot_encode (player_t *player,
+                           GstBuffer *frame, const char *encoder)
+{
+  GstElement *pipe, *src, *sink;
+  GstFlowReturn ret;
+  GstBuffer *img = NULL;
+  GError *error = NULL;
+  char desc[128];
+
+  snprintf (desc, sizeof (desc),
+            "appsrc name=src ! ffmpegcolorspace ! %s ! appsink name=sink",
+            encoder);
+
+  pipe = gst_parse_launch (desc, &error);
+  if (error)
+  {
+    pl_log (player, PLAYER_MSG_ERROR,
+            MODULE_NAME, "snapshot encoder: %s", error->message);
+    g_error_free (error);
+  }
+  if (!pipe)
+    return NULL;
+
+  src  = gst_bin_get_by_name (GST_BIN (pipe), "src");
+  sink = gst_bin_get_by_name (GST_BIN (pipe), "sink");
+
+  if (src && sink)
+  {
+    g_object_set (G_OBJECT (src), "caps", GST_BUFFER_CAPS (frame), NULL);
+    gst_element_set_state (pipe, GST_STATE_PLAYING);
+
+    /* the appsrc takes its own reference on the frame */
+    g_signal_emit_by_name (src, "push-buffer", frame, &ret);
+    g_signal_emit_by_name (src, "end-of-stream", &ret);
+    g_signal_emit_by_name (sink, "pull-buffer", &img);
+  }
+
+  gst_element_set_state (pipe, GST_STATE_NULL);
+  if (src)
+    gst_object_unref (GST_OBJECT (src));
+  if (sink)
+    gst_object_unref (GST_OBJECT (sink));
+  gst_object_unref (GST_OBJECT (pipe));
+
+  return img;
 }
 
 #define GST_SIGNAL(msg, cb) \
@@ -643,6 +1216,7 @@ gstreamer_player_init (player_t *player)
 {
   gstreamer_player_t *g = NULL;
   GError *error;
+  int i;
 
   pl_log (player, PLAYER_MSG_INFO, MODULE_NAME, "init");
   pl_log (player, PLAYER_MSG_INFO, MODULE_NAME,
@@ -674,15 +1248,45 @@ gstreamer_player_init (player_t *player)
 
   gst_bus_add_watch (g->bus, bus_callback, player);
 
-  /* set video sink */
-  g->video_sink = gstreamer_set_video_sink (player);
-  if (g->video_sink)
-    g_object_set (G_OBJECT (g->bin), "video-sink", g->video_sink, NULL);
+  if (player->gapless)
+    GST_SIGNAL ("about-to-finish", gstreamer_about_to_finish);
+
+  /* set video sink, or never decode the video */
+  if (player->audio_only)
+  {
+    gint flags;
+
+    g_object_get (G_OBJECT (g->bin), "flags", &flags, NULL);
+    flags &= ~(PLAY_FLAG_VIDEO | PLAY_FLAG_TEXT);
+    g_object_set (G_OBJECT (g->bin), "flags", flags, NULL);
+  }
+  else
+  {
+    g->video_sink = gstreamer_set_video_sink (player);
+    if (g->video_sink)
+      g_object_set (G_OBJECT (g->bin), "video-sink", g->video_sink, NULL);
+  }
 
   /* set audio sink */
   g->audio_sink = gstreamer_set_audio_sink (player);
   if (g->audio_sink)
-    g_object_set (G_OBJECT (g->bin), "audio-sink", g->audio_sink, NULL);
+  {
+    GstElement *sink = g->audio_sink;
+
+    /* the volume is still controlled on the audio sink (see below) */
+    if (player->audio_tap)
+    {
+      sink = gstreamer_audio_tap (player, g->audio_sink);
+      if (!sink)
+      {
+        pl_log (player, PLAYER_MSG_WARNING,
+                MODULE_NAME, "unable to create the audio tap");
+        sink = g->audio_sink;
+      }
+    }
+
+    g_object_set (G_OBJECT (g->bin), "audio-sink", sink, NULL);
+  }
 
   /*
    * If we're using an audio sink that has a volume property,
@@ -695,6 +1299,12 @@ gstreamer_player_init (player_t *player)
 
   gst_element_set_state (g->bin, GST_STATE_NULL);
 
+  /* the identification pipelines are ready before the first MRL */
+  for (i = 0; i < PROBE_POOL; i++)
+    if (gstreamer_probe_new (&g->probe[i]))
+      pl_log (player, PLAYER_MSG_WARNING,
+              MODULE_NAME, "unable to create the identification pipelines");
+
 #ifdef HAVE_WIN_XCB
   gst_bus_set_sync_handler (g->bus, bus_sync_handler_cb, player);
 #endif /* HAVE_WIN_XCB */
@@ -706,6 +1316,7 @@ static void
 gstreamer_player_uninit (player_t *player)
 {
   gstreamer_player_t *g = NULL;
+  int i;
 
   pl_log (player, PLAYER_MSG_INFO, MODULE_NAME, "uninit");
 
@@ -718,6 +1329,12 @@ gstreamer_player_uninit (player_t *player)
 
   gst_element_set_state (g->bin, GST_STATE_NULL);
 
+  for (i = 0; i < SNAPSHOT_POOL; i++)
+    gstreamer_snapshot_free (&g->snapshot[i]);
+
+  for (i = 0; i < PROBE_POOL; i++)
+    gstreamer_probe_free (&g->probe[i]);
+
   pl_window_uninit (player->window);
 
   gst_object_unref (GST_OBJECT (g->bin));
@@ -725,6 +1342,10 @@ gstreamer_player_uninit (player_t *player)
 
   gst_deinit ();
 
+  gstreamer_gapless_reset (g);
+  pthread_mutex_destroy (&g->mutex_gapless);
+  pthread_mutex_destroy (&g->mutex_probe);
+
   PFREE (g);
 }
 
@@ -776,6 +1397,30 @@ gstreamer_set_verbosity (player_t *player, player_verbosity_level_t level)
 #endif
 }
 
+static int
+gstreamer_mrl_flags (mrl_t *mrl)
+{
+  int flags = 0;
+
+  if (mrl->prop)
+    flags |= IDENTIFY_AUDIO | IDENTIFY_VIDEO | IDENTIFY_PROPERTIES;
+
+  if (mrl->meta)
+    flags |= IDENTIFY_METADATA;
+
+  return flags;
+}
+
+/*
+ * The properties and the metadata are retrieved with the same pipeline,
+ * in order to avoid constructing twice the pipeline for the same stream.
+ */
+static void
+gstreamer_mrl_retrieve (player_t *player, mrl_t *mrl)
+{
+  gstreamer_identify (player, mrl, gstreamer_mrl_flags (mrl));
+}
+
 static void
 gstreamer_mrl_retrieve_properties (player_t *player, mrl_t *mrl)
 {
@@ -784,8 +1429,7 @@ gstreamer_mrl_retrieve_properties (player_t *player, mrl_t *mrl)
   if (!player || !mrl || !mrl->prop)
     return;
 
-  gstreamer_identify (player, mrl,
-                      IDENTIFY_AUDIO | IDENTIFY_VIDEO | IDENTIFY_PROPERTIES);
+  gstreamer_mrl_retrieve (player, mrl);
 }
 
 static void
@@ -796,7 +1440,240 @@ gstreamer_mrl_retrieve_metadata (player_t *player, mrl_t *mrl)
   if (!player || !mrl || !mrl->meta)
     return;
 
-  gstreamer_identify (player, mrl, IDENTIFY_METADATA);
+  gstreamer_mrl_retrieve (player, mrl);
+}
+
+/*
+ * The playbin of the playback is used instead of a new pipeline. The
+ * informations are available as soon as the pipeline is prerolled.
+ */
+static int
+gstreamer_mrl_retrieve_live (player_t *player, mrl_t *mrl)
+{
+  gstreamer_player_t *g;
+  gstreamer_identifier_t id;
+  GstTagList *tags = NULL;
+  GstState state = GST_STATE_NULL;
+  mrl_metadata_t *meta;
+  gint i;
+
+  pl_log (player, PLAYER_MSG_VERBOSE, MODULE_NAME, __FUNCTION__);
+
+  if (!player || !mrl)
+    return 0;
+
+  g = player->priv;
+  if (!g || !g->bin || g->live_mrl != mrl)
+    return 0;
+
+  if (gst_element_get_state (g->bin, &state, NULL, PREROLL_TIMEOUT)
+      == GST_STATE_CHANGE_FAILURE || state < GST_STATE_PAUSED)
+    return 0;
+
+  id.player      = player;
+  id.mrl         = mrl;
+  id.bin         = g->bin;
+  id.flags       = gstreamer_mrl_flags (mrl);
+  id.audio_codec = NULL;
+  id.video_codec = NULL;
+
+  meta = mrl->meta;
+
+  /* the tags of the first video and audio streams */
+  for (i = 0; i < 2; i++)
+  {
+    g_signal_emit_by_name (g->bin,
+                           i ? "get-audio-tags" : "get-video-tags", 0, &tags);
+    if (!tags)
+      continue;
+
+    gstreamer_get_tag (tags, &id.video_codec, GST_TAG_VIDEO_CODEC);
+    gstreamer_get_tag (tags, &id.audio_codec, GST_TAG_AUDIO_CODEC);
+
+    if (meta)
+    {
+      GET_TAG (title,   TITLE);
+      GET_TAG (artist,  ARTIST);
+      GET_TAG (album,   ALBUM);
+      GET_TAG (genre,   GENRE);
+      GET_TAG (comment, COMMENT);
+      GET_TAG (track,   TRACK_NUMBER);
+    }
+
+    gst_tag_list_free (tags);
+    tags = NULL;
+  }
+
+  if (mrl->prop)
+  {
+    GstFormat fmt = GST_FORMAT_TIME;
+    gint64 len;
+
+    identify_get_size (mrl);
+
+    if (gst_element_query_duration (g->bin, &fmt, &len)
+        && (fmt == GST_FORMAT_TIME))
+    {
+      mrl->prop->length = NS_TO_MS (len);
+      mrl->prop->seekable = TRUE; /* see identify_bus_callback() */
+    }
+
+    identify_get_props (&id);
+  }
+
+  PFREE (id.audio_codec);
+  PFREE (id.video_codec);
+  return 1;
+}
+
+static int
+gstreamer_mrl_video_snapshot_buffer (player_t *player, mrl_t *mrl, int pos,
+                                     mrl_snapshot_t t,
+                                     mrl_snapshot_buffer_t *buf)
+{
+  GstBuffer *frame, *img = NULL;
+  GstStructure *st;
+  int width = 0, height = 0, stride;
+
+  pl_log (player, PLAYER_MSG_VERBOSE,
+          MODULE_NAME, "mrl_video_snapshot_buffer");
+
+  if (!player || !mrl || !buf)
+    return 0;
+
+  if (t == MRL_SNAPSHOT_TGA)
+  {
+    pl_log (player, PLAYER_MSG_WARNING,
+            MODULE_NAME, "unsupported snapshot type (%i)", t);
+    return 0;
+  }
+
+  frame = gstreamer_snapshot_frame (player, mrl, pos);
+  if (!frame)
+    return 0;
+
+  st = gst_caps_get_structure (GST_BUFFER_CAPS (frame), 0);
+  gst_structure_get_int (st, "width", &width);
+  gst_structure_get_int (st, "height", &height);
+  stride = GST_ROUND_UP_4 (width * 3);
+
+  if (width <= 0 || height <= 0
+      || GST_BUFFER_SIZE (frame) < (guint) (stride * height))
+    goto out;
+
+  switch (t)
+  {
+  case MRL_SNAPSHOT_RGB24:
+    buf->data = malloc (stride * height);
+    if (!buf->data)
+      break;
+
+    memcpy (buf->data, GST_BUFFER_DATA (frame), stride * height);
+    buf->size   = stride * height;
+    buf->width  = width;
+    buf->height = height;
+    buf->stride = stride;
+    break;
+
+  case MRL_SNAPSHOT_PPM:
+  {
+    char header[32];
+    size_t size;
+    int i;
+
+    size = snprintf (header, sizeof (header), "P6\n%i %i\n255\n",
+                     width, height);
+    buf->data = malloc (size + width * 3 * height);
+    if (!buf->data)
+      break;
+
+    /* the lines of the PPM are not padded */
+    memcpy (buf->data, header, size);
+    for (i = 0; i < height; i++)
+      memcpy (buf->data + size + i * width * 3,
+              GST_BUFFER_DATA (frame) + i * stride, width * 3);
+    buf->size = size + width * 3 * height;
+    break;
+  }
+
+  case MRL_SNAPSHOT_JPG:
+    img = gstreamer_snapshot_encode (player, frame, "jpegenc");
+    break;
+
+  case MRL_SNAPSHOT_PNG:
+    img = gstreamer_snapshot_encode (player,
+                                     frame, "pngenc compression-level=2");
+    break;
+
+  default:
+    break;
+  }
+
+  if (img)
+  {
+    buf->data = malloc (GST_BUFFER_SIZE (img));
+    if (buf->data)
+    {
+      memcpy (buf->data, GST_BUFFER_DATA (img), GST_BUFFER_SIZE (img));
+      buf->size = GST_BUFFER_SIZE (img);
+    }
+    gst_buffer_unref (img);
+  }
+
+  buf->type = t;
+
+ out:
+  gst_buffer_unref (frame);
+  return buf->data ? 1 : 0;
+}
+
+static void
+gstreamer_mrl_video_snapshot (player_t *player, mrl_t *mrl,
+                              int pos, mrl_snapshot_t t, const char *dst)
+{
+  mrl_snapshot_buffer_t buf;
+  char name[32];
+
+  pl_log (player, PLAYER_MSG_VERBOSE, MODULE_NAME, "mrl_video_snapshot");
+
+  if (!player || !mrl)
+    return;
+
+  switch (t)
+  {
+  case MRL_SNAPSHOT_JPG:
+    snprintf (name, sizeof (name), "snapshot.jpg");
+    break;
+
+  case MRL_SNAPSHOT_PNG:
+    snprintf (name, sizeof (name), "snapshot.png");
+    break;
+
+  case MRL_SNAPSHOT_PPM:
+    snprintf (name, sizeof (name), "snapshot.ppm");
+    break;
+
+  default:
+    pl_log (player, PLAYER_MSG_WARNING,
+            MODULE_NAME, "unsupported snapshot type (%i)", t);
+    return;
+  }
+
+  memset (&buf, 0, sizeof (buf));
+  if (!gstreamer_mrl_video_snapshot_buffer (player, mrl, pos, t, &buf))
+    return;
+
+  /* use the current directory? */
+  if (!dst)
+    dst = name;
+
+  if (!pl_write_file (dst, buf.data, buf.size))
+    pl_log (player, PLAYER_MSG_INFO, MODULE_NAME, "snapshot saved to %s", dst);
+  else
+    pl_log (player, PLAYER_MSG_ERROR,
+            MODULE_NAME, "unable to write the snapshot to %s", dst);
+
+  PFREE (buf.data);
 }
 
 static int
@@ -867,6 +1744,26 @@ gstreamer_player_playback_start (player_t *player)
 
   g = player->priv;
 
+  /* already prerolled by gstreamer_player_playback_prepare() */
+  if (g->prepared_mrl == mrl)
+  {
+    g->prepared_mrl = NULL;
+    gst_element_set_state (g->bin, GST_STATE_PLAYING);
+
+    if (MRL_USES_VO (mrl))
+      pl_window_map (player->window);
+
+    return PLAYER_PB_OK;
+  }
+
+  if (g->prepared_mrl)
+  {
+    gst_element_set_state (g->bin, GST_STATE_NULL);
+    g->prepared_mrl = NULL;
+  }
+
+  gstreamer_gapless_reset (g);
+
   uri = get_uri (mrl);
   if (uri)
   {
@@ -874,6 +1771,9 @@ gstreamer_player_playback_start (player_t *player)
 
     /* put GStreamer engine in playback state */
     gst_element_set_state (g->bin, GST_STATE_PLAYING);
+
+    g->live_mrl = mrl;
+    mrl_retrieve_deferred (player, mrl);
   }
   else
   {
@@ -903,12 +1803,142 @@ gstreamer_player_playback_stop (player_t *player)
   g = player->priv;
 
   gst_element_set_state (g->bin, GST_STATE_NULL);
+  g->live_mrl = NULL;
+  g->prepared_mrl = NULL;
+  gstreamer_gapless_reset (g);
 
   mrl = pl_playlist_get_mrl (player->playlist);
   if (MRL_USES_VO (mrl))
     pl_window_unmap (player->window);
 }
 
+/*
+ * The playbin is prerolled (opened, demuxed and paused on the first frame)
+ * while nothing is playing, then gstreamer_player_playback_start() has only
+ * to set the PLAYING state.
+ */
+static playback_status_t
+gstreamer_player_playback_prepare (player_t *player, mrl_t *mrl)
+{
+  gstreamer_player_t *g;
+  GstStateChangeReturn st;
+  GstState state;
+  char *uri;
+
+  pl_log (player, PLAYER_MSG_VERBOSE, MODULE_NAME, "playback_prepare");
+
+  if (!player || !mrl)
+    return PLAYER_PB_FATAL;
+
+  g = player->priv;
+  if (!g || !g->bin)
+    return PLAYER_PB_FATAL;
+
+  if (g->prepared_mrl == mrl)
+    return PLAYER_PB_OK;
+
+  /* only one playbin, a playback is running */
+  gst_element_get_state (g->bin, &state, NULL, 0);
+  if (!g->prepared_mrl && state == GST_STATE_PLAYING)
+    return PLAYER_PB_ERROR;
+
+  uri = get_uri (mrl);
+  if (!uri)
+    return PLAYER_PB_ERROR;
+
+  gst_element_set_state (g->bin, GST_STATE_NULL);
+  gstreamer_gapless_reset (g);
+  g->prepared_mrl = NULL;
+
+  g_object_set (G_OBJECT (g->bin), "uri", uri, NULL);
+  PFREE (uri);
+
+  gst_element_set_state (g->bin, GST_STATE_PAUSED);
+  st = gst_element_get_state (g->bin, NULL, NULL, PREROLL_TIMEOUT);
+  if (st == GST_STATE_CHANGE_FAILURE)
+  {
+    gst_element_set_state (g->bin, GST_STATE_NULL);
+    return PLAYER_PB_ERROR;
+  }
+
+  g->live_mrl = mrl;
+  g->prepared_mrl = mrl;
+  mrl_retrieve_deferred (player, mrl);
+
+  return PLAYER_PB_OK;
+}
+
+static void
+gstreamer_player_playback_preload (player_t *player, mrl_t *mrl)
+{
+  gstreamer_player_t *g;
+  char *uri;
+
+  pl_log (player, PLAYER_MSG_VERBOSE, MODULE_NAME, "playback_preload");
+
+  if (!player || !mrl)
+    return;
+
+  g = player->priv;
+
+  uri = get_uri (mrl);
+  if (!uri)
+    return;
+
+  /* the uri is given to the playbin with "about-to-finish" */
+  pthread_mutex_lock (&g->mutex_gapless);
+  if (g->gapless_done)
+    PFREE (uri); /* too late */
+  else
+  {
+    PFREE (g->gapless_uri);
+    g->gapless_uri = uri;
+    g->gapless_mrl = mrl;
+  }
+  pthread_mutex_unlock (&g->mutex_gapless);
+}
+
+static playback_status_t
+gstreamer_player_playback_gapless (player_t *player, mrl_t *mrl)
+{
+  gstreamer_player_t *g;
+  int switched;
+  mrl_t *next;
+
+  pl_log (player, PLAYER_MSG_VERBOSE, MODULE_NAME, "playback_gapless");
+
+  if (!player)
+    return PLAYER_PB_FATAL;
+
+  g = player->priv;
+
+  pthread_mutex_lock (&g->mutex_gapless);
+  switched = g->gapless_switched;
+  next = g->gapless_mrl;
+  pthread_mutex_unlock (&g->mutex_gapless);
+
+  gstreamer_gapless_reset (g);
+
+  if (!switched)
+    return PLAYER_PB_ERROR;
+
+  /* not the expected MRL (the playlist has changed) */
+  if (next != mrl)
+  {
+    gstreamer_player_playback_stop (player);
+    return PLAYER_PB_ERROR;
+  }
+
+  mrl_retrieve_deferred (player, mrl);
+
+  if (MRL_USES_VO (mrl))
+    pl_window_map (player->window);
+  else
+    pl_window_unmap (player->window);
+
+  return PLAYER_PB_OK;
+}
+
 static playback_status_t
 gstreamer_player_playback_pause (player_t *player)
 {
@@ -1147,7 +2177,10 @@ pl_register_functions_gstreamer (void)
 
   funcs->mrl_retrieve_props = gstreamer_mrl_retrieve_properties;
   funcs->mrl_retrieve_meta  = gstreamer_mrl_retrieve_metadata;
-  funcs->mrl_video_snapshot = NULL;
+  funcs->mrl_retrieve_live  = gstreamer_mrl_retrieve_live;
+  funcs->mrl_video_snapshot = gstreamer_mrl_video_snapshot;
+  funcs->mrl_video_snapshot_buffer = gstreamer_mrl_video_snapshot_buffer;
+  funcs->mrl_video_snapshot_batch = NULL;
 
   funcs->get_time_pos       = gstreamer_get_time_pos;
   funcs->get_percent_pos    = gstreamer_get_percent_pos;
@@ -1162,6 +2195,9 @@ pl_register_functions_gstreamer (void)
   funcs->pb_seek            = gstreamer_player_playback_seek;
   funcs->pb_seek_chapter    = NULL;
   funcs->pb_set_speed       = NULL;
+  funcs->pb_preload         = gstreamer_player_playback_preload;
+  funcs->pb_gapless         = gstreamer_player_playback_gapless;
+  funcs->pb_prepare         = gstreamer_player_playback_prepare;
 
   funcs->audio_get_volume   = gstreamer_audio_get_volume;
   funcs->audio_set_volume   = gstreamer_audio_set_volume;
@@ -1215,5 +2251,8 @@ pl_register_private_gstreamer (void)
   if (!g)
     return NULL;
 
+  pthread_mutex_init (&g->mutex_gapless, NULL);
+  pthread_mutex_init (&g->mutex_probe, NULL);
+
   return g;
 }
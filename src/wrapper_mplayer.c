@@ -19,15 +19,20 @@
  * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
  */
 
+#define _GNU_SOURCE /* pipe2 */
+
 #include <stdlib.h>
 #include <inttypes.h>
 #include <stdio.h>
-#include <fcntl.h>        /* open */
+#include <fcntl.h>        /* open O_CLOEXEC */
 #include <string.h>       /* strstr strlen memcpy strdup */
 #include <stdarg.h>       /* va_start va_end */
-#include <unistd.h>       /* pipe fork close dup2 */
+#include <unistd.h>       /* pipe pipe2 fork close dup2 */
 #include <math.h>         /* rintf */
+#include <time.h>         /* clock_gettime */
+#include <errno.h>        /* ETIMEDOUT */
 #include <sys/wait.h>     /* waitpid */
+#include <dirent.h>       /* opendir readdir closedir */
 #include <pthread.h>      /* pthread_... */
 #include <semaphore.h>    /* sem_post sem_wait sem_init sem_destroy */
 
@@ -39,12 +44,16 @@
 #include "fs_utils.h"
 #include "parse_utils.h"
 #include "window.h"
+#include "frame_ring.h"
+#include "audio_tap.h"
 #include "wrapper_mplayer.h"
 
 #define MODULE_NAME "mplayer"
 
 #define FIFO_BUFFER      256
 #define PATH_BUFFER      512
+#define LIVE_IDS_MAX     65536
+#define GAPLESS_WAIT     5 /* in seconds, see mplayer_playback_gapless() */
 #define MPLAYER_NAME     "mplayer"
 
 #define SNAPSHOT_FILE    "00000001"
@@ -79,6 +88,13 @@ typedef enum mplayer_seek {
   MPLAYER_SEEK_ABSOLUTE = 2,
 } mplayer_seek_t;
 
+/* how a stream is loaded with SLAVE_LOADFILE */
+typedef enum mplayer_loadfile {
+  MPLAYER_LOADFILE_PLAY   = 0, /* new play */
+  MPLAYER_LOADFILE_APPEND = 1, /* appended to the playlist of MPlayer */
+  MPLAYER_LOADFILE_PAUSED = 2, /* new play, paused on the first frame */
+} mplayer_loadfile_t;
+
 /* Status of MPlayer child */
 typedef enum mplayer_status {
   MPLAYER_IS_IDLE,
@@ -163,6 +179,24 @@ typedef struct mplayer_s {
   FILE *fifo_out;     /* fifo on the pipe_out (read only)  */
   pthread_t th_fifo;
 
+  /* decoded frames with PLAYER_VO_FRAMES (-vo yuv4mpeg) */
+  int   pipe_frames[2];
+  FILE *fifo_frames;  /* fifo on the pipe_frames (read only) */
+  pthread_t th_frames;
+
+  /* decoded audio with the audio tap (-af export), see thread_audio() */
+  int   tap_fd;       /* file of the filter export (unlinked) */
+  pthread_t th_audio;
+  pthread_mutex_t mutex_tap;
+  int     tap_run;    /* th_audio is polling tap_fd           */
+  int     tap_rate;   /* ID_AUDIO_RATE of the current stream  */
+
+  /* timestamps of the frames and of the audio tap, see mp_sync_set() */
+  pthread_mutex_t mutex_sync;
+  int64_t sync_time;   /* position (ms) to apply, -1 unknown    */
+  int     sync_frames; /* sync_time is not yet applied by frames */
+  int     sync_tap;    /* sync_time is not yet applied by tap    */
+
   sem_t sem;  /* common to 'loadfile' and 'get_property' */
 
   /* for the MPlayer properties, see slave_result() */
@@ -176,6 +210,18 @@ typedef struct mplayer_s {
   pthread_cond_t   cond_status;
   pthread_mutex_t  mutex_status;
   mplayer_status_t status;
+
+  /* ID_ lines printed with 'loadfile', see mplayer_mrl_retrieve_live() */
+  pthread_mutex_t  mutex_live;
+  char            *live_ids;
+  size_t           live_size;
+  mrl_t           *live_mrl;  /* MRL loaded by the slave */
+
+  /* gapless playback (protected by mutex_live) */
+  mrl_t *gapless_mrl;   /* MRL appended to the playlist of MPlayer */
+  int    gapless_done;  /* MPlayer has switched to gapless_mrl     */
+
+  mrl_t *prepared_mrl;  /* MRL loaded and paused by pb_prepare() */
 } mplayer_t;
 
 /*
@@ -494,6 +540,25 @@ get_mplayer_status (player_t *player)
   return status;
 }
 
+/*
+ * New position of the stream for the timestamps of the decoded frames and
+ * of the audio tap, see thread_frames() and thread_audio().
+ */
+static void
+mp_sync_set (player_t *player, int64_t time)
+{
+  mplayer_t *mplayer = player->priv;
+
+  if (player->vo != PLAYER_VO_FRAMES && !player->audio_tap)
+    return;
+
+  pthread_mutex_lock (&mplayer->mutex_sync);
+  mplayer->sync_time   = time;
+  mplayer->sync_frames = 1;
+  mplayer->sync_tap    = 1;
+  pthread_mutex_unlock (&mplayer->mutex_sync);
+}
+
 /*****************************************************************************/
 /*                              MPlayer Parser                               */
 /*****************************************************************************/
@@ -600,6 +665,44 @@ thread_fifo (void *arg)
                 MODULE_NAME, "%s with this version of MPlayer", buffer);
     }
 
+    /*
+     * The ID_ lines are printed by MPlayer when a stream is loaded. They are
+     * saved in order to retrieve the properties and the metadata of the
+     * stream without a new identification, see mplayer_mrl_retrieve_live().
+     */
+    if (strstr (buffer, "ID_") == buffer)
+    {
+      size_t len = strcspn (buffer, "\n");
+
+      pthread_mutex_lock (&mplayer->mutex_live);
+      if (mplayer->live_size + len + 2 <= LIVE_IDS_MAX)
+      {
+        char *ids = realloc (mplayer->live_ids, mplayer->live_size + len + 2);
+        if (ids)
+        {
+          memcpy (ids + mplayer->live_size, buffer, len);
+          mplayer->live_size += len;
+          ids[mplayer->live_size++] = '\n';
+          ids[mplayer->live_size] = '\0';
+          mplayer->live_ids = ids;
+        }
+      }
+      pthread_mutex_unlock (&mplayer->mutex_live);
+
+      /* the filter export does not give the rate of the samples */
+      if (player->audio_tap && strstr (buffer, "ID_AUDIO_RATE=") == buffer)
+      {
+        int rate = atoi (buffer + strlen ("ID_AUDIO_RATE="));
+
+        if (rate > 0)
+        {
+          pthread_mutex_lock (&mplayer->mutex_tap);
+          mplayer->tap_rate = rate;
+          pthread_mutex_unlock (&mplayer->mutex_tap);
+        }
+      }
+    }
+
     /*
      * Here, the result of a property requested by the slave command
      * 'get_property', is searched and saved.
@@ -662,7 +765,24 @@ thread_fifo (void *arg)
       pthread_mutex_lock (&mplayer->mutex_status);
       if (mplayer->status == MPLAYER_IS_PLAYING)
       {
-        mplayer->status = MPLAYER_IS_IDLE;
+        int gapless;
+
+        /*
+         * With the gapless playback, MPlayer continues with the MRL appended
+         * to its playlist, see mplayer_playback_gapless().
+         */
+        pthread_mutex_lock (&mplayer->mutex_live);
+        gapless = mplayer->gapless_mrl && !mplayer->gapless_done;
+        if (gapless)
+        {
+          PFREE (mplayer->live_ids);
+          mplayer->live_size = 0;
+          mplayer->live_mrl = mplayer->gapless_mrl;
+          mplayer->gapless_done = 1;
+        }
+        pthread_mutex_unlock (&mplayer->mutex_live);
+
+        mplayer->status = gapless ? MPLAYER_IS_LOADING : MPLAYER_IS_IDLE;
         pthread_mutex_unlock (&mplayer->mutex_status);
 
         pl_log (player, PLAYER_MSG_INFO,
@@ -670,7 +790,10 @@ thread_fifo (void *arg)
 
         player_event_send (player, PLAYER_EVENT_PLAYBACK_FINISHED);
 
-        pl_window_unmap (player->window);
+        if (!gapless)
+          pl_window_unmap (player->window);
+        else
+          mp_sync_set (player, 0);
       }
       else
       {
@@ -826,6 +949,248 @@ thread_fifo (void *arg)
   pthread_exit (NULL);
 }
 
+/*
+ * YUV4MPEG2 stream of -vo yuv4mpeg (PLAYER_VO_FRAMES). A header is written
+ * with each new video output, then each frame follows a "FRAME" line.
+ */
+static void
+parse_y4m_header (char *line, int *width, int *height, int *fps_n, int *fps_d)
+{
+  char *it, *saveptr;
+
+  for (it = strtok_r (line, " \n", &saveptr); it;
+       it = strtok_r (NULL, " \n", &saveptr))
+    switch (*it)
+    {
+    case 'W':
+      *width = atoi (it + 1);
+      break;
+
+    case 'H':
+      *height = atoi (it + 1);
+      break;
+
+    case 'F':
+      if (sscanf (it + 1, "%i:%i", fps_n, fps_d) != 2 || *fps_d <= 0)
+        *fps_n = 0;
+      break;
+
+    default:
+      break;
+    }
+}
+
+static void *
+thread_frames (void *arg)
+{
+  player_t *player = arg;
+  mplayer_t *mplayer = player->priv;
+  char line[256];
+  int width = 0, height = 0, fps_n = 0, fps_d = 1;
+  int stride[3];
+  size_t offset[3];
+  uint8_t *drop = NULL;
+  size_t drop_size = 0;
+  int64_t nb = 0, base = 0;
+
+  while (fgets (line, sizeof (line), mplayer->fifo_frames))
+  {
+    player_frame_t *frame;
+    uint8_t *data;
+    size_t size;
+
+    /* MPlayer writes no new header with a seek */
+    pthread_mutex_lock (&mplayer->mutex_sync);
+    if (mplayer->sync_frames)
+    {
+      base = mplayer->sync_time;
+      nb = 0;
+      mplayer->sync_frames = 0;
+    }
+    pthread_mutex_unlock (&mplayer->mutex_sync);
+
+    if (!strncmp (line, "YUV4MPEG2", 9))
+    {
+      parse_y4m_header (line + 9, &width, &height, &fps_n, &fps_d);
+      nb = 0;
+      continue;
+    }
+
+    if (strncmp (line, "FRAME", 5))
+      continue;
+
+    /* MPlayer writes 4:2:0 only, the planes are contiguous */
+    size = pl_frame_layout (PLAYER_FRAME_I420, width, height, stride, offset);
+    if (!size)
+      break;
+
+    /* the frame is read directly in the ring, or skipped if it is full */
+    frame = pl_frame_ring_acquire (player->frames,
+                                   PLAYER_FRAME_I420, width, height);
+    if (frame)
+      data = frame->plane[0];
+    else
+    {
+      if (drop_size < size)
+      {
+        PFREE (drop);
+        drop = malloc (size);
+        drop_size = drop ? size : 0;
+        if (!drop)
+          break;
+      }
+      data = drop;
+    }
+
+    if (fread (data, 1, size, mplayer->fifo_frames) != size)
+    {
+      pl_frame_ring_cancel (player->frames, frame);
+      break;
+    }
+
+    if (frame)
+    {
+      /*
+       * No timestamps in YUV4MPEG2, only the frame rate. The frames are
+       * counted from the position of the last start or seek.
+       */
+      if (fps_n > 0 && base >= 0)
+        frame->pts = base + nb * 1000 * fps_d / fps_n;
+      pl_frame_ring_publish (player->frames, frame);
+    }
+    nb++;
+  }
+
+  PFREE (drop);
+  pthread_exit (NULL);
+}
+
+#define TAP_HEADER  (2 * sizeof (int) + sizeof (unsigned long long))
+#define TAP_SAMPLES 16384
+#define TAP_POLL    10000 /* us */
+#define TAP_IDLE    250   /* ms */
+
+static int64_t
+tap_clock (void)
+{
+  struct timespec ts;
+
+  clock_gettime (CLOCK_MONOTONIC, &ts);
+  return (int64_t) ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+/* file for the filter export, in TMPDIR or /tmp */
+static int
+mp_tap_open (void)
+{
+  const char *dir = getenv ("TMPDIR");
+  char *path;
+  size_t size;
+  int fd;
+
+  if (!dir || !*dir)
+    dir = "/tmp";
+
+  size = strlen (dir) + strlen ("/libplayer-tap-XXXXXX") + 1;
+  path = malloc (size);
+  if (!path)
+    return -1;
+
+  snprintf (path, size, "%s/libplayer-tap-XXXXXX", dir);
+  fd = mkstemp (path);
+  if (fd >= 0)
+    unlink (path);
+
+  PFREE (path);
+  return fd;
+}
+
+/*
+ * Audio tap with the filter export of MPlayer (-af export). The filter
+ * writes in its file the number of channels, the number of samples by
+ * channel and a counter, then the samples of each channel one after the
+ * other (signed 16 bits). The counter is incremented when the buffer is
+ * updated. The file is polled, then some samples are never seen, but the
+ * blocks are enough for the meters. It is read with pread() and not mapped
+ * because MPlayer truncates it when the audio output is reinitialized.
+ *
+ * MPlayer gives no time with the samples. The time of the blocks starts at
+ * the position retrieved with each start and seek (see mp_sync_set()) and
+ * follows the clock, except when nothing is exported (paused).
+ */
+static void *
+thread_audio (void *arg)
+{
+  player_t *player = arg;
+  mplayer_t *mplayer = player->priv;
+  int16_t planar[TAP_SAMPLES], pcm[TAP_SAMPLES];
+  unsigned long long count, check, last = 0;
+  int64_t pts = -1, now, clock = 0;
+  int hdr[2], rate;
+
+  for (;;)
+  {
+    int ch, i, nch, sz;
+    size_t size;
+
+    usleep (TAP_POLL);
+
+    pthread_mutex_lock (&mplayer->mutex_tap);
+    if (!mplayer->tap_run)
+    {
+      pthread_mutex_unlock (&mplayer->mutex_tap);
+      break;
+    }
+    rate = mplayer->tap_rate;
+    pthread_mutex_unlock (&mplayer->mutex_tap);
+
+    pthread_mutex_lock (&mplayer->mutex_sync);
+    if (mplayer->sync_tap)
+    {
+      pts = mplayer->sync_time;
+      clock = 0;
+      mplayer->sync_tap = 0;
+    }
+    pthread_mutex_unlock (&mplayer->mutex_sync);
+
+    if (pread (mplayer->tap_fd, hdr, sizeof (hdr), 0) != sizeof (hdr)
+        || pread (mplayer->tap_fd, &count, sizeof (count),
+                  TAP_HEADER - sizeof (count)) != sizeof (count)
+        || count == last)
+      continue;
+
+    nch = hdr[0];
+    sz  = hdr[1];
+    if (nch <= 0 || sz <= 0 || nch > TAP_SAMPLES / sz)
+      continue;
+
+    size = (size_t) nch * sz * sizeof (int16_t);
+    if (pread (mplayer->tap_fd, planar, size, TAP_HEADER) != (ssize_t) size)
+      continue;
+
+    /* the buffer is updated by MPlayer while it is read */
+    if (pread (mplayer->tap_fd, &check, sizeof (check),
+               TAP_HEADER - sizeof (check)) != sizeof (check)
+        || check != count)
+      continue;
+
+    last = count;
+
+    for (ch = 0; ch < nch; ch++)
+      for (i = 0; i < sz; i++)
+        pcm[i * nch + ch] = planar[ch * sz + i];
+
+    now = tap_clock ();
+    if (pts >= 0 && clock && now - clock < TAP_IDLE)
+      pts += now - clock;
+    clock = now;
+
+    pl_audio_tap_push (player->audio_tap, pcm, sz, nch, rate, pts);
+  }
+
+  pthread_exit (NULL);
+}
+
 /*****************************************************************************/
 /*                              Slave functions                              */
 /*****************************************************************************/
@@ -1066,7 +1431,7 @@ static void
 slave_action (player_t *player, slave_cmd_t cmd, slave_value_t *value, int opt)
 {
   mplayer_t *mplayer = NULL;
-  const char *command;
+  const char *command, *pause;
   item_state_t state_cmd;
 
   if (!player)
@@ -1093,11 +1458,24 @@ slave_action (player_t *player, slave_cmd_t cmd, slave_value_t *value, int opt)
   switch (cmd)
   {
   case SLAVE_LOADFILE:
-    if (state_cmd == ITEM_ON && value && value->s_val)
+    /* appended to the playlist, MPlayer will load it after the current */
+    if (state_cmd == ITEM_ON && value && value->s_val
+        && opt == MPLAYER_LOADFILE_APPEND)
+      send_to_slave (player, "%s \"%s\" %i", command, value->s_val, opt);
+    else if (state_cmd == ITEM_ON && value && value->s_val)
     {
       pthread_mutex_lock (&mplayer->mutex_status);
       mplayer->status = MPLAYER_IS_LOADING;
-      send_to_slave (player, "%s \"%s\" %i", command, value->s_val, opt);
+      send_to_slave (player, "%s \"%s\" %i",
+                     command, value->s_val, MPLAYER_LOADFILE_PLAY);
+      /*
+       * The pause is queued behind 'loadfile' without waiting for the
+       * playback. MPlayer runs it with the first iteration of its playback
+       * loop, once the first frame is shown and the audio output is filled.
+       */
+      pause = get_cmd (player, SLAVE_PAUSE, NULL);
+      if (opt == MPLAYER_LOADFILE_PAUSED && pause)
+        send_to_slave (player, "%s", pause);
       pthread_cond_wait (&mplayer->cond_status, &mplayer->mutex_status);
       pthread_mutex_unlock (&mplayer->mutex_status);
     }
@@ -1868,7 +2246,7 @@ mp_identify_metadata_sub (mrl_t *mrl, const char *buffer)
   if (it == buffer)
   {
     int id = atoi (parse_field (it));
-    mrl_metadata_sub_t *sub = mrl_metadata_sub_get (&meta->subs, id);
+    mrl_metadata_sub_t *sub = mrl_metadata_sub_get (meta, id);
 
     if (!sub)
       return 1;
@@ -1880,7 +2258,7 @@ mp_identify_metadata_sub (mrl_t *mrl, const char *buffer)
   res = sscanf (buffer, "ID_SID_%i_%s", &cnt, val);
   if (res && res != EOF)
   {
-    mrl_metadata_sub_t *sub = mrl_metadata_sub_get (&meta->subs, cnt);
+    mrl_metadata_sub_t *sub = mrl_metadata_sub_get (meta, cnt);
 
     if (!sub)
       return 1;
@@ -1914,7 +2292,7 @@ mp_identify_metadata_audio (mrl_t *mrl, const char *buffer)
   {
     int id = atoi (parse_field (it));
     mrl_metadata_audio_t *audio =
-      mrl_metadata_audio_get (&meta->audio_streams, id);
+      mrl_metadata_audio_get (meta, id);
 
     if (!audio)
       return 1;
@@ -1927,7 +2305,7 @@ mp_identify_metadata_audio (mrl_t *mrl, const char *buffer)
   if (res && res != EOF)
   {
     mrl_metadata_audio_t *audio =
-      mrl_metadata_audio_get (&meta->audio_streams, cnt);
+      mrl_metadata_audio_get (meta, cnt);
 
     if (!audio)
       return 1;
@@ -2160,6 +2538,23 @@ mp_identify_properties (mrl_t *mrl, const char *buffer)
   return 0;
 }
 
+static void
+mp_identify_line (mrl_t *mrl, const char *buffer,
+                  int flags, mp_identify_clip_t *clip)
+{
+  if (flags & IDENTIFY_VIDEO)
+    mp_identify_video (mrl, buffer);
+
+  if (flags & IDENTIFY_AUDIO)
+    mp_identify_audio (mrl, buffer);
+
+  if (flags & IDENTIFY_METADATA)
+    mp_identify_metadata (mrl, buffer, clip);
+
+  if (flags & IDENTIFY_PROPERTIES)
+    mp_identify_properties (mrl, buffer);
+}
+
 static void
 mp_identify (player_t *player, mrl_t *mrl, int flags)
 {
@@ -2174,7 +2569,11 @@ mp_identify (player_t *player, mrl_t *mrl, int flags)
   if (!uri)
     return;
 
-  if (pipe (mp_pipe))
+  /*
+   * The identifications can run concurrently (mrl_probe_batch), then the
+   * pipe must not be inherited by the MPlayer children of the other workers.
+   */
+  if (pipe2 (mp_pipe, O_CLOEXEC))
   {
     PFREE (uri);
     return;
@@ -2215,10 +2614,13 @@ mp_identify (player_t *player, mrl_t *mrl, int flags)
     params[pp] = NULL;
 
     execvp (MPLAYER_NAME, params);
-    break;
+    _exit (EXIT_FAILURE);
   }
 
   case -1:
+    close (mp_pipe[0]);
+    close (mp_pipe[1]);
+    PFREE (uri);
     break;
 
   /* I'm your father */
@@ -2240,30 +2642,19 @@ mp_identify (player_t *player, mrl_t *mrl, int flags)
       *(buffer + strlen (buffer) - 1) = '\0';
       pl_log (player, PLAYER_MSG_VERBOSE, MODULE_NAME, "[identify] %s", buffer);
 
-      if (flags & IDENTIFY_VIDEO)
-        mp_identify_video (mrl, buffer);
-
-      if (flags & IDENTIFY_AUDIO)
-        mp_identify_audio (mrl, buffer);
-
-      if (flags & IDENTIFY_METADATA)
-        mp_identify_metadata (mrl, buffer, &clip);
-
-      if (flags & IDENTIFY_PROPERTIES)
-        mp_identify_properties (mrl, buffer);
+      mp_identify_line (mrl, buffer, flags, &clip);
     }
 
     /* wait the death of MPlayer */
     waitpid (pid, NULL, 0);
     PFREE (uri);
-    close (mp_pipe[0]);
     fclose (mp_fifo);
   }
   }
 }
 
-static void
-mp_mrl_retrieve (player_t *player, mrl_t *mrl)
+static int
+mp_mrl_flags (mrl_t *mrl)
 {
   int flags = 0;
 
@@ -2289,7 +2680,13 @@ mp_mrl_retrieve (player_t *player, mrl_t *mrl)
   if (mrl->meta)
     flags |= IDENTIFY_METADATA;
 
-  mp_identify (player, mrl, flags);
+  return flags;
+}
+
+static void
+mp_mrl_retrieve (player_t *player, mrl_t *mrl)
+{
+  mp_identify (player, mrl, mp_mrl_flags (mrl));
 }
 
 /*****************************************************************************/
@@ -2502,7 +2899,7 @@ mp_check_compatibility (player_t *player, checklist_t check)
   if (!list)
     return 0;
 
-  if (pipe (mp_pipe))
+  if (pipe2 (mp_pipe, O_CLOEXEC))
     return 0;
 
   pid = fork ();
@@ -2537,7 +2934,7 @@ mp_check_compatibility (player_t *player, checklist_t check)
     params[pp] = NULL;
 
     execvp (MPLAYER_NAME, params);
-    break;
+    _exit (EXIT_FAILURE);
   }
 
   case -1:
@@ -2600,7 +2997,6 @@ mp_check_compatibility (player_t *player, checklist_t check)
     }
 
     waitpid (pid, NULL, 0);
-    close (mp_pipe[0]);
     fclose (mp_fifo);
   }
   }
@@ -2658,6 +3054,7 @@ mp_preinit_vo (player_t *player, uint32_t *winid)
   case PLAYER_VO_NULL:
   case PLAYER_VO_FB:
   case PLAYER_VO_DIRECTFB:
+  case PLAYER_VO_FRAMES:
     break;
 
   case PLAYER_VO_X11:
@@ -2729,6 +3126,8 @@ mplayer_init (player_t *player)
 {
   mplayer_t *mplayer = NULL;
   char winid[32];
+  char vo_frames[64];
+  char af_tap[64];
   uint32_t winid_l = 0;
   int use_x11 = 0;
 
@@ -2764,12 +3163,33 @@ mplayer_init (player_t *player)
   if (!mp_check_compatibility (player, CHECKLIST_PROPERTIES))
     return PLAYER_INIT_ERROR;
 
-  use_x11 = mp_preinit_vo (player, &winid_l);
-  if (use_x11 < 0)
-    return PLAYER_INIT_ERROR;
+  /* no window for an audio-only player */
+  if (!player->audio_only)
+  {
+    use_x11 = mp_preinit_vo (player, &winid_l);
+    if (use_x11 < 0)
+      return PLAYER_INIT_ERROR;
+  }
 
   snprintf (winid, sizeof (winid), "%u", winid_l);
 
+  /*
+   * The decoded audio (PCM) is exported by MPlayer in a file which is
+   * already unlinked; it is opened again with the inherited descriptor.
+   */
+  if (player->audio_tap)
+  {
+    mplayer->tap_fd = mp_tap_open ();
+    if (mplayer->tap_fd < 0)
+    {
+      pl_log (player, PLAYER_MSG_ERROR,
+              MODULE_NAME, "unable to create the file for the audio tap");
+      return PLAYER_INIT_ERROR;
+    }
+
+    snprintf (af_tap, sizeof (af_tap), "export=/dev/fd/%i", mplayer->tap_fd);
+  }
+
   if (pipe (mplayer->pipe_in))
     return PLAYER_INIT_ERROR;
 
@@ -2780,6 +3200,22 @@ mplayer_init (player_t *player)
     return PLAYER_INIT_ERROR;
   }
 
+  /* the frames are written by MPlayer in the inherited end of the pipe */
+  if (player->vo == PLAYER_VO_FRAMES)
+  {
+    if (pipe (mplayer->pipe_frames))
+    {
+      close (mplayer->pipe_in[0]);
+      close (mplayer->pipe_in[1]);
+      close (mplayer->pipe_out[0]);
+      close (mplayer->pipe_out[1]);
+      return PLAYER_INIT_ERROR;
+    }
+
+    snprintf (vo_frames, sizeof (vo_frames),
+              "yuv4mpeg:file=/dev/fd/%i", mplayer->pipe_frames[1]);
+  }
+
   mplayer->pid = fork ();
 
   switch (mplayer->pid)
@@ -2787,7 +3223,7 @@ mplayer_init (player_t *player)
   /* the son (a new hope) */
   case 0:
   {
-    char *params[32];
+    char *params[40];
     int pp = 0;
 
     close (mplayer->pipe_in[1]);
@@ -2800,12 +3236,15 @@ mplayer_init (player_t *player)
     dup2 (mplayer->pipe_out[1], STDOUT_FILENO);
     close (mplayer->pipe_out[1]);
 
+    if (player->vo == PLAYER_VO_FRAMES)
+      close (mplayer->pipe_frames[0]);
+
     /* default MPlayer arguments */
     params[pp++] = MPLAYER_NAME;
     params[pp++] = "-slave";            /* work in slave mode */
     params[pp++] = "-quiet";            /* reduce output messages */
     params[pp++] = "-msglevel";
-    params[pp++] = "all=2:global=6:cplayer=7";
+    params[pp++] = "all=2:global=6:cplayer=7:identify=6";
     params[pp++] = "-idle";             /* MPlayer stays always alive */
     params[pp++] = "-fs";               /* fullscreen (if possible) */
     params[pp++] = "-zoom";             /* zoom (if possible) */
@@ -2819,6 +3258,10 @@ mplayer_init (player_t *player)
     params[pp++] = "-nograbpointer";
     params[pp++] = "-noconsolecontrols";
 
+    /* the video is never decoded */
+    if (player->audio_only)
+      params[pp++] = "-novideo";
+
     /* select the video output */
     /* TODO: possibility to add parameters for each video output */
     switch (player->vo)
@@ -2888,6 +3331,11 @@ mplayer_init (player_t *player)
       params[pp++] = "vaapi";
       break;
 
+    case PLAYER_VO_FRAMES:
+      params[pp++] = "-vo";
+      params[pp++] = vo_frames;
+      break;
+
     case PLAYER_VO_AUTO:
     default:
       break;
@@ -2930,6 +3378,13 @@ mplayer_init (player_t *player)
       break;
     }
 
+    /* the audio output is kept, the samples are only copied */
+    if (player->audio_tap)
+    {
+      params[pp++] = "-af-add";
+      params[pp++] = af_tap;
+    }
+
     /* select expected video decoding quality */
     switch (player->quality)
     {
@@ -2951,6 +3406,10 @@ mplayer_init (player_t *player)
       break;
     }
 
+    /* keep the audio output open between the streams of the playlist */
+    if (player->gapless)
+      params[pp++] = "-gapless-audio";
+
     params[pp] = NULL;
 
     execvp (MPLAYER_NAME, params);
@@ -2973,6 +3432,33 @@ mplayer_init (player_t *player)
 
     pl_log (player, PLAYER_MSG_INFO, MODULE_NAME, "MPlayer child loaded");
 
+    if (player->vo == PLAYER_VO_FRAMES)
+    {
+      close (mplayer->pipe_frames[1]);
+      mplayer->fifo_frames = fdopen (mplayer->pipe_frames[0], "r");
+
+      /* the thread ends with the EOF, when MPlayer is dead */
+      if (mplayer->fifo_frames
+          && pthread_create (&mplayer->th_frames, NULL, thread_frames, player))
+      {
+        fclose (mplayer->fifo_frames);
+        mplayer->fifo_frames = NULL;
+      }
+
+      if (!mplayer->fifo_frames)
+        pl_log (player, PLAYER_MSG_ERROR,
+                MODULE_NAME, "unable to read the decoded frames");
+    }
+
+    if (player->audio_tap)
+    {
+      mplayer->tap_run =
+        !pthread_create (&mplayer->th_audio, NULL, thread_audio, player);
+      if (!mplayer->tap_run)
+        pl_log (player, PLAYER_MSG_ERROR,
+                MODULE_NAME, "unable to read the decoded audio");
+    }
+
     mplayer->status = MPLAYER_IS_IDLE;
 
     pthread_attr_init (&attr);
@@ -3042,11 +3528,28 @@ mplayer_uninit (player_t *player)
     fclose (mplayer->fifo_in);
     fclose (mplayer->fifo_out);
 
+    if (mplayer->fifo_frames)
+    {
+      pthread_join (mplayer->th_frames, NULL);
+      fclose (mplayer->fifo_frames);
+    }
+
+    if (mplayer->tap_run)
+    {
+      pthread_mutex_lock (&mplayer->mutex_tap);
+      mplayer->tap_run = 0;
+      pthread_mutex_unlock (&mplayer->mutex_tap);
+      pthread_join (mplayer->th_audio, NULL);
+    }
+
     pl_log (player, PLAYER_MSG_INFO, MODULE_NAME, "MPlayer child terminated");
   }
 
   pl_window_uninit (player->window);
 
+  if (mplayer->tap_fd >= 0)
+    close (mplayer->tap_fd);
+
   item_list_free (mplayer->slave_cmds, g_slave_cmds_nb);
   item_list_free (mplayer->slave_props, g_slave_props_nb);
 
@@ -3056,8 +3559,12 @@ mplayer_uninit (player_t *player)
   pthread_mutex_destroy (&mplayer->mutex_status);
   pthread_mutex_destroy (&mplayer->mutex_verbosity);
   pthread_mutex_destroy (&mplayer->mutex_start);
+  pthread_mutex_destroy (&mplayer->mutex_live);
+  pthread_mutex_destroy (&mplayer->mutex_tap);
+  pthread_mutex_destroy (&mplayer->mutex_sync);
   sem_destroy (&mplayer->sem);
 
+  PFREE (mplayer->live_ids);
   PFREE (mplayer);
 }
 
@@ -3107,9 +3614,10 @@ mplayer_set_verbosity (player_t *player, player_verbosity_level_t level)
  * NOTE: mplayer -identify returns always all informations (properties and
  *       metadata).
  *
- * mplayer_mrl_retrieve_properties() and mplayer_mrl_retrieve_metadata() will
- * retrieve all informations in order to avoid executing twice MPlayer with
- * an identical output.
+ * The probe planner allocates the properties and the metadata before the
+ * call of mplayer_mrl_retrieve_properties(), then all informations are
+ * retrieved in order to avoid executing twice MPlayer with an identical
+ * output.
  */
 
 static void
@@ -3120,9 +3628,6 @@ mplayer_mrl_retrieve_properties (player_t *player, mrl_t *mrl)
   if (!player || !mrl || !mrl->prop)
     return;
 
-  if (!mrl->meta)
-    mrl->meta = mrl_metadata_new (mrl->resource);
-
   mp_mrl_retrieve (player, mrl);
 }
 
@@ -3134,53 +3639,107 @@ mplayer_mrl_retrieve_metadata (player_t *player, mrl_t *mrl)
   if (!player || !mrl || !mrl->meta)
     return;
 
-  if (!mrl->prop)
-    mrl->prop = mrl_properties_new ();
-
   mp_mrl_retrieve (player, mrl);
 }
 
-static void
-mplayer_mrl_video_snapshot (player_t *player, mrl_t *mrl,
-                            int pos, mrl_snapshot_t t, const char *dst)
+/*
+ * The ID_ lines printed by the slave with 'loadfile' are identical to the
+ * output of mp_identify(). Then the MRL playing is not opened a second time.
+ */
+static int
+mplayer_mrl_retrieve_live (player_t *player, mrl_t *mrl)
 {
-  pid_t pid;
-  char *uri = NULL;
-  char name[32] = SNAPSHOT_FILE;
-  char tmp[] = SNAPSHOT_TMP;
-  char vo[PATH_BUFFER], file[PATH_BUFFER];
+  mplayer_t *mplayer;
+  mp_identify_clip_t clip = {
+    .cnt      = 0,
+    .property = PROPERTY_UNKNOWN
+  };
+  char *ids = NULL, *line, *saveptr = NULL;
+  int flags;
 
-  pl_log (player, PLAYER_MSG_VERBOSE, MODULE_NAME, "mrl_video_snapshot");
+  pl_log (player, PLAYER_MSG_VERBOSE, MODULE_NAME, "mrl_retrieve_live");
 
   if (!player || !mrl)
-    return;
+    return 0;
 
-  uri = mp_resource_get_uri (mrl);
-  if (!uri)
-    return;
+  mplayer = player->priv;
 
-  switch (t)
-  {
-  case MRL_SNAPSHOT_JPG:
-    snprintf (vo, sizeof (vo), "jpeg:outdir=");
-    strcat (name, ".jpg");
-    break;
+  if (!mplayer || get_mplayer_status (player) != MPLAYER_IS_PLAYING)
+    return 0;
 
-  case MRL_SNAPSHOT_PNG: /* outdir only supported with MPlayer >= r27650 */
-    snprintf (vo, sizeof (vo), "png:z=2:outdir=");
-    strcat (name, ".png");
-    break;
+  pthread_mutex_lock (&mplayer->mutex_live);
+  if (mplayer->live_mrl == mrl && mplayer->live_ids)
+    ids = strdup (mplayer->live_ids);
+  pthread_mutex_unlock (&mplayer->mutex_live);
 
-  case MRL_SNAPSHOT_PPM:
-    snprintf (vo, sizeof (vo), "pnm:ppm:outdir=");
-    strcat (name, ".ppm");
+  if (!ids)
+    return 0;
+
+  flags = mp_mrl_flags (mrl);
+
+  for (line = strtok_r (ids, "\n", &saveptr); line;
+       line = strtok_r (NULL, "\n", &saveptr))
+    mp_identify_line (mrl, line, flags, &clip);
+
+  PFREE (ids);
+  return 1;
+}
+
+static int
+mp_snapshot_vo (player_t *player, mrl_snapshot_t t,
+                char *vo, size_t vo_size, char *name, size_t name_size)
+{
+  const char *ext;
+
+  switch (t)
+  {
+  case MRL_SNAPSHOT_JPG:
+    snprintf (vo, vo_size, "jpeg:outdir=");
+    ext = ".jpg";
+    break;
+
+  case MRL_SNAPSHOT_PNG: /* outdir only supported with MPlayer >= r27650 */
+    snprintf (vo, vo_size, "png:z=2:outdir=");
+    ext = ".png";
+    break;
+
+  case MRL_SNAPSHOT_PPM:
+    snprintf (vo, vo_size, "pnm:ppm:outdir=");
+    ext = ".ppm";
     break;
 
   default:
     pl_log (player, PLAYER_MSG_WARNING,
             MODULE_NAME, "unsupported snapshot type (%i)", t);
+    return -1;
+  }
+
+  if (name)
+    strncat (name, ext, name_size - strlen (name) - 1);
+  return 0;
+}
+
+/*
+ * The frame is written in the new temporary directory \p tmp, \p file is
+ * set to its path. On success, the caller must remove the directory.
+ */
+static int
+mp_snapshot (player_t *player, mrl_t *mrl, int pos, mrl_snapshot_t t,
+             char *tmp, char *file, size_t size)
+{
+  pid_t pid;
+  char *uri = NULL;
+  char name[32] = SNAPSHOT_FILE;
+  char vo[PATH_BUFFER];
+
+  uri = mp_resource_get_uri (mrl);
+  if (!uri)
+    return -1;
+
+  if (mp_snapshot_vo (player, t, vo, sizeof (vo), name, sizeof (name)))
+  {
     PFREE (uri);
-    return;
+    return -1;
   }
 
   if (!mkdtemp (tmp))
@@ -3188,11 +3747,11 @@ mplayer_mrl_video_snapshot (player_t *player, mrl_t *mrl,
     pl_log (player, PLAYER_MSG_ERROR,
             MODULE_NAME, "unable to create temporary directory (%s)", tmp);
     PFREE (uri);
-    return;
+    return -1;
   }
 
   strcat (vo, tmp);
-  snprintf (file, sizeof (file), "%s/%s", tmp, name);
+  snprintf (file, size, "%s/%s", tmp, name);
 
   pl_log (player, PLAYER_MSG_VERBOSE,
           MODULE_NAME, "temporary directory for snapshot: %s", tmp);
@@ -3245,7 +3804,7 @@ mplayer_mrl_video_snapshot (player_t *player, mrl_t *mrl,
     params[pp] = NULL;
 
     execvp (MPLAYER_NAME, params);
-    break;
+    _exit (EXIT_FAILURE);
   }
 
   case -1:
@@ -3253,74 +3812,352 @@ mplayer_mrl_video_snapshot (player_t *player, mrl_t *mrl,
 
   /* I'm your father */
   default:
-  {
     /* wait the death of MPlayer */
     waitpid (pid, NULL, 0);
-    PFREE (uri);
+    break;
+  }
 
-    if (pl_file_exists (file))
-    {
-      /* use the current directory? */
-      if (!dst)
-        dst = name;
+  PFREE (uri);
 
-      if (dst)
-      {
-        int res = pl_copy_file (file, dst);
-        if (!res)
-          pl_log (player, PLAYER_MSG_INFO,
-                  MODULE_NAME, "move %s to %s", file, dst);
-        else
-          pl_log (player, PLAYER_MSG_ERROR,
-                  MODULE_NAME, "unable to move %s to %s", file, dst);
-      }
+  if (pl_file_exists (file))
+    return 0;
 
-      unlink (file);
-    }
-    else
-      pl_log (player, PLAYER_MSG_WARNING, MODULE_NAME,
-              "image file (%s) is unavailable, maybe MPlayer can't seek in "
-              "this video", file);
+  pl_log (player, PLAYER_MSG_WARNING, MODULE_NAME,
+          "image file (%s) is unavailable, maybe MPlayer can't seek in "
+          "this video", file);
+  rmdir (tmp);
+  return -1;
+}
+
+static void
+mplayer_mrl_video_snapshot (player_t *player, mrl_t *mrl,
+                            int pos, mrl_snapshot_t t, const char *dst)
+{
+  char tmp[] = SNAPSHOT_TMP;
+  char file[PATH_BUFFER];
+
+  pl_log (player, PLAYER_MSG_VERBOSE, MODULE_NAME, "mrl_video_snapshot");
+
+  if (!player || !mrl)
+    return;
+
+  if (mp_snapshot (player, mrl, pos, t, tmp, file, sizeof (file)))
+    return;
+
+  /* use the current directory? */
+  if (!dst)
+    dst = strrchr (file, '/') + 1;
 
-    rmdir (tmp);
+  if (!pl_move_file (file, dst))
+    pl_log (player, PLAYER_MSG_INFO,
+            MODULE_NAME, "move %s to %s", file, dst);
+  else
+  {
+    pl_log (player, PLAYER_MSG_ERROR,
+            MODULE_NAME, "unable to move %s to %s", file, dst);
+    unlink (file);
   }
+
+  rmdir (tmp);
+}
+
+static int
+mplayer_mrl_video_snapshot_buffer (player_t *player, mrl_t *mrl, int pos,
+                                   mrl_snapshot_t t,
+                                   mrl_snapshot_buffer_t *buf)
+{
+  char tmp[] = SNAPSHOT_TMP;
+  char file[PATH_BUFFER];
+  mrl_snapshot_t type;
+
+  pl_log (player, PLAYER_MSG_VERBOSE,
+          MODULE_NAME, "mrl_video_snapshot_buffer");
+
+  if (!player || !mrl || !buf)
+    return 0;
+
+  /* the raw pixels are extracted from the PPM image */
+  type = t == MRL_SNAPSHOT_RGB24 ? MRL_SNAPSHOT_PPM : t;
+
+  if (mp_snapshot (player, mrl, pos, type, tmp, file, sizeof (file)))
+    return 0;
+
+  buf->data = pl_read_file (file, &buf->size);
+  buf->type = type;
+
+  unlink (file);
+  rmdir (tmp);
+
+  if (!buf->data)
+    return 0;
+
+  if (t == MRL_SNAPSHOT_RGB24 && !mrl_snapshot_ppm_unpack (buf))
+  {
+    PFREE (buf->data);
+    buf->size = 0;
+    return 0;
   }
+
+  return 1;
 }
 
-static playback_status_t
-mplayer_playback_start (player_t *player)
+/*
+ * Keep only the last frame written by the image video output in the
+ * directory \p dir, the older ones are removed. The frames are numbered
+ * by MPlayer then the last one has the greatest name.
+ */
+static int
+mp_snapshot_last (const char *dir, char *file, size_t size)
 {
-  mplayer_t *mplayer = NULL;
-  char *uri = NULL;
-  mrl_t *mrl;
+  DIR *d;
+  struct dirent *entry;
+  char last[256] = "";
+  char path[PATH_BUFFER];
 
-  pl_log (player, PLAYER_MSG_VERBOSE, MODULE_NAME, "playback_start");
+  d = opendir (dir);
+  if (!d)
+    return -1;
 
-  if (!player)
-    return PLAYER_PB_FATAL;
+  while ((entry = readdir (d)))
+  {
+    if (*entry->d_name == '.')
+      continue;
 
-  mplayer = player->priv;
+    if (strcmp (entry->d_name, last) > 0)
+    {
+      if (*last)
+      {
+        snprintf (path, sizeof (path), "%s/%s", dir, last);
+        unlink (path);
+      }
+      snprintf (last, sizeof (last), "%s", entry->d_name);
+      continue;
+    }
 
-  if (!mplayer)
-    return PLAYER_PB_FATAL;
+    snprintf (path, sizeof (path), "%s/%s", dir, entry->d_name);
+    unlink (path);
+  }
 
-  mrl = pl_playlist_get_mrl (player->playlist);
-  if (!mrl)
-    return PLAYER_PB_ERROR;
+  closedir (d);
+
+  if (!*last)
+    return -1;
+
+  snprintf (file, size, "%s/%s", dir, last);
+  return 0;
+}
+
+/*
+ * Only one MPlayer (slave) is used for all positions. Each frame is
+ * written by the image video output after a seek in pause mode.
+ */
+static void
+mplayer_mrl_video_snapshot_batch (player_t *player, mrl_t *mrl,
+                                  const int *pos, int n,
+                                  mrl_snapshot_t t, const char *dst)
+{
+  int pipe_in[2], pipe_out[2];
+  pid_t pid;
+  char *uri = NULL;
+  char tmp[] = SNAPSHOT_TMP;
+  char vo[PATH_BUFFER], file[PATH_BUFFER];
+
+  pl_log (player, PLAYER_MSG_VERBOSE, MODULE_NAME, "mrl_video_snapshot_batch");
+
+  if (!player || !mrl || !pos || n <= 0 || !dst)
+    return;
 
   uri = mp_resource_get_uri (mrl);
   if (!uri)
-    return PLAYER_PB_ERROR;
+    return;
 
-  pl_log (player, PLAYER_MSG_INFO, MODULE_NAME, "uri: %s", uri);
+  if (mp_snapshot_vo (player, t, vo, sizeof (vo), NULL, 0))
+    goto err_uri;
+
+  if (!mkdtemp (tmp))
+  {
+    pl_log (player, PLAYER_MSG_ERROR,
+            MODULE_NAME, "unable to create temporary directory (%s)", tmp);
+    goto err_uri;
+  }
+
+  strcat (vo, tmp);
+
+  if (pipe (pipe_in))
+    goto err_tmp;
+
+  if (pipe (pipe_out))
+  {
+    close (pipe_in[0]);
+    close (pipe_in[1]);
+    goto err_tmp;
+  }
+
+  pid = fork ();
+
+  switch (pid)
+  {
+  /* the son (a new hope) */
+  case 0:
+  {
+    char *params[32];
+    char ss[32];
+    int pp = 0;
+    int fd;
 
-  /* 0: new play, 1: append to the current playlist */
-  slave_cmd_str_opt (player, SLAVE_LOADFILE, uri, 0);
+    close (pipe_in[1]);
+    close (pipe_out[0]);
+
+    dup2 (pipe_in[0], STDIN_FILENO);
+    close (pipe_in[0]);
+
+    dup2 (pipe_out[1], STDOUT_FILENO);
+    close (pipe_out[1]);
+
+    fd = open ("/dev/null", O_WRONLY);
+    dup2 (fd, STDERR_FILENO);
+    close (fd);
+
+    params[pp++] = MPLAYER_NAME;
+    params[pp++] = "-slave";
+    params[pp++] = "-nocache";
+    params[pp++] = "-quiet";
+    params[pp++] = "-msglevel";
+    params[pp++] = "all=0:global=4";    /* only the answers (ANS_) */
+    params[pp++] = "-nolirc";
+    params[pp++] = "-nojoystick";
+    params[pp++] = "-noconsolecontrols";
+    params[pp++] = "-noar";
+    params[pp++] = "-nomouseinput";
+    params[pp++] = "-nosound";
+    params[pp++] = "-noautosub";
+    params[pp++] = "-osdlevel";
+    params[pp++] = "0";
+
+    params[pp++] = "-vo";
+    params[pp++] = vo;
+
+    params[pp++] = "-ao";
+    params[pp++] = "null";
+
+    /* the demuxer is opened near of the first position */
+    snprintf (ss, sizeof (ss), "%i", *pos);
+    params[pp++] = "-ss";
+    params[pp++] = ss;
+
+    params[pp++] = uri;
+    params[pp] = NULL;
+
+    execvp (MPLAYER_NAME, params);
+    _exit (EXIT_FAILURE);
+  }
+
+  case -1:
+    close (pipe_in[0]);
+    close (pipe_in[1]);
+    close (pipe_out[0]);
+    close (pipe_out[1]);
+    break;
 
+  /* I'm your father */
+  default:
+  {
+    FILE *fifo_in, *fifo_out;
+    char buffer[FIFO_BUFFER];
+    int i;
+
+    close (pipe_in[0]);
+    close (pipe_out[1]);
+
+    fifo_in  = fdopen (pipe_in[1], "w");
+    fifo_out = fdopen (pipe_out[0], "r");
+
+    for (i = 0; i < n; i++)
+    {
+      char out[PATH_BUFFER];
+      char *res;
+
+      /*
+       * The frame is written by the seek, the answer of the property
+       * is only used to know when the seek is done.
+       */
+      fprintf (fifo_in, "pausing seek %i 2\n", pos[i]);
+      fprintf (fifo_in, "pausing_keep_force get_property time_pos\n");
+      fflush (fifo_in);
+
+      while ((res = fgets (buffer, FIFO_BUFFER, fifo_out)))
+        if (!strncmp (buffer, "ANS_", 4))
+          break;
+
+      if (!res)
+      {
+        pl_log (player, PLAYER_MSG_ERROR,
+                MODULE_NAME, "MPlayer has stopped before the snapshot %i", i);
+        break;
+      }
+
+      if (mp_snapshot_last (tmp, file, sizeof (file)))
+      {
+        pl_log (player, PLAYER_MSG_WARNING, MODULE_NAME,
+                "image at %is is unavailable, maybe MPlayer can't seek in "
+                "this video", pos[i]);
+        continue;
+      }
+
+      /* the pattern is checked by mrl_sv_video_snapshot_batch() */
+      snprintf (out, sizeof (out), dst, i);
+
+      if (!pl_move_file (file, out))
+        pl_log (player, PLAYER_MSG_INFO,
+                MODULE_NAME, "move %s to %s", file, out);
+      else
+      {
+        pl_log (player, PLAYER_MSG_ERROR,
+                MODULE_NAME, "unable to move %s to %s", file, out);
+        unlink (file);
+      }
+    }
+
+    fprintf (fifo_in, "quit\n");
+    fflush (fifo_in);
+    fclose (fifo_in);
+    fclose (fifo_out);
+
+    /* wait the death of MPlayer */
+    waitpid (pid, NULL, 0);
+  }
+  }
+
+  /* remove the frames not used */
+  if (!mp_snapshot_last (tmp, file, sizeof (file)))
+    unlink (file);
+
+ err_tmp:
+  rmdir (tmp);
+ err_uri:
   PFREE (uri);
+}
 
-  if (get_mplayer_status (player) != MPLAYER_IS_PLAYING)
-    return PLAYER_PB_ERROR;
+/* position of the stream after a start or a seek, see mp_sync_set() */
+static void
+mp_sync (player_t *player)
+{
+  float time_pos;
+
+  if (player->vo != PLAYER_VO_FRAMES && !player->audio_tap)
+    return;
+
+  time_pos = slave_get_property_float (player, PROPERTY_TIME_POS);
+  mp_sync_set (player, time_pos < 0.0 ? -1 : (int64_t) (time_pos * 1000.0));
+}
+
+/* when the stream is playing */
+
+static void
+mp_playback_loaded (player_t *player, mrl_t *mrl)
+{
+  mrl_retrieve_deferred (player, mrl);
+  mp_sync (player);
 
   /*
    * Not all parameters can be set by the MRL, this function try to set/load
@@ -3343,8 +4180,8 @@ mplayer_playback_start (player_t *player)
 
   if (MRL_USES_VO (mrl))
     pl_window_map (player->window);
-
-  return PLAYER_PB_OK;
+  else
+    pl_window_unmap (player->window);
 }
 
 static void
@@ -3373,11 +4210,252 @@ mplayer_playback_stop (player_t *player)
   mplayer->status = MPLAYER_IS_IDLE;
   pthread_mutex_unlock (&mplayer->mutex_status);
 
+  mplayer->prepared_mrl = NULL;
+
+  /* 'stop' clears the playlist of MPlayer */
+  pthread_mutex_lock (&mplayer->mutex_live);
+  mplayer->gapless_mrl = NULL;
+  mplayer->gapless_done = 0;
+  pthread_mutex_unlock (&mplayer->mutex_live);
+
   mrl = pl_playlist_get_mrl (player->playlist);
   if (MRL_USES_VO (mrl))
     pl_window_unmap (player->window);
 
   slave_cmd (player, SLAVE_STOP);
+  mp_sync_set (player, -1);
+}
+
+static playback_status_t
+mplayer_playback_start (player_t *player)
+{
+  mplayer_t *mplayer = NULL;
+  char *uri = NULL;
+  mrl_t *mrl;
+
+  pl_log (player, PLAYER_MSG_VERBOSE, MODULE_NAME, "playback_start");
+
+  if (!player)
+    return PLAYER_PB_FATAL;
+
+  mplayer = player->priv;
+
+  if (!mplayer)
+    return PLAYER_PB_FATAL;
+
+  mrl = pl_playlist_get_mrl (player->playlist);
+  if (!mrl)
+    return PLAYER_PB_ERROR;
+
+  /* already loaded by mplayer_playback_prepare(), just resume */
+  if (mplayer->prepared_mrl == mrl
+      && get_mplayer_status (player) == MPLAYER_IS_PLAYING)
+  {
+    mplayer->prepared_mrl = NULL;
+    slave_cmd (player, SLAVE_PAUSE);
+    mp_playback_loaded (player, mrl);
+    return PLAYER_PB_OK;
+  }
+
+  if (mplayer->prepared_mrl)
+    mplayer_playback_stop (player);
+
+  uri = mp_resource_get_uri (mrl);
+  if (!uri)
+    return PLAYER_PB_ERROR;
+
+  pl_log (player, PLAYER_MSG_INFO, MODULE_NAME, "uri: %s", uri);
+
+  /* forget the ID_ lines of the previous stream */
+  pthread_mutex_lock (&mplayer->mutex_live);
+  PFREE (mplayer->live_ids);
+  mplayer->live_size = 0;
+  mplayer->live_mrl = mrl;
+  mplayer->gapless_mrl = NULL;
+  mplayer->gapless_done = 0;
+  pthread_mutex_unlock (&mplayer->mutex_live);
+
+  slave_cmd_str_opt (player, SLAVE_LOADFILE, uri, MPLAYER_LOADFILE_PLAY);
+
+  PFREE (uri);
+
+  if (get_mplayer_status (player) != MPLAYER_IS_PLAYING)
+    return PLAYER_PB_ERROR;
+
+  mp_playback_loaded (player, mrl);
+  return PLAYER_PB_OK;
+}
+
+/*
+ * The stream is loaded and paused as soon as MPlayer has started it, then
+ * mplayer_playback_start() has only to resume. MPlayer has only one stream,
+ * nothing can be prepared while a playback is running.
+ *
+ * The pause is processed after the first iteration of the playback loop of
+ * MPlayer. The first frame is shown, and the first block of audio is written
+ * to the audio output before it is paused; the position drifts by one frame
+ * at most.
+ */
+static playback_status_t
+mplayer_playback_prepare (player_t *player, mrl_t *mrl)
+{
+  mplayer_t *mplayer = NULL;
+  char *uri;
+
+  pl_log (player, PLAYER_MSG_VERBOSE, MODULE_NAME, "playback_prepare");
+
+  if (!player || !mrl)
+    return PLAYER_PB_FATAL;
+
+  mplayer = player->priv;
+
+  if (!mplayer)
+    return PLAYER_PB_FATAL;
+
+  if (mplayer->prepared_mrl)
+  {
+    if (mplayer->prepared_mrl == mrl
+        && get_mplayer_status (player) == MPLAYER_IS_PLAYING)
+      return PLAYER_PB_OK;
+
+    mplayer_playback_stop (player);
+  }
+  else if (get_mplayer_status (player) != MPLAYER_IS_IDLE)
+    return PLAYER_PB_ERROR;
+
+  uri = mp_resource_get_uri (mrl);
+  if (!uri)
+    return PLAYER_PB_ERROR;
+
+  pl_log (player, PLAYER_MSG_INFO, MODULE_NAME, "prepare uri: %s", uri);
+
+  /* forget the ID_ lines of the previous stream */
+  pthread_mutex_lock (&mplayer->mutex_live);
+  PFREE (mplayer->live_ids);
+  mplayer->live_size = 0;
+  mplayer->live_mrl = mrl;
+  mplayer->gapless_mrl = NULL;
+  mplayer->gapless_done = 0;
+  pthread_mutex_unlock (&mplayer->mutex_live);
+
+  slave_cmd_str_opt (player, SLAVE_LOADFILE, uri, MPLAYER_LOADFILE_PAUSED);
+
+  PFREE (uri);
+
+  if (get_mplayer_status (player) != MPLAYER_IS_PLAYING)
+    return PLAYER_PB_ERROR;
+
+  mplayer->prepared_mrl = mrl;
+
+  mrl_retrieve_deferred (player, mrl);
+  return PLAYER_PB_OK;
+}
+
+static void
+mplayer_playback_preload (player_t *player, mrl_t *mrl)
+{
+  mplayer_t *mplayer = NULL;
+  char *uri;
+
+  pl_log (player, PLAYER_MSG_VERBOSE, MODULE_NAME, "playback_preload");
+
+  if (!player || !mrl)
+    return;
+
+  mplayer = player->priv;
+
+  if (!mplayer)
+    return;
+
+  uri = mp_resource_get_uri (mrl);
+  if (!uri)
+    return;
+
+  /* MPlayer can't remove an entry of its playlist, only one is appended */
+  pthread_mutex_lock (&mplayer->mutex_live);
+  if (mplayer->gapless_mrl)
+  {
+    pthread_mutex_unlock (&mplayer->mutex_live);
+    PFREE (uri);
+    return;
+  }
+
+  mplayer->gapless_mrl = mrl;
+  mplayer->gapless_done = 0;
+  pthread_mutex_unlock (&mplayer->mutex_live);
+
+  pl_log (player, PLAYER_MSG_INFO, MODULE_NAME, "preload uri: %s", uri);
+
+  slave_cmd_str_opt (player, SLAVE_LOADFILE, uri, MPLAYER_LOADFILE_APPEND);
+
+  PFREE (uri);
+}
+
+static playback_status_t
+mplayer_playback_gapless (player_t *player, mrl_t *mrl)
+{
+  mplayer_t *mplayer = NULL;
+  mplayer_status_t status;
+  struct timespec ts;
+  mrl_t *next;
+  int done;
+
+  pl_log (player, PLAYER_MSG_VERBOSE, MODULE_NAME, "playback_gapless");
+
+  if (!player)
+    return PLAYER_PB_FATAL;
+
+  mplayer = player->priv;
+
+  if (!mplayer)
+    return PLAYER_PB_FATAL;
+
+  pthread_mutex_lock (&mplayer->mutex_live);
+  next = mplayer->gapless_mrl;
+  done = mplayer->gapless_done;
+  mplayer->gapless_mrl = NULL;
+  mplayer->gapless_done = 0;
+  pthread_mutex_unlock (&mplayer->mutex_live);
+
+  if (!done)
+    return PLAYER_PB_ERROR;
+
+  clock_gettime (CLOCK_REALTIME, &ts);
+  ts.tv_sec += GAPLESS_WAIT;
+
+  /* wait until MPlayer has started the appended stream */
+  pthread_mutex_lock (&mplayer->mutex_status);
+  while (mplayer->status == MPLAYER_IS_LOADING)
+    if (pthread_cond_timedwait (&mplayer->cond_status,
+                                &mplayer->mutex_status, &ts) == ETIMEDOUT)
+      break;
+
+  /*
+   * MPlayer has maybe failed to open the appended stream, it stays idle
+   * with nothing printed. The usual path loads the MRL again, and
+   * 'loadfile' replaces the stream if MPlayer is only slow to start it.
+   */
+  status = mplayer->status;
+  if (status == MPLAYER_IS_LOADING)
+    mplayer->status = MPLAYER_IS_IDLE;
+  pthread_mutex_unlock (&mplayer->mutex_status);
+
+  if (status == MPLAYER_IS_LOADING)
+    pl_log (player, PLAYER_MSG_WARNING,
+            MODULE_NAME, "the appended stream is not started, gapless dropped");
+
+  if (status != MPLAYER_IS_PLAYING)
+    return PLAYER_PB_ERROR;
+
+  /* not the expected MRL (the playlist has changed) */
+  if (next != mrl)
+  {
+    mplayer_playback_stop (player);
+    return PLAYER_PB_ERROR;
+  }
+
+  mp_playback_loaded (player, mrl);
+  return PLAYER_PB_OK;
 }
 
 static playback_status_t
@@ -3427,6 +4505,7 @@ mplayer_playback_seek (player_t *player, int value, player_pb_seek_t seek)
   }
 
   slave_cmd_float_opt (player, SLAVE_SEEK, pos, opt);
+  mp_sync (player);
 }
 
 static void
@@ -3443,6 +4522,7 @@ mplayer_playback_seek_chapter (player_t *player, int value, int absolute)
    *       else MPlayer hangs if a chapter after the last is reached.
    */
   slave_cmd_int_opt (player, SLAVE_SEEK_CHAPTER, value, absolute);
+  mp_sync (player);
 }
 
 static void
@@ -4170,7 +5250,10 @@ pl_register_functions_mplayer (void)
 
   funcs->mrl_retrieve_props = mplayer_mrl_retrieve_properties;
   funcs->mrl_retrieve_meta  = mplayer_mrl_retrieve_metadata;
+  funcs->mrl_retrieve_live  = mplayer_mrl_retrieve_live;
   funcs->mrl_video_snapshot = mplayer_mrl_video_snapshot;
+  funcs->mrl_video_snapshot_buffer = mplayer_mrl_video_snapshot_buffer;
+  funcs->mrl_video_snapshot_batch = mplayer_mrl_video_snapshot_batch;
 
   funcs->get_time_pos       = mplayer_get_time_pos;
   funcs->get_percent_pos    = mplayer_get_percent_pos;
@@ -4185,6 +5268,9 @@ pl_register_functions_mplayer (void)
   funcs->pb_seek            = mplayer_playback_seek;
   funcs->pb_seek_chapter    = mplayer_playback_seek_chapter;
   funcs->pb_set_speed       = mplayer_playback_set_speed;
+  funcs->pb_preload         = mplayer_playback_preload;
+  funcs->pb_gapless         = mplayer_playback_gapless;
+  funcs->pb_prepare         = mplayer_playback_prepare;
 
   funcs->audio_get_volume   = mplayer_audio_get_volume;
   funcs->audio_set_volume   = mplayer_audio_set_volume;
@@ -4239,6 +5325,8 @@ pl_register_private_mplayer (void)
     return NULL;
 
   mplayer->status = MPLAYER_IS_DEAD;
+  mplayer->tap_fd = -1;
+  mplayer->sync_time = -1;
 
   sem_init (&mplayer->sem, 0, 0);
   pthread_cond_init (&mplayer->cond_start, NULL);
@@ -4247,6 +5335,9 @@ pl_register_private_mplayer (void)
   pthread_mutex_init (&mplayer->mutex_status, NULL);
   pthread_mutex_init (&mplayer->mutex_verbosity, NULL);
   pthread_mutex_init (&mplayer->mutex_start, NULL);
+  pthread_mutex_init (&mplayer->mutex_live, NULL);
+  pthread_mutex_init (&mplayer->mutex_tap, NULL);
+  pthread_mutex_init (&mplayer->mutex_sync, NULL);
 
   return mplayer;
 }
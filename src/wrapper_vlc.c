@@ -24,6 +24,8 @@
 #include <inttypes.h>
 #include <string.h>
 #include <unistd.h>
+#include <time.h>
+#include <pthread.h>
 #include <vlc/vlc.h>
 
 #include "player.h"
@@ -34,17 +36,64 @@
 #include "fs_utils.h"
 #include "parse_utils.h"
 #include "window.h"
+#include "frame_ring.h"
+#include "audio_tap.h"
 #include "wrapper_vlc.h"
 
 #define MODULE_NAME "vlc"
 
-#define WAIT_PERIOD    1000 /* in micro-seconds */
 #define WAIT_MAX    5000000 /* in micro-seconds */
 
+#define PROBE_POOL       2    /* media players kept for the probes */
+
+#define SNAPSHOT_WINDOW  1000 /* ms, frames accepted around the position */
+#define SNAPSHOT_NONE    (-1) /* no frame expected */
+#define SNAPSHOT_ANY     (-2) /* the first frame */
+
+/* identification, see vlc_identify() */
+typedef struct vlc_probe_s {
+  libvlc_media_player_t *mp;  /* reused for the streams to decode */
+  int busy;
+  int parsed;                 /* libvlc_MediaParsedChanged received */
+  int playing;                /* libvlc_MediaPlayerPlaying received */
+  int vout;                   /* libvlc_MediaPlayerVout received */
+  int done;                   /* error or end of stream */
+  pthread_mutex_t mutex;
+  pthread_cond_t cond;
+} vlc_probe_t;
+
 /* player specific structure */
 typedef struct vlc_s {
   libvlc_instance_t *core;
   libvlc_media_player_t *mp;
+  mrl_t *live_mrl;  /* MRL set in the media player */
+  vlc_probe_t live; /* events of mp, see vlc_event_callback() */
+  int live_map;     /* map the window with the vout (live.mutex) */
+
+  /* off-screen snapshots, see vlc_snapshot_frame() */
+  libvlc_media_player_t *snap_mp;
+  char *snap_uri;             /* URI set in snap_mp */
+  unsigned int snap_width;    /* size of the frames given to vmem */
+  unsigned int snap_height;
+  uint8_t *snap_pixels;       /* written by the video output */
+  uint8_t *snap_frame;        /* copy of the frame at the position */
+  libvlc_time_t snap_target;  /* position (ms) of the frame expected */
+  pthread_mutex_t snap_mutex;
+  pthread_cond_t snap_cond;
+
+  /* decoded frames, see vlc_frame_lock() */
+  unsigned int frame_width;   /* size of the frames given to vmem */
+  unsigned int frame_height;
+  player_frame_t *frame;      /* locked in the ring, not yet displayed */
+  uint8_t *frame_drop;        /* written when the ring is full */
+
+  /* audio tap, see vlc_audio_play() */
+  unsigned int tap_rate;
+  unsigned int tap_channels;
+
+  /* identification, see vlc_probe_get() */
+  vlc_probe_t probe[PROBE_POOL];
+  pthread_mutex_t probe_mutex;
 } vlc_t;
 
 static const libvlc_event_type_t mp_events[] = {
@@ -52,34 +101,82 @@ static const libvlc_event_type_t mp_events[] = {
   libvlc_MediaPlayerPaused,
   libvlc_MediaPlayerEndReached,
   libvlc_MediaPlayerStopped,
+  libvlc_MediaPlayerVout,
+  libvlc_MediaPlayerEncounteredError,
+};
+
+static const libvlc_event_type_t probe_events[] = {
+  libvlc_MediaPlayerPlaying,
+  libvlc_MediaPlayerVout,
+  libvlc_MediaPlayerEncounteredError,
+  libvlc_MediaPlayerEndReached,
 };
 
 /*****************************************************************************/
 /*                            common routines                                */
 /*****************************************************************************/
 
+static void
+vlc_live_set (vlc_probe_t *live, int *state)
+{
+  pthread_mutex_lock (&live->mutex);
+  *state = 1;
+  pthread_cond_signal (&live->cond);
+  pthread_mutex_unlock (&live->mutex);
+}
+
 static void
 vlc_event_callback (const libvlc_event_t *ev, void *data)
 {
   player_t *player = NULL;
   libvlc_event_type_t type;
+  vlc_t *vlc;
 
   player = (player_t *) data;
   if (!ev || !player)
     return;
 
+  vlc = player->priv;
+
   type = ev->type;
   switch (type)
   {
   case libvlc_MediaPlayerEndReached:
     pl_log (player, PLAYER_MSG_INFO,
             MODULE_NAME, "Playback of stream has ended");
+    vlc_live_set (&vlc->live, &vlc->live.done);
     player_event_send (player, PLAYER_EVENT_PLAYBACK_FINISHED);
 
     pl_window_unmap (player->window);
     break;
 
+  case libvlc_MediaPlayerEncounteredError:
+    pl_log (player, PLAYER_MSG_ERROR,
+            MODULE_NAME, "Playback of stream has failed");
+    vlc_live_set (&vlc->live, &vlc->live.done);
+    break;
+
   case libvlc_MediaPlayerPlaying:
+    vlc_live_set (&vlc->live, &vlc->live.playing);
+    break;
+
+  case libvlc_MediaPlayerVout:
+  {
+    int map;
+
+    vlc_live_set (&vlc->live, &vlc->live.vout);
+
+    /* the properties of the stream were not known by vlc_playback_start() */
+    pthread_mutex_lock (&vlc->live.mutex);
+    map = vlc->live_map;
+    vlc->live_map = 0;
+    pthread_mutex_unlock (&vlc->live.mutex);
+
+    if (map)
+      pl_window_map (player->window);
+    break;
+  }
+
   case libvlc_MediaPlayerPaused:
   case libvlc_MediaPlayerStopped:
     break;
@@ -249,16 +346,11 @@ vlc_resource_get_uri (mrl_t *mrl)
 /*****************************************************************************/
 
 static void
-vlc_identify_metadata (mrl_t *mrl, libvlc_media_player_t *mp)
+vlc_identify_metadata (mrl_t *mrl, libvlc_media_t *media)
 {
   mrl_metadata_t *meta;
-  libvlc_media_t *media;
 
-  if (!mp || !mrl || !mrl->meta)
-    return;
-
-  media = libvlc_media_player_get_media (mp);
-  if (!media)
+  if (!media || !mrl || !mrl->meta)
     return;
 
   meta = mrl->meta;
@@ -275,12 +367,11 @@ vlc_identify_metadata (mrl_t *mrl, libvlc_media_player_t *mp)
 }
 
 static void
-vlc_identify_audio (mrl_t *mrl,
-                    libvlc_media_player_t *mp, libvlc_media_track_info_t *es)
+vlc_identify_audio (mrl_t *mrl, libvlc_media_track_info_t *es)
 {
   mrl_properties_audio_t *audio;
 
-  if (!mrl || !mrl->prop || !mp || !es)
+  if (!mrl || !mrl->prop || !es)
     return;
 
   if (!mrl->prop->audio)
@@ -357,34 +448,203 @@ vlc_identify_video (mrl_t *mrl,
 }
 
 static void
-vlc_identify_properties (mrl_t *mrl, libvlc_media_player_t *mp)
+vlc_identify_properties (mrl_t *mrl,
+                         libvlc_media_player_t *mp, libvlc_media_t *media)
 {
+  libvlc_time_t length;
+
   if (!mrl || !mrl->prop || !mp)
     return;
 
   mrl->prop->seekable = libvlc_media_player_is_seekable (mp);
 
-  mrl->prop->length = (uint32_t) libvlc_media_player_get_length (mp);
+  /* the length is not always known by the media player before the end */
+  length = libvlc_media_player_get_length (mp);
+  if (length <= 0)
+    length = libvlc_media_get_duration (media);
+  if (length > 0)
+    mrl->prop->length = (uint32_t) length;
+}
+
+/*
+ * The media must be parsed by the caller. vlc_identify() has already waited
+ * for libvlc_media_parse_async(), a blocking parse is not done twice.
+ */
+static void
+vlc_identify_media (mrl_t *mrl, libvlc_media_player_t *mp,
+                    libvlc_media_t *media, int flags)
+{
+  libvlc_media_track_info_t *esv = NULL, *esa = NULL;
+  libvlc_media_track_info_t *es = NULL;
+  unsigned int i;
+  unsigned int es_count;
+
+  es_count = libvlc_media_get_tracks_info (media, &es);
+  for (i = 0; i < es_count; i++)
+  {
+    if (!esv && es[i].i_type == libvlc_track_video)
+      esv = es + i;
+    else if (!esa && es[i].i_type == libvlc_track_audio)
+      esa = es + i;
+  }
+
+  if (flags & IDENTIFY_VIDEO)
+    vlc_identify_video (mrl, mp, esv);
+
+  if (flags & IDENTIFY_AUDIO)
+    vlc_identify_audio (mrl, esa);
+
+  if (flags & IDENTIFY_METADATA)
+    vlc_identify_metadata (mrl, media);
+
+  if (flags & IDENTIFY_PROPERTIES)
+    vlc_identify_properties (mrl, mp, media);
+
+  PFREE (es);
+}
+
+static void
+vlc_probe_callback (const libvlc_event_t *ev, void *data)
+{
+  vlc_probe_t *probe = data;
+
+  if (!ev || !probe)
+    return;
+
+  pthread_mutex_lock (&probe->mutex);
+  switch (ev->type)
+  {
+  case libvlc_MediaParsedChanged:
+    probe->parsed = 1;
+    break;
+
+  case libvlc_MediaPlayerPlaying:
+    probe->playing = 1;
+    break;
+
+  case libvlc_MediaPlayerVout:
+    probe->vout = 1;
+    break;
+
+  case libvlc_MediaPlayerEncounteredError:
+  case libvlc_MediaPlayerEndReached:
+    probe->done = 1;
+    break;
+
+  default:
+    break;
+  }
+  pthread_cond_signal (&probe->cond);
+  pthread_mutex_unlock (&probe->mutex);
+}
+
+/* wait until *state is set by vlc_probe_callback() or the playback fails */
+static int
+vlc_probe_wait (vlc_probe_t *probe,
+                const int *state, const struct timespec *ts)
+{
+  int res = 0, ret;
+
+  pthread_mutex_lock (&probe->mutex);
+  while (!*state && !probe->done && !res)
+    res = pthread_cond_timedwait (&probe->cond, &probe->mutex, ts);
+  ret = *state;
+  pthread_mutex_unlock (&probe->mutex);
+
+  return ret;
+}
+
+static void
+vlc_probe_init (vlc_probe_t *probe)
+{
+  pthread_mutex_init (&probe->mutex, NULL);
+  pthread_cond_init (&probe->cond, NULL);
+}
+
+static void
+vlc_probe_uninit (vlc_probe_t *probe)
+{
+  if (probe->mp)
+  {
+    libvlc_media_player_stop (probe->mp);
+    libvlc_media_player_release (probe->mp);
+    probe->mp = NULL;
+  }
+  pthread_mutex_destroy (&probe->mutex);
+  pthread_cond_destroy (&probe->cond);
+}
+
+/* the media player is created once and kept for all the next probes */
+static libvlc_media_player_t *
+vlc_probe_mp (vlc_t *vlc, vlc_probe_t *probe)
+{
+  libvlc_event_manager_t *ev;
+  unsigned int i;
+
+  if (probe->mp)
+    return probe->mp;
+
+  probe->mp = libvlc_media_player_new (vlc->core);
+  if (!probe->mp)
+    return NULL;
+
+  ev = libvlc_media_player_event_manager (probe->mp);
+  if (ev)
+    for (i = 0; i < ARRAY_NB_ELEMENTS (probe_events); i++)
+      libvlc_event_attach (ev, probe_events[i], vlc_probe_callback, probe);
+
+  return probe->mp;
+}
+
+/*
+ * The probes are concurrent with mrl_probe_batch(). NULL is returned when
+ * all the probes of the pool are busy.
+ */
+static vlc_probe_t *
+vlc_probe_get (vlc_t *vlc)
+{
+  vlc_probe_t *probe = NULL;
+  int i;
+
+  pthread_mutex_lock (&vlc->probe_mutex);
+  for (i = 0; i < PROBE_POOL; i++)
+    if (!vlc->probe[i].busy)
+    {
+      probe = &vlc->probe[i];
+      probe->busy = 1;
+      break;
+    }
+  pthread_mutex_unlock (&vlc->probe_mutex);
+
+  return probe;
+}
+
+static void
+vlc_probe_release (vlc_t *vlc, vlc_probe_t *probe)
+{
+  pthread_mutex_lock (&vlc->probe_mutex);
+  probe->busy = 0;
+  pthread_mutex_unlock (&vlc->probe_mutex);
 }
 
 static void
 vlc_identify (player_t *player, mrl_t *mrl, int flags)
 {
-  libvlc_media_player_t *mp;
+  libvlc_media_player_t *mp = NULL;
   libvlc_media_t *media;
+  libvlc_event_manager_t *ev;
+  libvlc_media_track_info_t *es = NULL;
+  vlc_probe_t tmp, *probe;
+  struct timespec ts;
   char *uri = NULL;
   vlc_t *vlc;
   const char *options[] = {
     ":vout=dummy",
     ":aout=dummy",
-    ":sout=#description",
+    ":no-spu",
   };
-  libvlc_media_track_info_t *esv = NULL, *esa = NULL;
-  libvlc_media_track_info_t *es = NULL;
-  libvlc_state_t st = libvlc_NothingSpecial;
-  int wait = 0;
-  unsigned int i;
-  unsigned int es_count;
+  int video = 0;
+  unsigned int i, es_count;
 
   if (!player || !mrl)
     return;
@@ -397,10 +657,6 @@ vlc_identify (player_t *player, mrl_t *mrl, int flags)
   if (!uri)
     return;
 
-  mp = libvlc_media_player_new (vlc->core);
-  if (!mp)
-    goto err_mp;
-
   media = libvlc_media_new_location (vlc->core, uri);
   if (!media)
     goto err_media;
@@ -408,59 +664,432 @@ vlc_identify (player_t *player, mrl_t *mrl, int flags)
   for (i = 0; i < ARRAY_NB_ELEMENTS (options); i++)
     libvlc_media_add_option (media, options[i]);
 
-  libvlc_media_player_set_media (mp, media);
-  libvlc_media_player_play (mp);
+  /* a temporary probe is used when the pool is exhausted */
+  probe = vlc_probe_get (vlc);
+  if (!probe)
+  {
+    memset (&tmp, 0, sizeof (tmp));
+    vlc_probe_init (&tmp);
+    probe = &tmp;
+  }
+
+  pthread_mutex_lock (&probe->mutex);
+  probe->parsed  = 0;
+  probe->playing = 0;
+  probe->vout    = 0;
+  probe->done    = 0;
+  pthread_mutex_unlock (&probe->mutex);
+
+  ev = libvlc_media_event_manager (media);
+  if (ev)
+    libvlc_event_attach (ev, libvlc_MediaParsedChanged,
+                         vlc_probe_callback, probe);
 
   /*
-   * FIXME
-   * Most of time, vlc_identify() is unable to retrieve the properties
-   * because libvlc must be playing in order to read the informations.
-   * The code below waits that the Playing state begins, but it is not
-   * sufficient for many streams. It suggests that at least one frame
-   * or more must be decoded.
+   * The metadata and the tracks are given by the parser, but the length,
+   * the aspect ratio and the framerate are known only when the stream is
+   * decoded. Then the decoding runs while the media is parsed.
    */
-  while (st <= libvlc_Buffering)
-  {
-    st = libvlc_media_player_get_state (mp);
-    usleep (WAIT_PERIOD);
-    wait += WAIT_PERIOD;
-    if (wait >= WAIT_MAX)
-      break;
-  }
+  if (flags & (IDENTIFY_VIDEO | IDENTIFY_PROPERTIES))
+    mp = vlc_probe_mp (vlc, probe);
 
-  libvlc_media_parse (media);
-  es_count = libvlc_media_get_tracks_info (media, &es);
-  for (i = 0; i < es_count; i++)
+  if (mp)
   {
-    if (!esv && es[i].i_type == libvlc_track_video)
-      esv = es + i;
-    else if (!esa && es[i].i_type == libvlc_track_audio)
-      esa = es + i;
+    libvlc_media_player_set_media (mp, media);
+    libvlc_media_player_play (mp);
   }
 
-  if (flags & IDENTIFY_VIDEO)
-    vlc_identify_video (mrl, mp, esv);
+  libvlc_media_parse_async (media);
 
-  if (flags & IDENTIFY_AUDIO)
-    vlc_identify_audio (mrl, mp, esa);
+  clock_gettime (CLOCK_REALTIME, &ts);
+  ts.tv_sec += WAIT_MAX / 1000000;
 
-  if (flags & IDENTIFY_METADATA)
-    vlc_identify_metadata (mrl, mp);
+  if (!vlc_probe_wait (probe, &probe->parsed, &ts))
+    pl_log (player, PLAYER_MSG_WARNING,
+            MODULE_NAME, "parsing of %s has failed", uri);
 
-  if (flags & IDENTIFY_PROPERTIES)
-    vlc_identify_properties (mrl, mp);
+  if (mp)
+  {
+    es_count = libvlc_media_get_tracks_info (media, &es);
+    for (i = 0; i < es_count; i++)
+      if (es[i].i_type == libvlc_track_video)
+        video = 1;
+    PFREE (es);
+
+    /* the video output exists only when the first frame is decoded */
+    vlc_probe_wait (probe, video ? &probe->vout : &probe->playing, &ts);
+  }
+
+  vlc_identify_media (mrl, mp, media, flags);
 
-  libvlc_media_player_stop (mp);
+  if (mp)
+  {
+    libvlc_media_player_stop (mp);
+    libvlc_media_player_set_media (mp, NULL);
+  }
+
+  if (ev)
+    libvlc_event_detach (ev, libvlc_MediaParsedChanged,
+                         vlc_probe_callback, probe);
   libvlc_media_release (media);
 
-  PFREE (es);
+  if (probe == &tmp)
+    vlc_probe_uninit (probe);
+  else
+    vlc_probe_release (vlc, probe);
 
  err_media:
-  libvlc_media_player_release (mp);
- err_mp:
   PFREE (uri);
 }
 
+/*****************************************************************************/
+/*                          vlc off-screen snapshot                          */
+/*****************************************************************************/
+
+static void *
+vlc_snapshot_lock (void *data, void **planes)
+{
+  vlc_t *vlc = data;
+
+  *planes = vlc->snap_pixels;
+  return NULL;
+}
+
+static void
+vlc_snapshot_unlock (pl_unused void *data,
+                     pl_unused void *id, pl_unused void *const *planes)
+{
+}
+
+static void
+vlc_snapshot_display (void *data, pl_unused void *id)
+{
+  vlc_t *vlc = data;
+  libvlc_time_t time;
+
+  pthread_mutex_lock (&vlc->snap_mutex);
+
+  if (vlc->snap_target != SNAPSHOT_NONE)
+  {
+    /* the frames displayed before the seek are ignored */
+    time = libvlc_media_player_get_time (vlc->snap_mp);
+    if (vlc->snap_target == SNAPSHOT_ANY
+        || llabs (time - vlc->snap_target) <= SNAPSHOT_WINDOW)
+    {
+      memcpy (vlc->snap_frame, vlc->snap_pixels,
+              vlc->snap_width * vlc->snap_height * 3);
+      vlc->snap_target = SNAPSHOT_NONE;
+      pthread_cond_signal (&vlc->snap_cond);
+    }
+  }
+
+  pthread_mutex_unlock (&vlc->snap_mutex);
+}
+
+static void
+vlc_snapshot_expect (vlc_t *vlc, libvlc_time_t target)
+{
+  pthread_mutex_lock (&vlc->snap_mutex);
+  vlc->snap_target = target;
+  pthread_mutex_unlock (&vlc->snap_mutex);
+}
+
+/* wait for the frame copied by vlc_snapshot_display() */
+static int
+vlc_snapshot_wait (vlc_t *vlc)
+{
+  struct timespec ts;
+  int res = 0;
+
+  clock_gettime (CLOCK_REALTIME, &ts);
+  ts.tv_sec += WAIT_MAX / 1000000;
+
+  pthread_mutex_lock (&vlc->snap_mutex);
+  while (vlc->snap_target != SNAPSHOT_NONE && !res)
+    res = pthread_cond_timedwait (&vlc->snap_cond, &vlc->snap_mutex, &ts);
+  vlc->snap_target = SNAPSHOT_NONE;
+  pthread_mutex_unlock (&vlc->snap_mutex);
+
+  return res ? -1 : 0;
+}
+
+/* the media player must be stopped */
+static int
+vlc_snapshot_format (vlc_t *vlc, unsigned int width, unsigned int height)
+{
+  PFREE (vlc->snap_pixels);
+  PFREE (vlc->snap_frame);
+
+  vlc->snap_pixels = malloc (width * height * 3);
+  vlc->snap_frame  = malloc (width * height * 3);
+  if (!vlc->snap_pixels || !vlc->snap_frame)
+    return -1;
+
+  vlc->snap_width  = width;
+  vlc->snap_height = height;
+  libvlc_video_set_format (vlc->snap_mp, "RV24", width, height, width * 3);
+  return 0;
+}
+
+static int
+vlc_snapshot_play (vlc_t *vlc, int pos, libvlc_time_t target)
+{
+  libvlc_media_t *media;
+  char start[32];
+  const char *options[] = {
+    ":video",
+    ":no-audio",
+    ":no-spu",
+    start,
+  };
+  unsigned int i;
+
+  media = libvlc_media_new_location (vlc->core, vlc->snap_uri);
+  if (!media)
+    return -1;
+
+  snprintf (start, sizeof (start), ":start-time=%i", pos);
+  for (i = 0; i < ARRAY_NB_ELEMENTS (options); i++)
+    libvlc_media_add_option (media, options[i]);
+
+  libvlc_media_player_set_media (vlc->snap_mp, media);
+  libvlc_media_release (media);
+
+  vlc_snapshot_expect (vlc, target);
+  return libvlc_media_player_play (vlc->snap_mp);
+}
+
+/*
+ * The frames are decoded by a dedicated media player with the vmem video
+ * output, the playback is not disturbed. This media player is paused on the
+ * frame between the snapshots, then only a seek is necessary for the next
+ * position of the same URI.
+ */
+static uint8_t *
+vlc_snapshot_frame (player_t *player, mrl_t *mrl, int pos,
+                    unsigned int *width, unsigned int *height)
+{
+  vlc_t *vlc = player->priv;
+  libvlc_time_t target = (libvlc_time_t) pos * 1000;
+  libvlc_state_t st;
+  uint8_t *rgb;
+  char *uri;
+
+  if (!vlc->snap_mp)
+  {
+    vlc->snap_mp = libvlc_media_player_new (vlc->core);
+    if (!vlc->snap_mp)
+      return NULL;
+
+    libvlc_video_set_callbacks (vlc->snap_mp, vlc_snapshot_lock,
+                                vlc_snapshot_unlock, vlc_snapshot_display,
+                                vlc);
+  }
+
+  uri = vlc_resource_get_uri (mrl);
+  if (!uri)
+    return NULL;
+
+  st = libvlc_media_player_get_state (vlc->snap_mp);
+
+  if (vlc->snap_uri && !strcmp (vlc->snap_uri, uri)
+      && (st == libvlc_Playing || st == libvlc_Paused))
+  {
+    PFREE (uri);
+    vlc_snapshot_expect (vlc, target);
+    libvlc_media_player_set_time (vlc->snap_mp, target);
+    if (st == libvlc_Paused)
+      libvlc_media_player_pause (vlc->snap_mp); /* resume */
+  }
+  else
+  {
+    unsigned int w = 0, h = 0;
+
+    libvlc_media_player_stop (vlc->snap_mp);
+    PFREE (vlc->snap_uri);
+    vlc->snap_uri = uri;
+
+    if (mrl->prop && mrl->prop->video)
+    {
+      w = mrl->prop->video->width;
+      h = mrl->prop->video->height;
+    }
+
+    /* unknown size, one frame is decoded in order to retrieve it */
+    if (!w || !h)
+    {
+      if (vlc_snapshot_format (vlc, 16, 16)
+          || vlc_snapshot_play (vlc, pos, SNAPSHOT_ANY)
+          || vlc_snapshot_wait (vlc)
+          || libvlc_video_get_size (vlc->snap_mp, 0, &w, &h) || !w || !h)
+        goto err;
+
+      libvlc_media_player_stop (vlc->snap_mp);
+    }
+
+    if (vlc_snapshot_format (vlc, w, h) || vlc_snapshot_play (vlc, pos, target))
+      goto err;
+  }
+
+  if (vlc_snapshot_wait (vlc))
+    goto err;
+
+  /* ready for the next position */
+  if (libvlc_media_player_can_pause (vlc->snap_mp))
+    libvlc_media_player_pause (vlc->snap_mp);
+  else
+  {
+    libvlc_media_player_stop (vlc->snap_mp);
+    PFREE (vlc->snap_uri);
+  }
+
+  rgb = malloc (vlc->snap_width * vlc->snap_height * 3);
+  if (!rgb)
+    return NULL;
+
+  memcpy (rgb, vlc->snap_frame, vlc->snap_width * vlc->snap_height * 3);
+  *width  = vlc->snap_width;
+  *height = vlc->snap_height;
+  return rgb;
+
+ err:
+  pl_log (player, PLAYER_MSG_WARNING, MODULE_NAME,
+          "frame at %is is unavailable, maybe VLC can't seek in %s",
+          pos, vlc->snap_uri);
+  libvlc_media_player_stop (vlc->snap_mp);
+  PFREE (vlc->snap_uri);
+  return NULL;
+}
+
+/*****************************************************************************/
+/*                     vlc decoded frames (PLAYER_VO_FRAMES)                 */
+/*****************************************************************************/
+
+/*
+ * The pictures given to vmem are the buffers of the frame ring, then the
+ * frames are written by VLC directly where the frontend reads them.
+ */
+static unsigned
+vlc_frame_format (void **data, char *chroma,
+                  unsigned *width, unsigned *height,
+                  unsigned *pitches, unsigned *lines)
+{
+  player_t *player = *data;
+  vlc_t *vlc = player->priv;
+  int stride[3];
+  size_t offset[3];
+  size_t size;
+  int i;
+
+  size = pl_frame_layout (PLAYER_FRAME_I420, *width, *height, stride, offset);
+  if (!size)
+    return 0;
+
+  memcpy (chroma, "I420", 4);
+  for (i = 0; i < 3; i++)
+  {
+    pitches[i] = stride[i];
+    lines[i]   = i ? (*height + 1) / 2 : *height;
+  }
+
+  /* the frames are decoded here when the ring is full */
+  PFREE (vlc->frame_drop);
+  vlc->frame_drop = malloc (size);
+  if (!vlc->frame_drop)
+    return 0;
+
+  vlc->frame_width  = *width;
+  vlc->frame_height = *height;
+  return 1;
+}
+
+static void
+vlc_frame_cleanup (void *data)
+{
+  player_t *player = data;
+  vlc_t *vlc = player->priv;
+
+  pl_frame_ring_cancel (player->frames, vlc->frame);
+  vlc->frame = NULL;
+  PFREE (vlc->frame_drop);
+}
+
+static void *
+vlc_frame_lock (void *data, void **planes)
+{
+  player_t *player = data;
+  vlc_t *vlc = player->priv;
+  player_frame_t *frame;
+  int stride[3];
+  size_t offset[3];
+  int i;
+
+  /* the previous picture was not displayed (late) */
+  pl_frame_ring_cancel (player->frames, vlc->frame);
+
+  frame = pl_frame_ring_acquire (player->frames, PLAYER_FRAME_I420,
+                                 vlc->frame_width, vlc->frame_height);
+  if (frame)
+    for (i = 0; i < 3; i++)
+      planes[i] = frame->plane[i];
+  else
+  {
+    pl_frame_layout (PLAYER_FRAME_I420,
+                     vlc->frame_width, vlc->frame_height, stride, offset);
+    for (i = 0; i < 3; i++)
+      planes[i] = vlc->frame_drop + offset[i];
+  }
+
+  vlc->frame = frame;
+  return frame;
+}
+
+static void
+vlc_frame_display (void *data, void *id)
+{
+  player_t *player = data;
+  vlc_t *vlc = player->priv;
+  player_frame_t *frame = id;
+
+  if (!frame || frame != vlc->frame)
+    return;
+
+  frame->pts = libvlc_media_player_get_time (vlc->mp);
+  pl_frame_ring_publish (player->frames, frame);
+  vlc->frame = NULL;
+}
+
+/*****************************************************************************/
+/*                          vlc audio tap (amem)                             */
+/*****************************************************************************/
+
+static int
+vlc_audio_setup (void **data, char *format,
+                 unsigned *rate, unsigned *channels)
+{
+  player_t *player = *data;
+  vlc_t *vlc = player->priv;
+
+  /* the samples are converted by VLC */
+  memcpy (format, "S16N", 4);
+  vlc->tap_rate     = *rate;
+  vlc->tap_channels = *channels;
+  return 0;
+}
+
+static void
+vlc_audio_play (void *data, const void *samples,
+                unsigned count, pl_unused int64_t pts)
+{
+  player_t *player = data;
+  vlc_t *vlc = player->priv;
+
+  /* pts is the date of the output, not the time in the stream */
+  pl_audio_tap_push (player->audio_tap, samples, count,
+                     vlc->tap_channels, vlc->tap_rate,
+                     libvlc_media_player_get_time (vlc->mp));
+}
+
 /*****************************************************************************/
 /*                         vlc private functions                             */
 /*****************************************************************************/
@@ -525,6 +1154,10 @@ vlc_init (player_t *player)
     use_x11 = 1;
     break;
 
+  /* vmem, see vlc_frame_lock() */
+  case PLAYER_VO_FRAMES:
+    break;
+
   default:
     return PLAYER_INIT_ERROR;
   }
@@ -533,7 +1166,9 @@ vlc_init (player_t *player)
   switch (player->ao)
   {
   case PLAYER_AO_NULL:
-    vlc_argv[vlc_argc++] = "--no-audio";
+    /* the audio tap needs the audio */
+    if (!player->audio_tap)
+      vlc_argv[vlc_argc++] = "--no-audio";
     break;
 
   case PLAYER_AO_ALSA:
@@ -589,6 +1224,27 @@ vlc_init (player_t *player)
   if (winid)
     libvlc_media_player_set_xwindow (vlc->mp, winid);
 
+  if (player->vo == PLAYER_VO_FRAMES)
+  {
+    libvlc_video_set_callbacks (vlc->mp, vlc_frame_lock,
+                                NULL, vlc_frame_display, player);
+    libvlc_video_set_format_callbacks (vlc->mp,
+                                       vlc_frame_format, vlc_frame_cleanup);
+  }
+
+  /*
+   * amem replaces the audio output, libvlc has no way to keep the output
+   * with the callbacks.
+   */
+  if (player->audio_tap)
+  {
+    pl_log (player, PLAYER_MSG_WARNING, MODULE_NAME,
+            "the audio tap replaces the audio output, nothing is heard");
+    libvlc_audio_set_callbacks (vlc->mp, vlc_audio_play,
+                                NULL, NULL, NULL, NULL, player);
+    libvlc_audio_set_format_callbacks (vlc->mp, vlc_audio_setup, NULL);
+  }
+
   libvlc_video_set_key_input   (vlc->mp, 0);
   libvlc_video_set_mouse_input (vlc->mp, 0);
 
@@ -609,6 +1265,7 @@ vlc_uninit (player_t *player)
 {
   vlc_t *vlc = NULL;
   libvlc_media_t *media;
+  int i;
 
   pl_log (player, PLAYER_MSG_INFO, MODULE_NAME, "uninit");
 
@@ -627,6 +1284,22 @@ vlc_uninit (player_t *player)
       libvlc_media_release (media);
     libvlc_media_player_release (vlc->mp);
   }
+  if (vlc->snap_mp)
+  {
+    libvlc_media_player_stop (vlc->snap_mp);
+    libvlc_media_player_release (vlc->snap_mp);
+  }
+  PFREE (vlc->snap_uri);
+  PFREE (vlc->snap_pixels);
+  PFREE (vlc->snap_frame);
+  PFREE (vlc->frame_drop);
+  pthread_mutex_destroy (&vlc->snap_mutex);
+  pthread_cond_destroy (&vlc->snap_cond);
+  for (i = 0; i < PROBE_POOL; i++)
+    vlc_probe_uninit (&vlc->probe[i]);
+  pthread_mutex_destroy (&vlc->probe_mutex);
+  vlc_probe_uninit (&vlc->live);
+
   if (vlc->core)
     libvlc_release (vlc->core);
 
@@ -671,31 +1344,55 @@ vlc_set_verbosity (player_t *player, player_verbosity_level_t level)
     libvlc_set_log_verbosity (vlc->core, verbosity);
 }
 
-static void
-vlc_mrl_retrieve_properties (player_t *player, mrl_t *mrl)
+static int
+vlc_mrl_flags (mrl_t *mrl)
 {
-  pl_log (player, PLAYER_MSG_VERBOSE, MODULE_NAME, "mrl_retrieve_properties");
+  int flags = 0;
 
-  if (!player || !mrl || !mrl->prop)
-    return;
-
-  /* now fetch properties */
-  if (mrl->resource == MRL_RESOURCE_FILE)
+  if (mrl->prop)
   {
-    mrl_resource_local_args_t *args = mrl->priv;
-    if (args && args->location)
+    flags |= IDENTIFY_AUDIO | IDENTIFY_VIDEO | IDENTIFY_PROPERTIES;
+
+    if (mrl->resource == MRL_RESOURCE_FILE)
     {
-      const char *location = args->location;
+      mrl_resource_local_args_t *args = mrl->priv;
+      if (args && args->location)
+      {
+        const char *location = args->location;
 
-      if (strstr (location, "file:") == location)
-        location += 5;
+        if (strstr (location, "file:") == location)
+          location += 5;
 
-      mrl->prop->size = pl_file_size (location);
+        mrl->prop->size = pl_file_size (location);
+      }
     }
   }
 
-  vlc_identify (player, mrl,
-                IDENTIFY_AUDIO | IDENTIFY_VIDEO | IDENTIFY_PROPERTIES);
+  if (mrl->meta)
+    flags |= IDENTIFY_METADATA;
+
+  return flags;
+}
+
+/*
+ * The properties and the metadata are retrieved with the same media player,
+ * in order to avoid decoding twice the same stream.
+ */
+static void
+vlc_mrl_retrieve (player_t *player, mrl_t *mrl)
+{
+  vlc_identify (player, mrl, vlc_mrl_flags (mrl));
+}
+
+static void
+vlc_mrl_retrieve_properties (player_t *player, mrl_t *mrl)
+{
+  pl_log (player, PLAYER_MSG_VERBOSE, MODULE_NAME, "mrl_retrieve_properties");
+
+  if (!player || !mrl || !mrl->prop)
+    return;
+
+  vlc_mrl_retrieve (player, mrl);
 }
 
 static void
@@ -706,57 +1403,166 @@ vlc_mrl_retrieve_metadata (player_t *player, mrl_t *mrl)
   if (!player || !mrl || !mrl->meta)
     return;
 
-  vlc_identify (player, mrl, IDENTIFY_METADATA);
+  vlc_mrl_retrieve (player, mrl);
 }
 
-static void
-vlc_mrl_video_snapshot (player_t *player, mrl_t *mrl, pl_unused int pos,
-                        pl_unused mrl_snapshot_t t, const char *dst)
+/*
+ * The media of the player is used instead of a new media player, then the
+ * stream is not opened and decoded a second time. The input of the player
+ * gives the tracks once it is playing, the media is not parsed.
+ */
+static int
+vlc_mrl_retrieve_live (player_t *player, mrl_t *mrl)
 {
   vlc_t *vlc;
-  unsigned int width, height;
-  libvlc_media_track_info_t *es = NULL;
-  libvlc_media_track_info_t *esv = NULL;
   libvlc_media_t *media;
-  unsigned int es_count;
-  unsigned int i;
+  int playing;
 
-  pl_log (player, PLAYER_MSG_VERBOSE, MODULE_NAME, "mrl_video_snapshot");
+  pl_log (player, PLAYER_MSG_VERBOSE, MODULE_NAME, "mrl_retrieve_live");
 
-  if (!player || !mrl || !mrl->meta)
-    return;
+  if (!player || !mrl)
+    return 0;
 
   vlc = player->priv;
-  if (!vlc || !vlc->mp)
-    return;
+  if (!vlc || !vlc->mp || vlc->live_mrl != mrl)
+    return 0;
+
+  /* the tracks, the length and the video are not known before */
+  pthread_mutex_lock (&vlc->live.mutex);
+  playing = vlc->live.playing && !vlc->live.done;
+  pthread_mutex_unlock (&vlc->live.mutex);
+  if (!playing)
+    return 0;
 
   media = libvlc_media_player_get_media (vlc->mp);
   if (!media)
-    return;
+    return 0;
 
-  /*
-   * FIXME
-   * Like vlc_identify and according to the documentation of libvlc, the media
-   * must be played at least one time, else ES array will be empty.
-   */
-  es_count = libvlc_media_get_tracks_info (media, &es);
-  for (i = 0; i < es_count; i++)
-    if (es[i].i_type == libvlc_track_video)
-    {
-      esv = es + i;
+  vlc_identify_media (mrl, vlc->mp, media, vlc_mrl_flags (mrl));
+  libvlc_media_release (media);
+  return 1;
+}
+
+static int
+vlc_mrl_video_snapshot_buffer (player_t *player, mrl_t *mrl, int pos,
+                               mrl_snapshot_t t, mrl_snapshot_buffer_t *buf)
+{
+  vlc_t *vlc;
+  uint8_t *rgb;
+  unsigned int width, height;
+
+  pl_log (player, PLAYER_MSG_VERBOSE,
+          MODULE_NAME, "mrl_video_snapshot_buffer");
+
+  if (!player || !mrl || !buf)
+    return 0;
+
+  vlc = player->priv;
+  if (!vlc || !vlc->core)
+    return 0;
+
+  switch (t)
+  {
+  case MRL_SNAPSHOT_PNG:
+  case MRL_SNAPSHOT_PPM:
+  case MRL_SNAPSHOT_RGB24:
+    break;
+
+  default:
+    pl_log (player, PLAYER_MSG_WARNING,
+            MODULE_NAME, "unsupported snapshot type (%i)", t);
+    return 0;
+  }
+
+  rgb = vlc_snapshot_frame (player, mrl, pos, &width, &height);
+  if (!rgb)
+    return 0;
+
+  switch (t)
+  {
+  /* encoded by libvlc, the media player is paused on the frame */
+  case MRL_SNAPSHOT_PNG:
+  {
+    char tmp[] = "/tmp/libplayer.XXXXXX";
+    char file[64];
+
+    if (!mkdtemp (tmp))
       break;
-    }
 
-  if (!esv)
-    goto out;
+    snprintf (file, sizeof (file), "%s/snapshot.png", tmp);
+    if (!libvlc_video_take_snapshot (vlc->snap_mp, 0, file, width, height))
+      buf->data = pl_read_file (file, &buf->size);
 
-  width  = esv->u.video.i_width;
-  height = esv->u.video.i_height;
+    unlink (file);
+    rmdir (tmp);
+    break;
+  }
 
-  libvlc_video_take_snapshot (vlc->mp, 0, dst, width, height);
+  case MRL_SNAPSHOT_PPM:
+  {
+    char header[32];
+    size_t size;
 
- out:
-  PFREE (es);
+    size = snprintf (header, sizeof (header), "P6\n%u %u\n255\n",
+                     width, height);
+    buf->data = malloc (size + width * height * 3);
+    if (!buf->data)
+      break;
+
+    memcpy (buf->data, header, size);
+    memcpy (buf->data + size, rgb, width * height * 3);
+    buf->size = size + width * height * 3;
+    break;
+  }
+
+  default:
+    buf->data   = rgb;
+    buf->size   = width * height * 3;
+    buf->width  = width;
+    buf->height = height;
+    buf->stride = width * 3;
+    rgb = NULL;
+    break;
+  }
+
+  PFREE (rgb);
+  buf->type = t;
+  return buf->data ? 1 : 0;
+}
+
+static void
+vlc_mrl_video_snapshot (player_t *player, mrl_t *mrl,
+                        int pos, mrl_snapshot_t t, const char *dst)
+{
+  mrl_snapshot_buffer_t buf;
+
+  pl_log (player, PLAYER_MSG_VERBOSE, MODULE_NAME, "mrl_video_snapshot");
+
+  if (!player || !mrl)
+    return;
+
+  if (t != MRL_SNAPSHOT_PNG && t != MRL_SNAPSHOT_PPM)
+  {
+    pl_log (player, PLAYER_MSG_WARNING,
+            MODULE_NAME, "unsupported snapshot type (%i)", t);
+    return;
+  }
+
+  memset (&buf, 0, sizeof (buf));
+  if (!vlc_mrl_video_snapshot_buffer (player, mrl, pos, t, &buf))
+    return;
+
+  /* use the current directory? */
+  if (!dst)
+    dst = t == MRL_SNAPSHOT_PNG ? "snapshot.png" : "snapshot.ppm";
+
+  if (!pl_write_file (dst, buf.data, buf.size))
+    pl_log (player, PLAYER_MSG_INFO, MODULE_NAME, "snapshot saved to %s", dst);
+  else
+    pl_log (player, PLAYER_MSG_ERROR,
+            MODULE_NAME, "unable to write the snapshot to %s", dst);
+
+  PFREE (buf.data);
 }
 
 static int
@@ -805,6 +1611,7 @@ vlc_playback_start (player_t *player)
   mrl_t *mrl;
   char *uri = NULL;
   libvlc_media_t *media = NULL;
+  int deferred;
 
   pl_log (player, PLAYER_MSG_VERBOSE, MODULE_NAME, "playback_start");
 
@@ -833,10 +1640,26 @@ vlc_playback_start (player_t *player)
   if (!media)
     return PLAYER_PB_ERROR;
 
-  if (MRL_USES_VO (mrl))
-    pl_window_map (player->window);
+  /*
+   * The properties deferred by mrl_sv_new() are read from the engine only
+   * once the stream is decoded, by the getters (see vlc_mrl_retrieve_live()).
+   * Without them, the window is mapped when VLC creates the video output.
+   */
+  deferred = !(mrl->facets & IDENTIFY_PROPERTIES);
+
+  pthread_mutex_lock (&vlc->live.mutex);
+  vlc->live.playing = 0;
+  vlc->live.vout    = 0;
+  vlc->live.done    = 0;
+  vlc->live_map     = deferred;
+  pthread_mutex_unlock (&vlc->live.mutex);
 
   libvlc_media_player_set_media (vlc->mp, media);
+  vlc->live_mrl = mrl;
+
+  if (!deferred && MRL_USES_VO (mrl))
+    pl_window_map (player->window);
+
   libvlc_media_player_play (vlc->mp);
 
   return PLAYER_PB_OK;
@@ -858,13 +1681,19 @@ vlc_playback_stop (player_t *player)
   if (!vlc || !vlc->mp)
     return;
 
+  pthread_mutex_lock (&vlc->live.mutex);
+  vlc->live_map = 0;
+  pthread_mutex_unlock (&vlc->live.mutex);
+
   mrl = pl_playlist_get_mrl (player->playlist);
-  if (MRL_USES_VO (mrl))
+  /* maybe mapped with the vout when the properties are still unknown */
+  if (MRL_USES_VO (mrl) || (mrl && !(mrl->facets & IDENTIFY_PROPERTIES)))
     pl_window_unmap (player->window);
 
   media = libvlc_media_player_get_media (vlc->mp);
   libvlc_media_player_stop (vlc->mp);
   libvlc_media_release (media);
+  vlc->live_mrl = NULL;
 }
 
 static playback_status_t
@@ -1261,7 +2090,10 @@ pl_register_functions_vlc (void)
 
   funcs->mrl_retrieve_props = vlc_mrl_retrieve_properties;
   funcs->mrl_retrieve_meta  = vlc_mrl_retrieve_metadata;
+  funcs->mrl_retrieve_live  = vlc_mrl_retrieve_live;
   funcs->mrl_video_snapshot = vlc_mrl_video_snapshot;
+  funcs->mrl_video_snapshot_buffer = vlc_mrl_video_snapshot_buffer;
+  funcs->mrl_video_snapshot_batch = NULL;
 
   funcs->get_time_pos       = vlc_get_time_pos;
   funcs->get_percent_pos    = vlc_get_percent_pos;
@@ -1276,6 +2108,9 @@ pl_register_functions_vlc (void)
   funcs->pb_seek            = vlc_playback_seek;
   funcs->pb_seek_chapter    = vlc_playback_seek_chapter;
   funcs->pb_set_speed       = vlc_playback_set_speed;
+  funcs->pb_preload         = NULL;
+  funcs->pb_gapless         = NULL;
+  funcs->pb_prepare         = NULL;
 
   funcs->audio_get_volume   = vlc_audio_get_volume;
   funcs->audio_set_volume   = vlc_audio_set_volume;
@@ -1324,10 +2159,19 @@ void *
 pl_register_private_vlc (void)
 {
   vlc_t *vlc = NULL;
+  int i;
 
   vlc = PCALLOC (vlc_t, 1);
   if (!vlc)
     return NULL;
 
+  vlc->snap_target = SNAPSHOT_NONE;
+  pthread_mutex_init (&vlc->snap_mutex, NULL);
+  pthread_cond_init (&vlc->snap_cond, NULL);
+  pthread_mutex_init (&vlc->probe_mutex, NULL);
+  for (i = 0; i < PROBE_POOL; i++)
+    vlc_probe_init (&vlc->probe[i]);
+  vlc_probe_init (&vlc->live);
+
   return vlc;
 }
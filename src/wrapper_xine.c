@@ -26,6 +26,7 @@
 #include <inttypes.h>
 #include <unistd.h>
 #include <math.h>
+#include <pthread.h>
 
 #include <xine.h>
 
@@ -37,10 +38,26 @@
 #include "fs_utils.h"
 #include "parse_utils.h"
 #include "window.h"
+#include "frame_ring.h"
 #include "wrapper_xine.h"
 
 #define MODULE_NAME "xine"
 
+#define SNAPSHOT_POOL     2     /* grab streams kept between the snapshots */
+#define SNAPSHOT_TIMEOUT  5000  /* ms */
+#define PROBE_POOL        2     /* streams kept for the identification */
+
+typedef struct xine_snapshot_s {
+  xine_stream_t *stream;
+  char *uri;            /* opened URI */
+  unsigned int stamp;   /* last use */
+} xine_snapshot_t;
+
+typedef struct xine_probe_s {
+  xine_stream_t *stream;
+  int busy;
+} xine_probe_t;
+
 /* player specific structure */
 typedef struct xine_player_s {
   xine_t *xine;
@@ -48,8 +65,28 @@ typedef struct xine_player_s {
   xine_event_queue_t *event_queue;
   xine_video_port_t *vo_port;
   xine_audio_port_t *ao_port;
+  mrl_t *live_mrl;      /* MRL opened in the stream */
+
+  /* gapless playback, next MRL opened in a standby stream */
+  xine_stream_t *standby;
+  xine_event_queue_t *standby_queue;
+  mrl_t *standby_mrl;
 
   int mouse_x, mouse_y; /* mouse coord set by xine_player_set_mouse_pos() */
+
+  /* snapshots, see xine_snapshot_get() */
+  xine_video_port_t *snapshot_vo;
+  xine_audio_port_t *snapshot_ao;
+  xine_snapshot_t snapshot[SNAPSHOT_POOL];
+  unsigned int snapshot_stamp;
+
+  /* identification, see xine_probe_get() */
+  pthread_mutex_t mutex_probe;
+  xine_video_port_t *probe_vo;
+  xine_audio_port_t *probe_ao;
+  xine_probe_t probe[PROBE_POOL];
+
+  raw_visual_t raw_visual; /* decoded frames, see xine_frame_cb() */
 } xine_player_t;
 
 
@@ -67,11 +104,15 @@ xine_player_event_listener_cb (void *user_data, const xine_event_t *event)
   {
   case XINE_EVENT_UI_PLAYBACK_FINISHED:
   {
+    xine_player_t *x = player->priv;
+
     pl_log (player, PLAYER_MSG_INFO,
             MODULE_NAME, "Playback of stream has ended");
     player_event_send (player, PLAYER_EVENT_PLAYBACK_FINISHED);
 
-    pl_window_unmap (player->window);
+    /* the standby stream will continue (gapless) */
+    if (!player->gapless || !x->standby)
+      pl_window_unmap (player->window);
     break;
   }
   case XINE_EVENT_PROGRESS:
@@ -106,6 +147,23 @@ send_event (player_t *player, int event, void *data, int data_size)
   xine_event_send (x->stream, &xine_event);
 }
 
+static void
+xine_player_standby_close (xine_player_t *x)
+{
+  if (x->standby)
+  {
+    xine_close (x->standby);
+    xine_dispose (x->standby);
+  }
+
+  if (x->standby_queue)
+    xine_event_dispose_queue (x->standby_queue);
+
+  x->standby       = NULL;
+  x->standby_queue = NULL;
+  x->standby_mrl   = NULL;
+}
+
 static char *
 xi_resource_get_uri_local (const char *protocol,
                            mrl_resource_local_args_t *args)
@@ -464,13 +522,97 @@ xine_identify_properties (mrl_t *mrl, xine_stream_t *stream)
     mrl->prop->length = length;
 }
 
+static void
+xine_identify_stream (mrl_t *mrl, xine_stream_t *stream, int flags)
+{
+  if (flags & IDENTIFY_VIDEO)
+    xine_identify_video (mrl, stream);
+
+  if (flags & IDENTIFY_AUDIO)
+    xine_identify_audio (mrl, stream);
+
+  if (flags & IDENTIFY_METADATA)
+    xine_identify_metadata (mrl, stream);
+
+  if (flags & IDENTIFY_PROPERTIES)
+    xine_identify_properties (mrl, stream);
+}
+
+/*
+ * The streams of the pool are created with the player on the null ports,
+ * and they are only closed between two MRLs. NULL is returned when all the
+ * streams are busy (concurrent probes with mrl_probe_batch()).
+ */
+static xine_probe_t *
+xine_probe_get (xine_player_t *x)
+{
+  xine_probe_t *p = NULL;
+  int i;
+
+  pthread_mutex_lock (&x->mutex_probe);
+  for (i = 0; i < PROBE_POOL; i++)
+    if (x->probe[i].stream && !x->probe[i].busy)
+    {
+      p = &x->probe[i];
+      p->busy = 1;
+      break;
+    }
+  pthread_mutex_unlock (&x->mutex_probe);
+
+  return p;
+}
+
+static void
+xine_probe_release (xine_player_t *x, xine_probe_t *p)
+{
+  pthread_mutex_lock (&x->mutex_probe);
+  p->busy = 0;
+  pthread_mutex_unlock (&x->mutex_probe);
+}
+
+static void
+xine_probe_open (xine_player_t *x)
+{
+  int i;
+
+  x->probe_ao = xine_open_audio_driver (x->xine, "none", NULL);
+  x->probe_vo =
+    xine_open_video_driver (x->xine, "none", XINE_VISUAL_TYPE_NONE, NULL);
+  if (!x->probe_ao || !x->probe_vo)
+    return;
+
+  for (i = 0; i < PROBE_POOL; i++)
+    x->probe[i].stream = xine_stream_new (x->xine, x->probe_ao, x->probe_vo);
+}
+
+static void
+xine_probe_close (xine_player_t *x)
+{
+  int i;
+
+  for (i = 0; i < PROBE_POOL; i++)
+    if (x->probe[i].stream)
+    {
+      xine_dispose (x->probe[i].stream);
+      x->probe[i].stream = NULL;
+    }
+
+  if (x->probe_vo)
+    xine_close_video_driver (x->xine, x->probe_vo);
+  if (x->probe_ao)
+    xine_close_audio_driver (x->xine, x->probe_ao);
+  x->probe_vo = NULL;
+  x->probe_ao = NULL;
+}
+
 static void
 xine_identify (player_t *player, mrl_t *mrl, int flags)
 {
   xine_player_t *x;
+  xine_probe_t *p;
   xine_stream_t *stream;
-  xine_video_port_t *vo;
-  xine_audio_port_t *ao;
+  xine_video_port_t *vo = NULL;
+  xine_audio_port_t *ao = NULL;
   char *uri = NULL;
 
   if (!player || !mrl)
@@ -485,43 +627,334 @@ xine_identify (player_t *player, mrl_t *mrl, int flags)
   if (!uri)
     return;
 
-  ao = xine_open_audio_driver (x->xine, "none", NULL);
-
-  if (!ao)
-    goto err_ao;
-
-  vo = xine_open_video_driver (x->xine, "none", XINE_VISUAL_TYPE_NONE, NULL);
+  p = xine_probe_get (x);
+  if (p)
+    stream = p->stream;
+  else /* all the streams of the pool are busy, use a temporary one */
+  {
+    ao = xine_open_audio_driver (x->xine, "none", NULL);
+    if (!ao)
+      goto err_ao;
 
-  if (!vo)
-    goto err_vo;
+    vo = xine_open_video_driver (x->xine, "none", XINE_VISUAL_TYPE_NONE, NULL);
+    if (!vo)
+      goto err_vo;
 
-  stream = xine_stream_new (x->xine, ao, vo);
+    stream = xine_stream_new (x->xine, ao, vo);
+  }
 
   if (stream)
   {
+    /*
+     * Only the headers are read because the stream is never played. The
+     * decoders are not needed for the metadata.
+     */
+    xine_set_param (stream, XINE_PARAM_IGNORE_VIDEO,
+                    !(flags & IDENTIFY_VIDEO));
+    xine_set_param (stream, XINE_PARAM_IGNORE_AUDIO,
+                    !(flags & IDENTIFY_AUDIO));
+
     xine_open (stream, uri);
+    xine_identify_stream (mrl, stream, flags);
 
-    if (flags & IDENTIFY_VIDEO)
-      xine_identify_video (mrl, stream);
+    xine_close (stream);
+    if (!p)
+      xine_dispose (stream);
+  }
+
+  if (p)
+    xine_probe_release (x, p);
 
-    if (flags & IDENTIFY_AUDIO)
-      xine_identify_audio (mrl, stream);
+  if (vo)
+    xine_close_video_driver (x->xine, vo);
+ err_vo:
+  if (ao)
+    xine_close_audio_driver (x->xine, ao);
+ err_ao:
+  PFREE (uri);
+}
 
-    if (flags & IDENTIFY_METADATA)
-      xine_identify_metadata (mrl, stream);
+/*****************************************************************************/
+/*                               xine snapshot                               */
+/*****************************************************************************/
 
-    if (flags & IDENTIFY_PROPERTIES)
-      xine_identify_properties (mrl, stream);
+static void
+xine_snapshot_close (xine_player_t *x)
+{
+  int i;
 
-    xine_close (stream);
-    xine_dispose (stream);
+  for (i = 0; i < SNAPSHOT_POOL; i++)
+  {
+    xine_snapshot_t *s = &x->snapshot[i];
+
+    if (s->stream)
+    {
+      xine_close (s->stream);
+      xine_dispose (s->stream);
+      s->stream = NULL;
+    }
+    PFREE (s->uri);
   }
 
-  xine_close_video_driver (x->xine, vo);
- err_vo:
-  xine_close_audio_driver (x->xine, ao);
- err_ao:
+  if (x->snapshot_vo)
+    xine_close_video_driver (x->xine, x->snapshot_vo);
+  if (x->snapshot_ao)
+    xine_close_audio_driver (x->xine, x->snapshot_ao);
+  x->snapshot_vo = NULL;
+  x->snapshot_ao = NULL;
+}
+
+/*
+ * The grab streams (on null ports) stay opened between the snapshots. The
+ * stream of the same URI is reused, then only a seek is necessary for the
+ * next position, else the least recently used stream is opened again.
+ */
+static xine_snapshot_t *
+xine_snapshot_get (player_t *player, mrl_t *mrl)
+{
+  xine_player_t *x = player->priv;
+  xine_snapshot_t *s = NULL;
+  char *uri;
+  int i;
+
+  uri = xine_resource_get_uri (mrl);
+  if (!uri)
+    return NULL;
+
+  for (i = 0; i < SNAPSHOT_POOL; i++)
+  {
+    xine_snapshot_t *it = &x->snapshot[i];
+
+    if (it->uri && !strcmp (it->uri, uri))
+    {
+      s = it;
+      break;
+    }
+
+    if (!s || it->stamp < s->stamp)
+      s = it;
+  }
+
+  s->stamp = ++x->snapshot_stamp;
+
+  if (s->uri && !strcmp (s->uri, uri))
+  {
+    PFREE (uri);
+    return s;
+  }
+
+  if (!x->snapshot_vo)
+    x->snapshot_vo =
+      xine_open_video_driver (x->xine, "none", XINE_VISUAL_TYPE_NONE, NULL);
+  if (!x->snapshot_ao)
+    x->snapshot_ao = xine_open_audio_driver (x->xine, "none", NULL);
+  if (!x->snapshot_vo || !x->snapshot_ao)
+    goto err;
+
+  if (!s->stream)
+  {
+    s->stream = xine_stream_new (x->xine, x->snapshot_ao, x->snapshot_vo);
+    if (!s->stream)
+      goto err;
+
+    xine_set_param (s->stream, XINE_PARAM_IGNORE_AUDIO, 1);
+    xine_set_param (s->stream, XINE_PARAM_IGNORE_SPU, 1);
+  }
+  else
+    xine_close (s->stream);
+
+  PFREE (s->uri);
+
+  if (!xine_open (s->stream, uri))
+  {
+    pl_log (player, PLAYER_MSG_WARNING,
+            MODULE_NAME, "unable to open %s for the snapshot", uri);
+    goto err;
+  }
+
+  s->uri = uri;
+  return s;
+
+ err:
   PFREE (uri);
+  return NULL;
+}
+
+static inline uint8_t
+xine_snapshot_clip (int v)
+{
+  return v < 0 ? 0 : v > 255 ? 255 : v;
+}
+
+/* ITU-R BT.601, studio swing */
+static inline void
+xine_snapshot_yuv2rgb (uint8_t *rgb, int y, int u, int v)
+{
+  y = 298 * (y - 16);
+  u -= 128;
+  v -= 128;
+
+  rgb[0] = xine_snapshot_clip ((y + 409 * v + 128) >> 8);
+  rgb[1] = xine_snapshot_clip ((y - 100 * u - 208 * v + 128) >> 8);
+  rgb[2] = xine_snapshot_clip ((y + 516 * u + 128) >> 8);
+}
+
+static int
+xine_snapshot_to_rgb (const uint8_t *img, int width, int height, int format,
+                      uint8_t *rgb)
+{
+  int i, j;
+
+  switch (format)
+  {
+  case XINE_IMGFMT_YV12:
+  {
+    const uint8_t *py = img;
+    const uint8_t *pu = py + width * height;
+    const uint8_t *pv = pu + ((width + 1) / 2) * ((height + 1) / 2);
+
+    for (j = 0; j < height; j++)
+      for (i = 0; i < width; i++)
+      {
+        int c = (j / 2) * ((width + 1) / 2) + i / 2;
+        xine_snapshot_yuv2rgb (rgb + (j * width + i) * 3,
+                               py[j * width + i], pu[c], pv[c]);
+      }
+    return 0;
+  }
+
+  case XINE_IMGFMT_YUY2:
+    for (j = 0; j < height; j++)
+      for (i = 0; i < width; i++)
+      {
+        const uint8_t *p = img + j * width * 2 + (i & ~1) * 2;
+        xine_snapshot_yuv2rgb (rgb + (j * width + i) * 3,
+                               p[(i & 1) * 2], p[1], p[3]);
+      }
+    return 0;
+
+  default:
+    return -1;
+  }
+}
+
+/* RGB 24 bits frame at the position (second) */
+static uint8_t *
+xine_snapshot_frame (player_t *player, mrl_t *mrl, int pos,
+                     int *width, int *height)
+{
+  xine_snapshot_t *s;
+  uint8_t *img = NULL, *rgb = NULL;
+  int before = -1, time_pos = -1;
+  int ratio, format;
+  int i;
+
+  s = xine_snapshot_get (player, mrl);
+  if (!s)
+    return NULL;
+
+  xine_get_pos_length (s->stream, NULL, &before, NULL);
+
+  xine_set_param (s->stream, XINE_PARAM_SPEED, XINE_SPEED_NORMAL);
+  if (!xine_play (s->stream, 0, pos * 1000))
+    goto err;
+
+  /* wait for the first frame displayed after the seek */
+  for (i = 0; i < SNAPSHOT_TIMEOUT / 10; i++)
+  {
+    if (xine_get_pos_length (s->stream, NULL, &time_pos, NULL)
+        && time_pos != before)
+      break;
+    usleep (10000);
+  }
+
+  xine_set_param (s->stream, XINE_PARAM_SPEED, XINE_SPEED_PAUSE);
+
+  if (time_pos == before
+      || !xine_get_current_frame (s->stream, width, height,
+                                  &ratio, &format, NULL)
+      || *width <= 0 || *height <= 0)
+    goto err;
+
+  /* YUY2 is the biggest format */
+  img = malloc (*width * *height * 2);
+  rgb = malloc (*width * *height * 3);
+  if (!img || !rgb)
+    goto err;
+
+  if (!xine_get_current_frame (s->stream, width, height,
+                               &ratio, &format, img)
+      || xine_snapshot_to_rgb (img, *width, *height, format, rgb))
+    goto err;
+
+  PFREE (img);
+  return rgb;
+
+ err:
+  pl_log (player, PLAYER_MSG_WARNING, MODULE_NAME,
+          "frame at %is is unavailable, maybe xine can't seek in %s",
+          pos, s->uri);
+  xine_close (s->stream);
+  PFREE (s->uri);
+  PFREE (img);
+  PFREE (rgb);
+  return NULL;
+}
+
+/*
+ * Decoded frames of the raw visual (PLAYER_VO_FRAMES). The frames of xine
+ * are reused after the callback, then they are copied in the frame ring.
+ * The pitches are the ones of the raw video output driver.
+ */
+static void
+xine_frame_cb (void *data, int format, int width, int height,
+               pl_unused double aspect, void *data0, void *data1, void *data2)
+{
+  player_t *player = data;
+  player_frame_t *frame;
+  const uint8_t *src[3] = { data0, data1, data2 };
+  int pitch[3] = { 0 };
+  int i, y, lines;
+
+  switch (format)
+  {
+  case XINE_VORAW_YV12: /* Y, U then V */
+    frame = pl_frame_ring_acquire (player->frames,
+                                   PLAYER_FRAME_I420, width, height);
+    pitch[0] = 8 * ((width + 7) / 8);
+    pitch[1] = 8 * ((width + 15) / 16);
+    pitch[2] = pitch[1];
+    break;
+
+  case XINE_VORAW_YUY2:
+    frame = pl_frame_ring_acquire (player->frames,
+                                   PLAYER_FRAME_YUY2, width, height);
+    pitch[0] = 8 * ((width + 3) / 4);
+    break;
+
+  default:
+    return;
+  }
+
+  if (!frame)
+    return;
+
+  for (i = 0; i < 3 && frame->plane[i]; i++)
+  {
+    lines = i ? (height + 1) / 2 : height;
+    for (y = 0; y < lines; y++)
+      memcpy (frame->plane[i] + y * frame->stride[i],
+              src[i] + y * pitch[i], frame->stride[i]);
+  }
+
+  pl_frame_ring_publish (player->frames, frame);
+}
+
+static void
+xine_frame_overlay_cb (pl_unused void *data, pl_unused int num_ovl,
+                       pl_unused raw_overlay_t *overlays_array)
+{
+  /* the OSD and the subtitles are not blended in the frames */
 }
 
 /*****************************************************************************/
@@ -608,6 +1041,16 @@ xine_player_init (player_t *player)
     visual = XINE_VISUAL_TYPE_FB;
     break;
 
+  case PLAYER_VO_FRAMES:
+    id_vo = "raw";
+    visual = XINE_VISUAL_TYPE_RAW;
+    x->raw_visual.user_data         = player;
+    x->raw_visual.supported_formats = XINE_VORAW_YV12 | XINE_VORAW_YUY2;
+    x->raw_visual.raw_output_cb     = xine_frame_cb;
+    x->raw_visual.raw_overlay_cb    = xine_frame_overlay_cb;
+    data = &x->raw_visual;
+    break;
+
   case PLAYER_VO_AUTO:
     use_x11 = 1;
     break;
@@ -699,6 +1142,14 @@ xine_player_init (player_t *player)
   }
 
   x->stream = xine_stream_new (x->xine, x->ao_port, x->vo_port);
+  if (player->audio_only)
+    xine_set_param (x->stream, XINE_PARAM_IGNORE_VIDEO, 1);
+
+  /* the identification streams are ready before the first MRL */
+  xine_probe_open (x);
+  if (!x->probe[0].stream)
+    pl_log (player, PLAYER_MSG_WARNING,
+            MODULE_NAME, "unable to create the identification streams");
 
   x->event_queue = xine_event_new_queue (x->stream);
   xine_event_create_listener_thread (x->event_queue,
@@ -727,6 +1178,10 @@ xine_player_uninit (player_t *player)
   if (!x)
     return;
 
+  xine_player_standby_close (x);
+  xine_snapshot_close (x);
+  xine_probe_close (x);
+
   if (x->stream)
   {
     xine_close (x->stream);
@@ -746,6 +1201,7 @@ xine_player_uninit (player_t *player)
 
   pl_window_uninit (player->window);
 
+  pthread_mutex_destroy (&x->mutex_probe);
   PFREE (x);
 }
 
@@ -784,6 +1240,46 @@ xine_player_set_verbosity (player_t *player, player_verbosity_level_t level)
     xine_engine_set_param (x->xine, XINE_ENGINE_PARAM_VERBOSITY, verbosity);
 }
 
+static int
+xine_player_mrl_flags (mrl_t *mrl)
+{
+  int flags = 0;
+
+  if (mrl->prop)
+  {
+    flags |= IDENTIFY_AUDIO | IDENTIFY_VIDEO | IDENTIFY_PROPERTIES;
+
+    if (mrl->resource == MRL_RESOURCE_FILE)
+    {
+      mrl_resource_local_args_t *args = mrl->priv;
+      if (args && args->location)
+      {
+        const char *location = args->location;
+
+        if (strstr (location, "file:") == location)
+          location += 5;
+
+        mrl->prop->size = pl_file_size (location);
+      }
+    }
+  }
+
+  if (mrl->meta)
+    flags |= IDENTIFY_METADATA;
+
+  return flags;
+}
+
+/*
+ * The properties and the metadata are retrieved with the same stream,
+ * in order to avoid opening twice the same resource.
+ */
+static void
+xine_player_mrl_retrieve (player_t *player, mrl_t *mrl)
+{
+  xine_identify (player, mrl, xine_player_mrl_flags (mrl));
+}
+
 static void
 xine_player_mrl_retrieve_properties (player_t *player, mrl_t *mrl)
 {
@@ -792,34 +1288,134 @@ xine_player_mrl_retrieve_properties (player_t *player, mrl_t *mrl)
   if (!player || !mrl || !mrl->prop)
     return;
 
-  /* now fetch properties */
-  if (mrl->resource == MRL_RESOURCE_FILE)
+  xine_player_mrl_retrieve (player, mrl);
+}
+
+static void
+xine_player_mrl_retrieve_metadata (player_t *player, mrl_t *mrl)
+{
+  pl_log (player, PLAYER_MSG_VERBOSE, MODULE_NAME, "mrl_retrieve_metadata");
+
+  if (!player || !mrl || !mrl->meta)
+    return;
+
+  xine_player_mrl_retrieve (player, mrl);
+}
+
+/*
+ * The stream used for the playback is already opened with the MRL, no need
+ * to open a new one.
+ */
+static int
+xine_player_mrl_retrieve_live (player_t *player, mrl_t *mrl)
+{
+  xine_player_t *x;
+
+  pl_log (player, PLAYER_MSG_VERBOSE, MODULE_NAME, "mrl_retrieve_live");
+
+  if (!player || !mrl)
+    return 0;
+
+  x = player->priv;
+
+  if (!x || !x->stream || x->live_mrl != mrl)
+    return 0;
+
+  xine_identify_stream (mrl, x->stream, xine_player_mrl_flags (mrl));
+  return 1;
+}
+
+static int
+xine_player_mrl_video_snapshot_buffer (player_t *player, mrl_t *mrl, int pos,
+                                       mrl_snapshot_t t,
+                                       mrl_snapshot_buffer_t *buf)
+{
+  uint8_t *rgb;
+  int width, height;
+
+  pl_log (player, PLAYER_MSG_VERBOSE,
+          MODULE_NAME, "mrl_video_snapshot_buffer");
+
+  if (!player || !mrl || !buf)
+    return 0;
+
+  /* no image encoder with xine */
+  if (t != MRL_SNAPSHOT_RGB24 && t != MRL_SNAPSHOT_PPM)
   {
-    mrl_resource_local_args_t *args = mrl->priv;
-    if (args && args->location)
-    {
-      const char *location = args->location;
+    pl_log (player, PLAYER_MSG_WARNING,
+            MODULE_NAME, "unsupported snapshot type (%i)", t);
+    return 0;
+  }
+
+  rgb = xine_snapshot_frame (player, mrl, pos, &width, &height);
+  if (!rgb)
+    return 0;
 
-      if (strstr (location, "file:") == location)
-        location += 5;
+  if (t == MRL_SNAPSHOT_PPM)
+  {
+    char header[32];
+    size_t size;
 
-      mrl->prop->size = pl_file_size (location);
+    size = snprintf (header, sizeof (header), "P6\n%i %i\n255\n",
+                     width, height);
+    buf->data = malloc (size + width * height * 3);
+    if (!buf->data)
+    {
+      PFREE (rgb);
+      return 0;
     }
+
+    memcpy (buf->data, header, size);
+    memcpy (buf->data + size, rgb, width * height * 3);
+    buf->size = size + width * height * 3;
+    PFREE (rgb);
+  }
+  else
+  {
+    buf->data   = rgb;
+    buf->size   = width * height * 3;
+    buf->width  = width;
+    buf->height = height;
+    buf->stride = width * 3;
   }
 
-  xine_identify (player, mrl,
-                 IDENTIFY_AUDIO | IDENTIFY_VIDEO | IDENTIFY_PROPERTIES);
+  buf->type = t;
+  return 1;
 }
 
 static void
-xine_player_mrl_retrieve_metadata (player_t *player, mrl_t *mrl)
+xine_player_mrl_video_snapshot (player_t *player, mrl_t *mrl,
+                                int pos, mrl_snapshot_t t, const char *dst)
 {
-  pl_log (player, PLAYER_MSG_VERBOSE, MODULE_NAME, "mrl_retrieve_metadata");
+  mrl_snapshot_buffer_t buf;
 
-  if (!player || !mrl || !mrl->meta)
+  pl_log (player, PLAYER_MSG_VERBOSE, MODULE_NAME, "mrl_video_snapshot");
+
+  if (!player || !mrl)
+    return;
+
+  if (t != MRL_SNAPSHOT_PPM)
+  {
+    pl_log (player, PLAYER_MSG_WARNING,
+            MODULE_NAME, "unsupported snapshot type (%i)", t);
+    return;
+  }
+
+  memset (&buf, 0, sizeof (buf));
+  if (!xine_player_mrl_video_snapshot_buffer (player, mrl, pos, t, &buf))
     return;
 
-  xine_identify (player, mrl, IDENTIFY_METADATA);
+  /* use the current directory? */
+  if (!dst)
+    dst = "snapshot.ppm";
+
+  if (!pl_write_file (dst, buf.data, buf.size))
+    pl_log (player, PLAYER_MSG_INFO, MODULE_NAME, "snapshot saved to %s", dst);
+  else
+    pl_log (player, PLAYER_MSG_ERROR,
+            MODULE_NAME, "unable to write the snapshot to %s", dst);
+
+  PFREE (buf.data);
 }
 
 static int
@@ -912,28 +1508,15 @@ xine_player_set_mouse_pos (player_t *player, int x, int y)
   send_event (player, XINE_EVENT_INPUT_MOUSE_MOVE, &input, sizeof (input));
 }
 
-static playback_status_t
-xine_player_playback_start (player_t *player)
+static char *
+xine_player_mrl_get (player_t *player, mrl_t *mrl_c)
 {
   char *mrl = NULL;
-  xine_player_t *x = NULL;
   char *uri = NULL;
-  mrl_t *mrl_c;
-
-  pl_log (player, PLAYER_MSG_VERBOSE, MODULE_NAME, "playback_start");
-
-  if (!player)
-    return PLAYER_PB_FATAL;
-
-  x = player->priv;
-
-  mrl_c = pl_playlist_get_mrl (player->playlist);
-  if (!x->stream || !mrl_c)
-    return PLAYER_PB_ERROR;
 
   uri = xine_resource_get_uri (mrl_c);
   if (!uri)
-    return PLAYER_PB_ERROR;
+    return NULL;
 
   pl_log (player, PLAYER_MSG_INFO, MODULE_NAME, "uri: %s", uri);
 
@@ -951,18 +1534,82 @@ xine_player_playback_start (player_t *player)
     mrl = strdup (uri);
 
   PFREE (uri);
+  return mrl;
+}
+
+/* the standby stream becomes the current one */
+static void
+xine_player_standby_swap (player_t *player)
+{
+  xine_player_t *x = player->priv;
+  xine_stream_t *stream;
+  xine_event_queue_t *queue;
+  mrl_t *mrl_c;
+
+  stream = x->stream;
+  queue  = x->event_queue;
+  mrl_c  = x->standby_mrl;
+
+  x->stream      = x->standby;
+  x->event_queue = x->standby_queue;
+  x->live_mrl    = mrl_c;
 
+  x->standby       = stream;
+  x->standby_queue = queue;
+  xine_player_standby_close (x);
+
+  mrl_retrieve_deferred (player, mrl_c);
+}
+
+static playback_status_t
+xine_player_playback_start (player_t *player)
+{
+  char *mrl = NULL;
+  xine_player_t *x = NULL;
+  mrl_t *mrl_c;
+
+  pl_log (player, PLAYER_MSG_VERBOSE, MODULE_NAME, "playback_start");
+
+  if (!player)
+    return PLAYER_PB_FATAL;
+
+  x = player->priv;
+
+  mrl_c = pl_playlist_get_mrl (player->playlist);
+  if (!x->stream || !mrl_c)
+    return PLAYER_PB_ERROR;
+
+  /* already opened by xine_player_playback_prepare() */
+  if (x->standby && x->standby_mrl == mrl_c)
+  {
+    xine_player_standby_swap (player);
+
+    if (MRL_USES_VO (mrl_c))
+      pl_window_map (player->window);
+
+    xine_play (x->stream, 0, 0);
+    return PLAYER_PB_OK;
+  }
+
+  xine_player_standby_close (x);
+
+  mrl = xine_player_mrl_get (player, mrl_c);
   if (!mrl)
     return PLAYER_PB_ERROR;
 
+  if (xine_open (x->stream, mrl))
+  {
+    x->live_mrl = mrl_c;
+    mrl_retrieve_deferred (player, mrl_c);
+  }
+
+  PFREE (mrl);
+
   if (MRL_USES_VO (mrl_c))
     pl_window_map (player->window);
 
-  xine_open (x->stream, mrl);
   xine_play (x->stream, 0, 0);
 
-  PFREE (mrl);
-
   return PLAYER_PB_OK;
 }
 
@@ -988,6 +1635,99 @@ xine_player_playback_stop (player_t *player)
 
   xine_stop (x->stream);
   xine_close (x->stream);
+  x->live_mrl = NULL;
+}
+
+/*
+ * The next MRL is opened (input, demuxer and headers) in a standby stream
+ * on the same ports. At the end of the current stream, only xine_play() is
+ * necessary, see xine_player_playback_gapless().
+ */
+static void
+xine_player_playback_preload (player_t *player, mrl_t *mrl_c)
+{
+  xine_player_t *x = NULL;
+  char *mrl;
+
+  pl_log (player, PLAYER_MSG_VERBOSE, MODULE_NAME, "playback_preload");
+
+  if (!player || !mrl_c)
+    return;
+
+  x = player->priv;
+
+  if (x->standby_mrl == mrl_c)
+    return;
+
+  xine_player_standby_close (x);
+
+  mrl = xine_player_mrl_get (player, mrl_c);
+  if (!mrl)
+    return;
+
+  x->standby = xine_stream_new (x->xine, x->ao_port, x->vo_port);
+  if (x->standby && player->audio_only)
+    xine_set_param (x->standby, XINE_PARAM_IGNORE_VIDEO, 1);
+  if (x->standby && xine_open (x->standby, mrl))
+  {
+    x->standby_mrl = mrl_c;
+    x->standby_queue = xine_event_new_queue (x->standby);
+    xine_event_create_listener_thread (x->standby_queue,
+                                       xine_player_event_listener_cb, player);
+  }
+  else
+    xine_player_standby_close (x);
+
+  PFREE (mrl);
+}
+
+/*
+ * Same standby stream as the preload. It can't be paused on the first
+ * frame without taking the ports of the current stream, it is only opened.
+ */
+static playback_status_t
+xine_player_playback_prepare (player_t *player, mrl_t *mrl_c)
+{
+  xine_player_t *x = NULL;
+
+  pl_log (player, PLAYER_MSG_VERBOSE, MODULE_NAME, "playback_prepare");
+
+  if (!player || !mrl_c)
+    return PLAYER_PB_FATAL;
+
+  x = player->priv;
+
+  xine_player_playback_preload (player, mrl_c);
+
+  return x->standby_mrl == mrl_c ? PLAYER_PB_OK : PLAYER_PB_ERROR;
+}
+
+static playback_status_t
+xine_player_playback_gapless (player_t *player, mrl_t *mrl_c)
+{
+  xine_player_t *x = NULL;
+
+  pl_log (player, PLAYER_MSG_VERBOSE, MODULE_NAME, "playback_gapless");
+
+  if (!player)
+    return PLAYER_PB_FATAL;
+
+  x = player->priv;
+
+  if (!x->standby || !mrl_c || x->standby_mrl != mrl_c
+      || !xine_play (x->standby, 0, 0))
+  {
+    xine_player_standby_close (x);
+    pl_window_unmap (player->window);
+    return PLAYER_PB_ERROR;
+  }
+
+  xine_player_standby_swap (player);
+
+  if (MRL_USES_VO (mrl_c))
+    pl_window_map (player->window);
+
+  return PLAYER_PB_OK;
 }
 
 static playback_status_t
@@ -1401,7 +2141,10 @@ pl_register_functions_xine (void)
 
   funcs->mrl_retrieve_props = xine_player_mrl_retrieve_properties;
   funcs->mrl_retrieve_meta  = xine_player_mrl_retrieve_metadata;
-  funcs->mrl_video_snapshot = NULL;
+  funcs->mrl_retrieve_live  = xine_player_mrl_retrieve_live;
+  funcs->mrl_video_snapshot = xine_player_mrl_video_snapshot;
+  funcs->mrl_video_snapshot_buffer = xine_player_mrl_video_snapshot_buffer;
+  funcs->mrl_video_snapshot_batch = NULL;
 
   funcs->get_time_pos       = xine_player_get_time_pos;
   funcs->get_percent_pos    = xine_player_get_percent_pos;
@@ -1416,6 +2159,9 @@ pl_register_functions_xine (void)
   funcs->pb_seek            = xine_player_playback_seek;
   funcs->pb_seek_chapter    = NULL;
   funcs->pb_set_speed       = xine_player_playback_set_speed;
+  funcs->pb_preload         = xine_player_playback_preload;
+  funcs->pb_gapless         = xine_player_playback_gapless;
+  funcs->pb_prepare         = xine_player_playback_prepare;
 
   funcs->audio_get_volume   = xine_player_audio_get_volume;
   funcs->audio_set_volume   = xine_player_audio_set_volume;
@@ -1469,5 +2215,7 @@ pl_register_private_xine (void)
   if (!x)
     return NULL;
 
+  pthread_mutex_init (&x->mutex_probe, NULL);
+
   return x;
 }